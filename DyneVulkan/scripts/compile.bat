@@ -2,12 +2,29 @@
 
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\shader.vert -o ..\..\x64\MTDebug\shaders\shader.vert.spv
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\shader.frag -o ..\..\x64\MTDebug\shaders\shader.frag.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe -DFIXED_TEXTURE_ARRAY ..\shaders\shader.frag -o ..\..\x64\MTDebug\shaders\shader_fixed_textures.frag.spv
 
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\shader.vert -o ..\shaders\shader.vert.spv
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\shader.frag -o ..\shaders\shader.frag.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe -DFIXED_TEXTURE_ARRAY ..\shaders\shader.frag -o ..\shaders\shader_fixed_textures.frag.spv
+
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\shader_packed.vert -o ..\..\x64\MTDebug\shaders\shader_packed.vert.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe -DHAS_COLOR ..\shaders\shader_packed.vert -o ..\..\x64\MTDebug\shaders\shader_packed_color.vert.spv
+
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\shader_packed.vert -o ..\shaders\shader_packed.vert.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe -DHAS_COLOR ..\shaders\shader_packed.vert -o ..\shaders\shader_packed_color.vert.spv
 
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\pointlight.vert -o ..\..\x64\MTDebug\shaders\pointlight.vert.spv
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\pointlight.frag -o ..\..\x64\MTDebug\shaders\pointlight.frag.spv
 
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\pointlight.vert -o ..\shaders\pointlight.vert.spv
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\pointlight.frag -o ..\shaders\pointlight.frag.spv
+
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\cull.comp -o ..\..\x64\MTDebug\shaders\cull.comp.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\cull.comp -o ..\shaders\cull.comp.spv
+
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\cluster.comp -o ..\..\x64\MTDebug\shaders\cluster.comp.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\cluster.comp -o ..\shaders\cluster.comp.spv
+
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\meshlet_cull.comp -o ..\..\x64\MTDebug\shaders\meshlet_cull.comp.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe ..\shaders\meshlet_cull.comp -o ..\shaders\meshlet_cull.comp.spv
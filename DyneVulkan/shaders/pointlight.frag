@@ -1,31 +1,19 @@
 #version 450
 
 layout(location = 0) in vec2 fragOffset;
+layout(location = 1) flat in vec3 fragColor;
 layout(location = 0) out vec4 outColor;
 
-struct PointLight
-{
-	vec4 position;
-	vec4 color;
-};
-
 layout(set = 0, binding = 0) uniform GlobalUbo
 {
 	vec4 camerapos;
 	mat4 projection;
 	mat4 view;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
-	int numLights;
+	vec4 clusterParams; //xy = tile size in pixels, z = depth slice scale, w = depth slice bias
+	uvec4 clusterGrid; //xyz = cluster counts, w = light count
 } ubo;
 
-layout(push_constant) uniform Push
-{
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
-
 void main()
 {
 	float dis = sqrt(dot(fragOffset, fragOffset));
@@ -33,5 +21,5 @@ void main()
 	{
 		discard;
 	}
-	outColor = vec4(push.color.xyz, 1.0);
+	outColor = vec4(fragColor, 1.0);
 }
\ No newline at end of file
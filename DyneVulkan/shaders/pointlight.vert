@@ -10,11 +10,12 @@ const vec2 OFFSETS[6] = vec2[](
 );
 
 layout(location = 0) out vec2 fragOffset;
+layout(location = 1) flat out vec3 fragColor;
 
 struct PointLight
 {
-	vec4 position;
-	vec4 color;
+	vec4 position; //w = range
+	vec4 color; //rgb premultiplied by intensity, w = billboard radius
 };
 
 layout(set = 0, binding = 0) uniform GlobalUbo
@@ -23,26 +24,29 @@ layout(set = 0, binding = 0) uniform GlobalUbo
 	mat4 projection;
 	mat4 view;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
-	int numLights;
+	vec4 clusterParams; //xy = tile size in pixels, z = depth slice scale, w = depth slice bias
+	uvec4 clusterGrid; //xyz = cluster counts, w = light count
 } ubo;
 
-layout(push_constant) uniform Push
+layout(std430, set = 0, binding = 2) readonly buffer LightBuffer
 {
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
+	PointLight lights[];
+} lightBuffer;
 
 void main()
 {
+	PointLight light = lightBuffer.lights[gl_InstanceIndex];
+	float radius = light.color.w;
+
+	//Intensity is folded into the color, the billboard shows its hue at full brightness
 	fragOffset = OFFSETS[gl_VertexIndex];
+	fragColor = light.color.xyz / max(max(light.color.x, max(light.color.y, light.color.z)), 0.0001);
 	vec3 cameraRightWorld = { ubo.view[0][0], ubo.view[1][0], ubo.view[2][0] };
 	vec3 cameraUpWorld = { ubo.view[0][1], ubo.view[1][1], ubo.view[2][1] };
 
-	vec3 positionWorld = push.position.xyz 
-		+ push.radius * fragOffset.x * cameraRightWorld
-		+ push.radius * fragOffset.y * cameraUpWorld;
+	vec3 positionWorld = light.position.xyz 
+		+ radius * fragOffset.x * cameraRightWorld
+		+ radius * fragOffset.y * cameraUpWorld;
 
 	gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
 }
\ No newline at end of file
@@ -1,16 +1,22 @@
 #version 450
 
+//Samples the texture registry's table, compiled with -DFIXED_TEXTURE_ARRAY for devices without descriptor indexing
+#ifndef FIXED_TEXTURE_ARRAY
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
 layout(location = 2) in vec3 fragNormalWorld;
 layout(location = 3) in vec2 fragUv;
+layout(location = 4) flat in uint fragTextureIndex;
 
 layout(location = 0) out vec4 outColor;
 
 struct PointLight
 {
-	vec4 position;
-	vec4 color;
+	vec4 position; //w = range
+	vec4 color; //rgb premultiplied by intensity, w = billboard radius
 };
 
 layout(set = 0, binding = 0) uniform GlobalUbo
@@ -19,43 +25,78 @@ layout(set = 0, binding = 0) uniform GlobalUbo
 	mat4 projection;
 	mat4 view;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
-	int numLights;
+	vec4 clusterParams; //xy = tile size in pixels, z = depth slice scale, w = depth slice bias
+	uvec4 clusterGrid; //xyz = cluster counts, w = light count
 } ubo;
 
-layout(binding = 1) uniform sampler2D texSampler;
+layout(std430, set = 0, binding = 2) readonly buffer LightBuffer
+{
+	PointLight lights[];
+} lightBuffer;
+
+#ifdef FIXED_TEXTURE_ARRAY
+//DyneTextureRegistry::FIXED_TEXTURE_CAPACITY, the index has to be the same across a draw
+layout(set = 2, binding = 0) uniform sampler2D textures[16];
+#define TEXTURE(index) textures[index]
+#else
+//Partially bound, only slots handed out by the registry are ever indexed
+layout(set = 2, binding = 0) uniform sampler2D textures[];
+#define TEXTURE(index) textures[nonuniformEXT(index)]
+#endif
+
+//x = offset into the light index list, y = light count
+layout(std430, set = 0, binding = 3) readonly buffer ClusterBuffer
+{
+	uvec2 clusters[];
+} clusterBuffer;
 
-layout(push_constant) uniform Push 
+layout(std430, set = 0, binding = 4) readonly buffer LightIndexBuffer
 {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
+	uint indices[];
+} lightIndexBuffer;
+
+uint clusterIndex()
+{
+	float viewDepth = (ubo.view * vec4(fragPosWorld, 1.0)).z;
+	uvec2 tile = uvec2(gl_FragCoord.xy / ubo.clusterParams.xy);
+	int slice = int(floor(log(max(viewDepth, 0.0001)) * ubo.clusterParams.z + ubo.clusterParams.w));
+
+	uvec3 cluster = min(uvec3(tile, uint(max(slice, 0))), ubo.clusterGrid.xyz - 1);
+	return cluster.x + ubo.clusterGrid.x * (cluster.y + ubo.clusterGrid.y * cluster.z);
+}
 
 void main() 
 {
 	vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
 	vec3 surfaceNormal = normalize(fragNormalWorld);
 
-	for(int i = 0; i < ubo.numLights; i++)
+	vec3 viewDir = normalize(ubo.camerapos.xyz - fragPosWorld);
+
+	//Only the lights binned into this fragment's cluster can reach it
+	uvec2 cluster = clusterBuffer.clusters[clusterIndex()];
+	for(uint i = 0; i < cluster.y; i++)
 	{
 		//diffuse light
-		PointLight light = ubo.pointLights[i];
+		PointLight light = lightBuffer.lights[lightIndexBuffer.indices[cluster.x + i]];
 		vec3 directionToLight = light.position.xyz - fragPosWorld;
-		vec3 intensity = light.color.xyz * light.color.w;
+		vec3 intensity = light.color.xyz;
 
-		float attenuation = 1.0 / dot(directionToLight, directionToLight);
+		//Inverse square falloff windowed to reach zero at the light's range
+		float distanceSquared = dot(directionToLight, directionToLight);
+		float rangeRatio = distanceSquared / (light.position.w * light.position.w);
+		float window = clamp(1.0 - rangeRatio * rangeRatio, 0.0, 1.0);
+		float attenuation = window * window / (distanceSquared + 1.0);
 		float cosAngIncidence = max(dot(surfaceNormal, normalize(directionToLight)), 0);
 
 		diffuseLight += intensity * attenuation * cosAngIncidence;
 
 		//specular light
-		vec3 viewDir = normalize(ubo.camerapos.xyz - fragPosWorld);
 		vec3 reflectDir = reflect(normalize(-directionToLight), surfaceNormal);
 		float spec = pow(max(dot(viewDir, reflectDir), 0.0), 128);
-		vec3 specular = 0.5f * spec * intensity;
+		vec3 specular = 0.5f * spec * intensity * attenuation;
 
 		diffuseLight += specular;
 	}
 
-	outColor = texture(texSampler, fragUv) * vec4(diffuseLight * fragColor, 1.0);
+	outColor = texture(TEXTURE(fragTextureIndex), fragUv) * vec4(diffuseLight * fragColor, 1.0);
 }
\ No newline at end of file
@@ -9,12 +9,7 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragUv;
-
-struct PointLight
-{
-	vec4 position;
-	vec4 color;
-};
+layout(location = 4) flat out uint fragTextureIndex;
 
 layout(set = 0, binding = 0) uniform GlobalUbo
 {
@@ -22,25 +17,32 @@ layout(set = 0, binding = 0) uniform GlobalUbo
 	mat4 projection;
 	mat4 view;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
-	int numLights;
+	vec4 clusterParams; //xy = tile size in pixels, z = depth slice scale, w = depth slice bias
+	uvec4 clusterGrid; //xyz = cluster counts, w = light count
 } ubo;
 
-layout(binding = 1) uniform sampler2D texSampler;
-
-layout(push_constant) uniform Push 
+struct InstanceData
 {
 	mat4 modelMatrix;
 	mat4 normalMatrix;
-} push;
+	uvec4 material; //x = texture registry slot
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer
+{
+	InstanceData instances[];
+} instanceBuffer;
 
 void main() 
 {
-	vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+	InstanceData instance = instanceBuffer.instances[gl_InstanceIndex];
+
+	vec4 positionWorld = instance.modelMatrix * vec4(position, 1.0);
 	gl_Position = ubo.projection * ubo.view * positionWorld;
 
-	fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+	fragNormalWorld = normalize(mat3(instance.normalMatrix) * normal);
 	fragPosWorld = positionWorld.xyz;
 	fragColor = color;
 	fragUv = uv;
+	fragTextureIndex = instance.material.x;
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#version 450
+
+//Input for VertexFormat::Packed, compiled with -DHAS_COLOR for VertexFormat::PackedColor
+layout(location = 0) in vec4 position;
+#ifdef HAS_COLOR
+layout(location = 1) in vec4 color;
+#endif
+layout(location = 2) in vec2 octahedralNormal;
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUv;
+layout(location = 4) flat out uint fragTextureIndex;
+
+layout(set = 0, binding = 0) uniform GlobalUbo
+{
+	vec4 camerapos;
+	mat4 projection;
+	mat4 view;
+	vec4 ambientLightColor;
+	vec4 clusterParams; //xy = tile size in pixels, z = depth slice scale, w = depth slice bias
+	uvec4 clusterGrid; //xyz = cluster counts, w = light count
+} ubo;
+
+struct InstanceData
+{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	uvec4 material; //x = texture registry slot
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer
+{
+	InstanceData instances[];
+} instanceBuffer;
+
+//Inverse of encodeOctahedral in DyneModel.cpp
+vec3 decodeOctahedral(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (normal.z < 0.0)
+	{
+		normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(normal);
+}
+
+void main() 
+{
+	InstanceData instance = instanceBuffer.instances[gl_InstanceIndex];
+
+	vec4 positionWorld = instance.modelMatrix * vec4(position.xyz, 1.0);
+	gl_Position = ubo.projection * ubo.view * positionWorld;
+
+	fragNormalWorld = normalize(mat3(instance.normalMatrix) * decodeOctahedral(octahedralNormal));
+	fragPosWorld = positionWorld.xyz;
+#ifdef HAS_COLOR
+	fragColor = color.rgb;
+#else
+	fragColor = vec3(1.0);
+#endif
+	fragUv = uv;
+	fragTextureIndex = instance.material.x;
+}
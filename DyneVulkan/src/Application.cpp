@@ -7,8 +7,12 @@
 
 #include "Engine/InputHandler.hpp"
 #include "Engine/Systems/DefaultRenderSystem.hpp"
+#include "Engine/Systems/GpuDrivenRenderSystem.hpp"
 #include "Engine/Systems/PointLightSystem.hpp"
+#include "Engine/Systems/ClusteredLightingSystem.hpp"
+#include "Engine/Systems/CullingSystem.hpp"
 #include "Engine/Camera.hpp"
+#include "Engine/SceneBvh.hpp"
 
 #include <array>
 #include <chrono>
@@ -24,10 +28,20 @@ namespace Dyne
 		globalPool = DyneDescriptorPool::Builder(appDevice)
 			.setMaxSets(DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
 			.build();
 
+		//Flat white, sampled by untextured objects and in place of textures that are still streaming in
+		DyneTexture::createTextureSampler(appDevice, textureSampler);
+		const uint32_t whitePixel = 0xffffffff;
+		placeholderTexture = DyneTexture::createTextureFromPixels(appDevice, &whitePixel, 1, 1);
+		textureRegistry = std::make_unique<DyneTextureRegistry>(appDevice, textureSampler, placeholderTexture);
+		textureStreamingSystem = std::make_unique<TextureStreamingSystem>(assetStreamer, *textureRegistry, TEXTURE_STREAMING_BUDGET);
+
 		loadGameObjects();
+
+		//Placeholder uploads recorded while loading go out in one submission
+		appDevice.uploadContext().submit();
 	}
 
 	Application::~Application()
@@ -37,41 +51,64 @@ namespace Dyne
 	void Application::run()
 	{
 		allocateBuffers();
-		DyneTexture::createTextureSampler(appDevice, textureSampler);
-		auto tex = DyneTexture::createTextureFromFile(appDevice, "textures/viking_room.png");
+
+		#ifdef _DEBUG
+		appDevice.allocator().printStats();
+		#endif
 
 		auto globalSetLayout = DyneDescriptorSetLayout::Builder(appDevice)
 			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
 			.build();
 
+		//Owns the light & cluster buffers bound below
+		ClusteredLightingSystem clusteredLightingSystem(appDevice, pipelineCompiler);
+
 		std::vector<VkDescriptorSet> globalDescriptorSets(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
 		for (int i = 0; i < globalDescriptorSets.size(); i++)
 		{
 			auto uboBufferInfo = uboBuffers[i]->descriptorInfo();
-			
-			VkDescriptorImageInfo imageInfo{};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = tex->imageView();
-			imageInfo.sampler = textureSampler;
+			auto lightBufferInfo = clusteredLightingSystem.lightBufferInfo(i);
+			auto clusterBufferInfo = clusteredLightingSystem.clusterBufferInfo(i);
+			auto lightIndexBufferInfo = clusteredLightingSystem.lightIndexBufferInfo(i);
 
 			DyneDescriptorWriter(*globalSetLayout, *globalPool)
 				.writeBuffer(0, &uboBufferInfo)
-				.writeImage(1, &imageInfo)
+				.writeBuffer(2, &lightBufferInfo)
+				.writeBuffer(3, &clusterBufferInfo)
+				.writeBuffer(4, &lightIndexBufferInfo)
 				.build(globalDescriptorSets[i]);
 		}
 
-		DefaultRenderSystem defaultRenderSystem(appDevice, appRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
-		PointLightRenderSystem pointLightSystem(appDevice, appRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+		//Pipelines compile in parallel on the thread pool, systems skip drawing until theirs is ready
+		DefaultRenderSystem defaultRenderSystem(appDevice, pipelineCompiler, appRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(), *textureRegistry, geometryPool.getVertexFormat());
+		PointLightRenderSystem pointLightSystem(appDevice, pipelineCompiler, appRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+
+		//Large scenes are culled and submitted on the GPU when the device allows it
+		std::unique_ptr<GpuDrivenRenderSystem> gpuDrivenRenderSystem;
+		if (appDevice.supportsGpuDrivenRendering())
+		{
+			gpuDrivenRenderSystem = std::make_unique<GpuDrivenRenderSystem>(appDevice, pipelineCompiler, appRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(), *textureRegistry, geometryPool.getVertexFormat());
+		}
+
+		//Frustum culling for the default path, the GPU driven path culls on the GPU
+		CullingSystem cullingSystem(threadPool);
+		SceneBvh sceneBvh{};
 
 		Camera camera{};
-		GameObject cameraObject = GameObject::createGameObject();
-		cameraObject.transform.translation = glm::vec3{ 7.0f, -2.0f, 0.0f };
-		cameraObject.transform.rotation = glm::vec3{ 0.0f , glm::radians(-90.0f), 0.0f};
+		TransformComponent cameraTransform{};
+		cameraTransform.translation = glm::vec3{ 7.0f, -2.0f, 0.0f };
+		cameraTransform.rotation = glm::vec3{ 0.0f , glm::radians(-90.0f), 0.0f};
 		InputHandler cameraController{};
 		cameraController.setMouseEnabled(&app, true);
 
 		auto currentTime = std::chrono::high_resolution_clock::now();
+		#ifdef _DEBUG
+		VkDeviceSize reportedResidentBytes = 0;
+		VkDeviceSize reportedRequestedBytes = 0;
+		#endif
 
 		while (!app.shouldClose())
 		{
@@ -84,13 +121,66 @@ namespace Dyne
 			frameTime = glm::min(frameTime, 100.0f);
 
 			//Camera controller & view & projection matrix setup
-			cameraController.moveObjectInPlaneXZ(&app, 1.0f, cameraObject);
-			camera.setViewYXZ(cameraObject.transform.translation, cameraObject.transform.rotation);
+			cameraController.moveObjectInPlaneXZ(&app, 1.0f, cameraTransform);
+			camera.setViewYXZ(cameraTransform.translation, cameraTransform.rotation);
 			camera.setPerspectiveProjection(glm::radians(90.0f), appRenderer.getAspectRatio(), 0.1f, 100.0f);
+
+			//Streamed assets that finished uploading replace their placeholders
+			bool sceneChanged = assetStreamer.update() > 0;
+
+			//The lights follow their pivot through the hierarchy
+			auto& pivotTransform = registry.get<TransformComponent>(lightPivot);
+			pivotTransform.rotation.y = glm::mod(pivotTransform.rotation.y - frameTime, glm::two_pi<float>());
+			pivotTransform.dirty = true;
+
+			//Only moved objects get new matrices, cached bounds & the GPU driven scene are rebuilt when any did
+			sceneChanged |= transformSystem.update(registry) > 0;
+			if (sceneChanged)
+			{
+				cullingSystem.invalidate();
+				sceneBvh.invalidate();
+				if (gpuDrivenRenderSystem != nullptr) gpuDrivenRenderSystem->invalidate();
+			}
+
+			//Texture mips follow the objects' size on screen, swapped images reach the table on its next flush
+			textureStreamingSystem->update(registry, camera, static_cast<float>(appRenderer.getSwapChainExtent().height));
+
+			#ifdef _DEBUG
+			const TextureStreamingSystem::Stats& streamingStats = textureStreamingSystem->getStats();
+			if (streamingStats.residentBytes != reportedResidentBytes || streamingStats.requestedBytes != reportedRequestedBytes)
+			{
+				reportedResidentBytes = streamingStats.residentBytes;
+				reportedRequestedBytes = streamingStats.requestedBytes;
+				std::cout << "Textures: " << reportedResidentBytes / (1024 * 1024) << " MiB resident, "
+					<< reportedRequestedBytes / (1024 * 1024) << " MiB requested, "
+					<< streamingStats.budgetBytes / (1024 * 1024) << " MiB budget, "
+					<< streamingStats.degradedCount << " of " << streamingStats.textureCount << " degraded\n";
+			}
+			#endif
+
+			//Picking only needs the scene index when it happens, so it is brought up to date lazily
+			glm::vec2 pickCursor;
+			if (cameraController.pollPick(&app, pickCursor))
+			{
+				glm::vec3 rayOrigin, rayDirection;
+				camera.getRay(pickCursor, rayOrigin, rayDirection);
+
+				sceneBvh.update(registry);
+				SceneBvh::RayHit hit;
+				selectedEntity = sceneBvh.raycast(rayOrigin, rayDirection, camera.getFarClip(), hit) ? hit.entity : Entity{};
+
+				#ifdef _DEBUG
+				if (registry.isAlive(selectedEntity))
+				{
+					std::cout << "Picked entity " << hit.entity.index << " at distance " << hit.distance << "\n";
+				}
+				#endif
+			}
 			
 			if (auto commandBuffer = appRenderer.beginFrame())
 			{
 				int frameIndex = appRenderer.getFrameIndex();
+
 				FrameInfo frameInfo
 				{
 					frameIndex,
@@ -98,28 +188,61 @@ namespace Dyne
 					commandBuffer,
 					camera,
 					globalDescriptorSets[frameIndex],
-					gameObjects
+					//beginFrame waited for the frame that last used this copy of the table, so it can be rewritten now
+					textureRegistry->flush(frameIndex),
+					registry,
+					geometryPool,
+					appRenderer.getCommandRecorder()
 				};
 
 				//update
 				GlobalUbo ubo{};
-				ubo.camerapos = glm::vec4(cameraObject.transform.translation, 1.0f);
+				ubo.camerapos = glm::vec4(cameraTransform.translation, 1.0f);
 				ubo.projection = camera.getProjection();
 				ubo.view = camera.getView();
-				pointLightSystem.update(frameInfo, ubo);
+				clusteredLightingSystem.update(frameInfo, ubo, appRenderer.getSwapChainExtent());
 
 				uboBuffers[frameIndex]->writeToBuffer(&ubo);
 				uboBuffers[frameIndex]->flush();
 
-				//render
-				appRenderer.beginSwapChainRenderPass(commandBuffer);
-				defaultRenderSystem.renderGameObjects(frameInfo);
-				pointLightSystem.render(frameInfo);
+				//light binning & culling have to be recorded outside the render pass, the default system stands in while the GPU driven pipelines compile
+				clusteredLightingSystem.buildClusters(frameInfo);
+
+				bool gpuDriven = gpuDrivenRenderSystem != nullptr && 
+					registry.count<ModelComponent>() >= GPU_DRIVEN_OBJECT_THRESHOLD && 
+					gpuDrivenRenderSystem->isReady();
+				if (gpuDriven)
+				{
+					gpuDrivenRenderSystem->cull(frameInfo, appRenderer.getSwapChainExtent());
+				}
+
+				//render, the pass is recorded into secondary buffers spread over the thread pool
+				auto& commandRecorder = appRenderer.getCommandRecorder();
+				appRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				if (gpuDriven)
+				{
+					commandRecorder.recordSingle(commandBuffer, [&](VkCommandBuffer secondary)
+					{
+						FrameInfo secondaryInfo = frameInfo;
+						secondaryInfo.commandBuffer = secondary;
+						gpuDrivenRenderSystem->render(secondaryInfo);
+					});
+				}
+				else
+				{
+					defaultRenderSystem.renderGameObjects(frameInfo, cullingSystem.cull(registry, camera, static_cast<float>(appRenderer.getSwapChainExtent().height)));
+				}
+				commandRecorder.recordSingle(commandBuffer, [&](VkCommandBuffer secondary)
+				{
+					FrameInfo secondaryInfo = frameInfo;
+					secondaryInfo.commandBuffer = secondary;
+					pointLightSystem.render(secondaryInfo, clusteredLightingSystem.getLightCount());
+				});
 				appRenderer.endSwapChainRenderPass(commandBuffer);
 				appRenderer.endFrame();
 
-				//auto& trs = cameraObject.transform.translation;
-				//auto& rot = cameraObject.transform.rotation;
+				//auto& trs = cameraTransform.translation;
+				//auto& rot = cameraTransform.rotation;
 				//printf("Camera (XYZ) : %f, %f, %f | ", trs.x, trs.y, trs.z);
 				//printf("Rot (XYZ) : %f, %f, %f\n", rot.x, rot.y, rot.z);
 			}
@@ -131,6 +254,9 @@ namespace Dyne
 
 	void Application::cleanup()
 	{
+		//Holds the last references to the streamed textures
+		textureStreamingSystem.reset();
+		textureRegistry.reset();
 		vkDestroySampler(appDevice.device(), textureSampler, nullptr);
 	}
 
@@ -154,29 +280,53 @@ namespace Dyne
 		//Texture buffer allocation
 	}
 
+	void Application::requestModel(const std::string& filepath, std::vector<Entity> entities)
+	{
+		assetStreamer.requestModel(filepath, [this, entities](std::shared_ptr<DyneModel> model)
+		{
+			//Entities may have been destroyed while the model was loading
+			for (auto entity : entities)
+			{
+				if (auto* modelComponent = registry.tryGet<ModelComponent>(entity))
+				{
+					modelComponent->model = model;
+				}
+			}
+		});
+	}
+
+	void Application::requestTexture(const std::string& filepath, std::vector<Entity> entities)
+	{
+		//Replacing the slot's texture retextures every entity using it, nothing else has to change
+		uint32_t textureIndex = textureStreamingSystem->requestTexture(filepath);
+		for (auto entity : entities)
+		{
+			if (auto* modelComponent = registry.tryGet<ModelComponent>(entity))
+			{
+				modelComponent->textureIndex = textureIndex;
+			}
+		}
+	}
+
 	void Application::loadGameObjects()
 	{
-		std::shared_ptr<DyneModel> model = DyneModel::createModelFromFile(appDevice, "models/viking_room.obj");
-		std::shared_ptr<DyneModel> quadModel = DyneModel::createModelFromFile(appDevice, "models/quad.obj");
-
-		auto gameObj = GameObject::createGameObject();
-		gameObj.model = model;
-		gameObj.transform.translation = { -1.0f, 0.0f, 0.0f };
-		gameObj.transform.rotation = { glm::radians(90.0f), 0.0f, 0.0f };
-		gameObj.transform.scale = glm::vec3(5.0f);
-		gameObjects.emplace(gameObj.getID(), std::move(gameObj));
-
-		//auto gameObj2 = GameObject::createGameObject();
-		//gameObj2.model = model;
-		//gameObj2.transform.translation = { 1.0f, 0.0f, 0.0f };
-		//gameObj2.transform.scale = glm::vec3(5.0f);
-		//gameObjects.emplace(gameObj2.getID(), std::move(gameObj2));
-
-		//auto gameObj3 = GameObject::createGameObject();
-		//gameObj3.model = quadModel;
-		//gameObj3.transform.translation = { 0.0f, 0.5f, 0.0f };
-		//gameObj3.transform.scale = glm::vec3(5.0f);
-		//gameObjects.emplace(gameObj3.getID(), std::move(gameObj3));
+		//Small enough to load up front, everything else streams in behind it
+		placeholderModel = DyneModel::createModelFromFile(appDevice, geometryPool, "models/quad.obj");
+
+		Entity room = registry.create();
+		registry.add<ModelComponent>(room, placeholderModel);
+		auto& roomTransform = registry.add<TransformComponent>(room);
+		roomTransform.translation = { -1.0f, 0.0f, 0.0f };
+		roomTransform.rotation = { glm::radians(90.0f), 0.0f, 0.0f };
+		roomTransform.scale = glm::vec3(5.0f);
+		requestModel("models/viking_room.obj", { room });
+		requestTexture("textures/viking_room.png", { room });
+
+		//Entity quad = registry.create();
+		//registry.add<ModelComponent>(quad, placeholderModel);
+		//auto& quadTransform = registry.add<TransformComponent>(quad);
+		//quadTransform.translation = { 1.0f, 0.0f, 0.0f };
+		//quadTransform.scale = glm::vec3(5.0f);
 
 		std::vector<glm::vec3> lightColors
 		{
@@ -188,19 +338,20 @@ namespace Dyne
 			{1.f, 1.f, 1.f}
 		};
 
+		lightPivot = registry.create();
+		registry.add<TransformComponent>(lightPivot);
+
 		for (int i = 0; i < lightColors.size(); i++)
 		{
-			auto pointLight = GameObject::makePointLight(1.0f);
-			pointLight.color = lightColors[i];
+			Entity pointLight = createPointLight(registry, 1.0f, 0.1f, lightColors[i]);
+			transformSystem.setParent(registry, pointLight, lightPivot);
 			auto rotateLight = glm::rotate
 			(
 				glm::mat4(1.0f),
 				(i * glm::two_pi<float>()) / lightColors.size(),
 				{ 0.0f, -1.0f, 0.0f }
 			);
-			pointLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.0f, -0.5f, -1.0f, 1.0f));
-
-			gameObjects.emplace(pointLight.getID(), std::move(pointLight));
+			registry.get<TransformComponent>(pointLight).translation = glm::vec3(rotateLight * glm::vec4(-1.0f, -0.5f, -1.0f, 1.0f));
 		}
 	}
 }
\ No newline at end of file
@@ -5,8 +5,17 @@
 #include "VulkanBackend/DyneTexture.hpp"
 #include "VulkanBackend/DyneSwapchain.hpp"
 #include "VulkanBackend/DyneModel.hpp"
+#include "VulkanBackend/DyneGeometryPool.hpp"
+#include "VulkanBackend/DyneUploadContext.hpp"
 #include "VulkanBackend/DyneDescriptors.hpp"
-#include "Engine/GameObject.hpp"
+#include "VulkanBackend/DyneTextureRegistry.hpp"
+#include "VulkanBackend/DynePipelineCompiler.hpp"
+#include "Engine/Components.hpp"
+#include "Engine/EntityRegistry.hpp"
+#include "Engine/AssetStreamer.hpp"
+#include "Engine/Systems/TransformSystem.hpp"
+#include "Engine/Systems/TextureStreamingSystem.hpp"
+#include "Utility/DyneThreadPool.hpp"
 
 #include <iostream>
 #include <cstdlib>
@@ -24,6 +33,11 @@ namespace Dyne
         static constexpr int HEIGHT = 720;
         const std::string WNAME = "Editor";
 
+        //Object count from which rendering switches to GPU culling + indirect draws
+        static constexpr size_t GPU_DRIVEN_OBJECT_THRESHOLD = 4096;
+        //Memory streamed textures may take, tails included. Tails stay resident even when they alone exceed it
+        static constexpr VkDeviceSize TEXTURE_STREAMING_BUDGET = 256ull * 1024 * 1024;
+
         Application();
         ~Application();
 
@@ -35,17 +49,39 @@ namespace Dyne
     private:
         void allocateBuffers();
         void loadGameObjects();
+        //Entities keep their placeholder model until the file has streamed in
+        void requestModel(const std::string& filepath, std::vector<Entity> entities);
+        //Entities get a texture slot of their own right away, it shows the placeholder until the file's smallest mips have
+        //streamed in, the larger ones follow as far as the entities' size on screen & the budget allow
+        void requestTexture(const std::string& filepath, std::vector<Entity> entities);
         void cleanup();
 
         //Initialize window and the vulkan device
         WindowHandler app{ WIDTH, HEIGHT, WNAME };
         DyneDevice appDevice{ app };
-        DyneRenderer appRenderer{ app, appDevice };
+        DyneThreadPool threadPool{};
+        DyneRenderer appRenderer{ app, appDevice, threadPool };
+        // The scene's models carry no vertex colors, so VertexFormat::Packed cuts vertex memory to a third
+        DyneGeometryPool geometryPool{ appDevice, VertexFormat::Packed };
+        AssetStreamer assetStreamer{ appDevice, geometryPool, threadPool };
+        DynePipelineCompiler pipelineCompiler{ appDevice, threadPool };
+
+        //Drawn in place of assets that are still streaming in
+        std::shared_ptr<DyneModel> placeholderModel;
+        std::shared_ptr<DyneTexture> placeholderTexture;
 
         VkSampler textureSampler;
+        //Every texture the scene samples, objects refer to theirs by index
+        std::unique_ptr<DyneTextureRegistry> textureRegistry;
+        std::unique_ptr<TextureStreamingSystem> textureStreamingSystem;
         std::vector<std::unique_ptr<DyneBuffer>> uboBuffers;
         std::unique_ptr<DyneDescriptorPool> globalPool{};
-        GameObject::Map gameObjects;
+        EntityRegistry registry;
+        TransformSystem transformSystem{ threadPool };
+        //The point lights orbit the scene as children of this entity
+        Entity lightPivot{};
+        //Entity last clicked on, invalid when the click hit nothing
+        Entity selectedEntity{};
     };
 }
 
@@ -0,0 +1,274 @@
+#include "AssetStreamer.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace Dyne
+{
+	AssetStreamer::AssetStreamer(DyneDevice& device, DyneGeometryPool& geometryPool, DyneThreadPool& threadPool) :
+		_deviceRef(device),
+		_geometryPoolRef(geometryPool),
+		_threadPoolRef(threadPool),
+		transferContext(device, device.transferQueue(), device.transferQueueFamily())
+	{
+	}
+
+	AssetStreamer::~AssetStreamer()
+	{
+		//Workers push into parsed, and pending images may still be copied into
+		_threadPoolRef.waitIdle();
+		transferContext.wait(transferContext.submit());
+	}
+
+	void AssetStreamer::pushParsed(ParsedAsset asset)
+	{
+		std::lock_guard<std::mutex> lock(parsedMutex);
+		parsed.push_back(std::move(asset));
+	}
+
+	void AssetStreamer::requestModel(const std::string& filepath, ModelCallback onResident)
+	{
+		outstandingRequests++;
+		_threadPoolRef.submit([this, filepath, onResident]()
+		{
+			ParsedAsset asset{};
+			asset.onModelResident = onResident;
+			try
+			{
+				asset.model = std::make_unique<DyneModel::Builder>();
+				asset.model->loadModel(filepath);
+			}
+			catch (const std::exception& e)
+			{
+				asset.error = std::make_exception_ptr(std::runtime_error("failed to stream " + filepath + ": " + e.what()));
+			}
+			pushParsed(std::move(asset));
+		});
+	}
+
+	void AssetStreamer::requestTexture(const std::string& filepath, TextureCallback onResident, uint32_t maxExtent, FailureCallback onFailed)
+	{
+		outstandingRequests++;
+		_threadPoolRef.submit([this, filepath, onResident, maxExtent, onFailed]()
+		{
+			ParsedAsset asset{};
+			asset.onTextureResident = onResident;
+			asset.onFailed = onFailed;
+			try
+			{
+				asset.texture = std::make_unique<DyneTexture::Builder>();
+				//Only the header is read here, the pixels are decoded once staging memory is reserved for them
+				asset.texture->probe(_deviceRef, filepath);
+				asset.texture->limitExtent(maxExtent);
+			}
+			catch (const std::exception& e)
+			{
+				asset.error = std::make_exception_ptr(std::runtime_error("failed to stream " + filepath + ": " + e.what()));
+			}
+			pushParsed(std::move(asset));
+		});
+	}
+
+	uint32_t AssetStreamer::update()
+	{
+		uint32_t residentCount = publishCompleted();
+		//One batch is open at a time, the next is recorded once the workers filled the last
+		if (submitFilledUploads())
+		{
+			recordUploads();
+		}
+		return residentCount;
+	}
+
+	void AssetStreamer::recordUploads()
+	{
+		VkDeviceSize recordedBytes = 0;
+		std::exception_ptr error;
+
+		while (recordedBytes < UPLOAD_BUDGET_PER_FRAME)
+		{
+			ParsedAsset asset{};
+			{
+				std::lock_guard<std::mutex> lock(parsedMutex);
+				if (parsed.empty()) break;
+				//Model uploads submit the batch when the ring runs out, which must wait for the texture fills
+				if (parsed.front().model && outstandingFills > 0) break;
+
+				asset = std::move(parsed.front());
+				parsed.pop_front();
+			}
+
+			if (asset.error)
+			{
+				outstandingRequests--;
+				if (asset.onFailed)
+				{
+					asset.onFailed(asset.error);
+					continue;
+				}
+				error = asset.error;
+				break;
+			}
+
+			PendingAsset upload{};
+			if (asset.model)
+			{
+				upload.model = std::make_shared<DyneModel>(_deviceRef, _geometryPoolRef, transferContext, *asset.model);
+				recordedBytes += _geometryPoolRef.getVertexStride() * upload.model->getVertexCount() +
+					(upload.model->getIndexType() == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)) * upload.model->getMeshRange().indexCount;
+				upload.onModelResident = std::move(asset.onModelResident);
+			}
+			else
+			{
+				//The ring only frees up as earlier batches complete, the texture waits for a later update
+				DyneUploadContext::StagingRegion staging{};
+				VkDeviceSize size = asset.texture->uploadSize();
+				if (!transferContext.tryAllocateStaging(size, 16, staging))
+				{
+					std::lock_guard<std::mutex> lock(parsedMutex);
+					parsed.push_front(std::move(asset));
+					break;
+				}
+				recordedBytes += size;
+
+				std::shared_ptr<DyneTexture::Builder> builder = std::move(asset.texture);
+				builder->createTextureImage(_deviceRef, transferContext, _deviceRef.graphicsQueueFamily(), staging);
+				upload.texture = std::make_shared<DyneTexture>(_deviceRef, *builder);
+				upload.onTextureResident = std::move(asset.onTextureResident);
+				upload.onFailed = std::move(asset.onFailed);
+
+				outstandingFills++;
+				const DyneTexture* texture = upload.texture.get();
+				_threadPoolRef.submit([this, builder, staging, texture]()
+				{
+					try
+					{
+						builder->decodeInto(staging.data);
+					}
+					catch (const std::exception& e)
+					{
+						std::lock_guard<std::mutex> lock(fillMutex);
+						fillFailures.push_back({ texture, std::make_exception_ptr(std::runtime_error("failed to stream " + builder->bFilepath + ": " + e.what())) });
+					}
+					outstandingFills--;
+				});
+			}
+			openUploads.push_back(std::move(upload));
+		}
+
+		//Whatever was recorded before an error still has to be tracked until the GPU is done with it
+		submitFilledUploads();
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+
+	bool AssetStreamer::submitFilledUploads()
+	{
+		if (outstandingFills > 0) return false;
+		if (openUploads.empty()) return true;
+
+		DyneUploadTicket ticket = transferContext.submit();
+		for (auto& upload : openUploads)
+		{
+			upload.ticket = ticket;
+			pending.push_back(std::move(upload));
+		}
+		openUploads.clear();
+
+		//Failed textures are still released & destroyed with their batch, they just never become resident
+		std::vector<FillFailure> failures;
+		{
+			std::lock_guard<std::mutex> lock(fillMutex);
+			failures.swap(fillFailures);
+		}
+
+		std::exception_ptr unhandled;
+		for (auto& asset : pending)
+		{
+			for (const FillFailure& failure : failures)
+			{
+				if (asset.texture.get() != failure.texture) continue;
+
+				asset.onTextureResident = nullptr;
+				if (asset.onFailed)
+				{
+					asset.onFailed(failure.error);
+				}
+				else if (!unhandled)
+				{
+					unhandled = failure.error;
+				}
+			}
+		}
+		if (unhandled)
+		{
+			std::rethrow_exception(unhandled);
+		}
+		return true;
+	}
+
+	uint32_t AssetStreamer::publishCompleted()
+	{
+		std::vector<PendingAsset> completed;
+		while (!pending.empty() && transferContext.isComplete(pending.front().ticket))
+		{
+			completed.push_back(std::move(pending.front()));
+			pending.pop_front();
+		}
+
+		if (completed.empty()) return 0;
+
+		//Acquire half of the ownership transfers, submitted ahead of this frame on the graphics queue
+		auto& graphicsContext = _deviceRef.uploadContext();
+		for (auto& asset : completed)
+		{
+			if (asset.texture)
+			{
+				//Mips the transfer queue couldn't blit are generated here, after the image is acquired for transfers
+				bool pendingMips = asset.texture->hasPendingMips();
+				graphicsContext.acquireImageOwnership(
+					asset.texture->image(),
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					pendingMips ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					transferContext.getQueueFamilyIndex(),
+					asset.texture->mipLevels());
+				if (pendingMips)
+				{
+					asset.texture->generatePendingMips(graphicsContext);
+				}
+			}
+		}
+
+		//The geometry pool is shared concurrently, its new ranges only need to be made visible
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+		vkCmdPipelineBarrier(
+			graphicsContext.getCommandBuffer(),
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr);
+		graphicsContext.submit();
+
+		for (auto& asset : completed)
+		{
+			if (asset.model && asset.onModelResident)
+			{
+				asset.onModelResident(std::move(asset.model));
+			}
+			if (asset.texture && asset.onTextureResident)
+			{
+				asset.onTextureResident(std::move(asset.texture));
+			}
+		}
+
+		outstandingRequests -= static_cast<uint32_t>(completed.size());
+		return static_cast<uint32_t>(completed.size());
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../VulkanBackend/DyneDevice.hpp"
+#include "../VulkanBackend/DyneModel.hpp"
+#include "../VulkanBackend/DyneTexture.hpp"
+#include "../VulkanBackend/DyneGeometryPool.hpp"
+#include "../VulkanBackend/DyneUploadContext.hpp"
+#include "../Utility/DyneThreadPool.hpp"
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Dyne
+{
+    // Loads models and textures in the background. Files are parsed on worker threads, the
+    // results are copied to the GPU on the transfer queue and handed over to the graphics queue
+    // with ownership transfer barriers. Textures are decoded by the workers straight into staging
+    // memory reserved for them, so many decode at once and none is copied on the main thread. Callers keep a placeholder in use until the asset's
+    // callback runs, so opening a big level doesn't block the first frame.
+    class AssetStreamer
+    {
+    public:
+        using ModelCallback = std::function<void(std::shared_ptr<DyneModel>)>;
+        using TextureCallback = std::function<void(std::shared_ptr<DyneTexture>)>;
+        using FailureCallback = std::function<void(std::exception_ptr)>;
+
+        // Upload bytes recorded per update, big levels fill in over several frames instead of stalling one
+        static constexpr VkDeviceSize UPLOAD_BUDGET_PER_FRAME = 32ull * 1024 * 1024;
+
+        AssetStreamer(DyneDevice& device, DyneGeometryPool& geometryPool, DyneThreadPool& threadPool);
+        ~AssetStreamer();
+
+        AssetStreamer(const AssetStreamer&) = delete;
+        AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+        // onResident runs on the main thread, inside update(), once the asset can be drawn
+        void requestModel(const std::string& filepath, ModelCallback onResident);
+        // maxExtent leaves out the levels larger than it on either side, 0 loads the whole chain.
+        // When the load fails onFailed runs inside update() instead of the error being rethrown
+        void requestTexture(const std::string& filepath, TextureCallback onResident, uint32_t maxExtent = 0, FailureCallback onFailed = nullptr);
+
+        // Call once per frame before recording. Rethrows load errors from the workers for requests
+        // without a failure callback, returns how many assets became resident
+        uint32_t update();
+
+        bool isIdle() const { return outstandingRequests == 0; }
+        uint32_t getOutstandingCount() const { return outstandingRequests; }
+
+    private:
+        // Produced by the workers
+        struct ParsedAsset
+        {
+            std::unique_ptr<DyneModel::Builder> model;
+            std::unique_ptr<DyneTexture::Builder> texture;
+            ModelCallback onModelResident;
+            TextureCallback onTextureResident;
+            FailureCallback onFailed;
+            std::exception_ptr error;
+        };
+
+        // Copies submitted on the transfer queue, not yet visible to the graphics queue
+        struct PendingAsset
+        {
+            DyneUploadTicket ticket = 0;
+            std::shared_ptr<DyneModel> model;
+            std::shared_ptr<DyneTexture> texture;
+            ModelCallback onModelResident;
+            TextureCallback onTextureResident;
+            FailureCallback onFailed;
+        };
+
+        struct FillFailure
+        {
+            const DyneTexture* texture;
+            std::exception_ptr error;
+        };
+
+        void pushParsed(ParsedAsset asset);
+        void recordUploads();
+        // Submits the open batch once every texture in it is decoded, false while workers still fill it
+        bool submitFilledUploads();
+        uint32_t publishCompleted();
+
+        DyneDevice& _deviceRef;
+        DyneGeometryPool& _geometryPoolRef;
+        DyneThreadPool& _threadPoolRef;
+        DyneUploadContext transferContext;
+
+        std::mutex parsedMutex;
+        std::deque<ParsedAsset> parsed;
+
+        // Recorded into the open transfer batch, whose staging the workers may still be decoding into
+        std::vector<PendingAsset> openUploads;
+        std::atomic<uint32_t> outstandingFills{ 0 };
+        std::mutex fillMutex;
+        std::vector<FillFailure> fillFailures;
+
+        // main thread only, in submission order
+        std::deque<PendingAsset> pending;
+        uint32_t outstandingRequests = 0;
+    };
+}
@@ -14,6 +14,8 @@ namespace Dyne
 		projectionMatrix[3][0] = -(right + left) / (right - left);
 		projectionMatrix[3][1] = -(bottom + top) / (bottom - top);
 		projectionMatrix[3][2] = -near / (far - near);
+		nearClip = near;
+		farClip = far;
 	}
 
 	void Camera::setPerspectiveProjection(float fovy, float aspect, float near, float far) 
@@ -26,6 +28,8 @@ namespace Dyne
 		projectionMatrix[2][2] = far / (far - near);
 		projectionMatrix[2][3] = 1.f;
 		projectionMatrix[3][2] = -(far * near) / (far - near);
+		nearClip = near;
+		farClip = far;
 	}
 
 	void Camera::setViewDirection(glm::vec3 position, glm::vec3 direction, glm::vec3 up) 
@@ -79,4 +83,41 @@ namespace Dyne
 		viewMatrix[3][1] = -glm::dot(v, position);
 		viewMatrix[3][2] = -glm::dot(w, position);
 	}
+
+	void Camera::getRay(glm::vec2 ndc, glm::vec3& origin, glm::vec3& direction) const
+	{
+		const glm::mat4 inverseViewProjection = glm::inverse(projectionMatrix * viewMatrix);
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, 0.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+
+		origin = glm::vec3(nearPoint) / nearPoint.w;
+		direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+	}
+
+	std::array<glm::vec4, 6> Camera::getFrustumPlanes() const
+	{
+		//Gribb-Hartmann extraction from the rows of projection * view, depth range [0, 1]
+		const glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+		const glm::vec4 row0{ viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+		const glm::vec4 row1{ viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+		const glm::vec4 row2{ viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+		const glm::vec4 row3{ viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+		std::array<glm::vec4, 6> planes
+		{
+			row3 + row0,
+			row3 - row0,
+			row3 + row1,
+			row3 - row1,
+			row2,
+			row3 - row2
+		};
+
+		for (auto& plane : planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		return planes;
+	}
 }
@@ -4,6 +4,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <array>
+
 namespace Dyne 
 {
 	class Camera
@@ -20,10 +22,20 @@ namespace Dyne
 
 		const glm::mat4& getProjection() const { return projectionMatrix; }
 		const glm::mat4& getView() const { return viewMatrix; }
+		float getNearClip() const { return nearClip; }
+		float getFarClip() const { return farClip; }
+
+		//World space ray through a point in normalized device coordinates (-1..1, y down), starting on the near plane
+		void getRay(glm::vec2 ndc, glm::vec3& origin, glm::vec3& direction) const;
+
+		//Normalized planes (xyz = inward normal, w = distance) in order: left, right, bottom, top, near, far
+		std::array<glm::vec4, 6> getFrustumPlanes() const;
 
 	private:
 		glm::mat4 projectionMatrix{ 1.0f };
 		glm::mat4 viewMatrix{ 1.0f };
+		float nearClip = 0.1f;
+		float farClip = 100.0f;
 	};
 }
 
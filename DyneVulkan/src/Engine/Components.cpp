@@ -0,0 +1,119 @@
+#include "Components.hpp"
+
+namespace Dyne
+{
+	glm::mat4 TransformComponent::mat4() 
+	{
+		const float c3 = glm::cos(rotation.z);
+		const float s3 = glm::sin(rotation.z);
+		const float c2 = glm::cos(rotation.x);
+		const float s2 = glm::sin(rotation.x);
+		const float c1 = glm::cos(rotation.y);
+		const float s1 = glm::sin(rotation.y);
+
+		return glm::mat4{
+			{
+				scale.x * (c1 * c3 + s1 * s2 * s3),
+				scale.x * (c2 * s3),
+				scale.x * (c1 * s2 * s3 - c3 * s1),
+				0.0f,
+			},
+			{
+				scale.y * (c3 * s1 * s2 - c1 * s3),
+				scale.y * (c2 * c3),
+				scale.y * (c1 * c3 * s2 + s1 * s3),
+				0.0f,
+			},
+			{
+				scale.z * (c2 * s1),
+				scale.z * (-s2),
+				scale.z * (c1 * c2),
+				0.0f,
+			},
+			{translation.x, translation.y, translation.z, 1.0f} };
+	}
+
+	glm::mat3 TransformComponent::normalMatrix() 
+	{
+		const float c3 = glm::cos(rotation.z);
+		const float s3 = glm::sin(rotation.z);
+		const float c2 = glm::cos(rotation.x);
+		const float s2 = glm::sin(rotation.x);
+		const float c1 = glm::cos(rotation.y);
+		const float s1 = glm::sin(rotation.y);
+		const glm::vec3 invScale = 1.0f / scale;
+
+		return glm::mat3{
+			{
+				invScale.x * (c1 * c3 + s1 * s2 * s3),
+				invScale.x * (c2 * s3),
+				invScale.x * (c1 * s2 * s3 - c3 * s1),
+			},
+			{
+				invScale.y * (c3 * s1 * s2 - c1 * s3),
+				invScale.y * (c2 * c3),
+				invScale.y * (c1 * c3 * s2 + s1 * s3),
+			},
+			{
+				invScale.z * (c2 * s1),
+				invScale.z * (-s2),
+				invScale.z * (c1 * c2),
+			}};
+	}
+	//Single columns of mat4(), without building the whole matrix
+	glm::vec3 TransformComponent::getX()
+	{
+		const float c3 = glm::cos(rotation.z);
+		const float s3 = glm::sin(rotation.z);
+		const float c2 = glm::cos(rotation.x);
+		const float s2 = glm::sin(rotation.x);
+		const float c1 = glm::cos(rotation.y);
+		const float s1 = glm::sin(rotation.y);
+		return scale.x * glm::vec3{ c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1 };
+	}
+	glm::vec3 TransformComponent::getY()
+	{
+		const float c3 = glm::cos(rotation.z);
+		const float s3 = glm::sin(rotation.z);
+		const float c2 = glm::cos(rotation.x);
+		const float s2 = glm::sin(rotation.x);
+		const float c1 = glm::cos(rotation.y);
+		const float s1 = glm::sin(rotation.y);
+		return scale.y * glm::vec3{ c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3 };
+	}
+	glm::vec3 TransformComponent::getZ()
+	{
+		const float c2 = glm::cos(rotation.x);
+		const float s2 = glm::sin(rotation.x);
+		const float c1 = glm::cos(rotation.y);
+		const float s1 = glm::sin(rotation.y);
+		return scale.z * glm::vec3{ c2 * s1, -s2, c1 * c2 };
+	}
+
+	glm::vec4 computeWorldBoundingSphere(const DyneModel& model, const WorldTransformComponent& world)
+	{
+		glm::vec4 localSphere = model.getBoundingSphere();
+		glm::vec3 center = glm::vec3(world.modelMatrix * glm::vec4(glm::vec3(localSphere), 1.0f));
+
+		//Non-uniform scale stretches the sphere by its largest axis
+		float scaleSquared = glm::max(glm::max(
+			glm::dot(glm::vec3(world.modelMatrix[0]), glm::vec3(world.modelMatrix[0])),
+			glm::dot(glm::vec3(world.modelMatrix[1]), glm::vec3(world.modelMatrix[1]))),
+			glm::dot(glm::vec3(world.modelMatrix[2]), glm::vec3(world.modelMatrix[2])));
+
+		return glm::vec4(center, localSphere.w * glm::sqrt(scaleSquared));
+	}
+
+	Entity createPointLight(EntityRegistry& registry, float intensity, float radius, glm::vec3 color, float range)
+	{
+		Entity entity = registry.create();
+		registry.add<TransformComponent>(entity);
+
+		auto& pointLight = registry.add<PointLightComponent>(entity);
+		pointLight.color = color;
+		pointLight.lightIntensity = intensity;
+		pointLight.lightRange = range;
+		pointLight.radius = radius;
+		return entity;
+	}
+}
\ No newline at end of file
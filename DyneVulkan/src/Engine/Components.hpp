@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../VulkanBackend/DyneModel.hpp"
+#include "EntityRegistry.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <memory>
+
+namespace Dyne
+{
+	struct TransformComponent
+	{
+		glm::vec3 translation{};
+		glm::vec3 scale{1.0f, 1.0f, 1.0f};
+		glm::vec3 rotation{};
+
+		//Set after changing the fields above, the transform system only recomputes dirty transforms
+		bool dirty = true;
+
+		//Matrix operation order: translation * rY * rX * rZ * scale
+		//Rotation convention uses Tait-Bryan angles with order: Y(1), X(2), Z(3)
+		//https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+		glm::mat4 mat4();
+		glm::mat3 normalMatrix();
+
+		glm::vec3 getX();
+		glm::vec3 getY();
+		glm::vec3 getZ();
+	};
+
+	//Matrices of a transform, kept up to date by the TransformSystem for every entity with a transform.
+	//Same layout as the start of the per-instance data in shader.vert.
+	struct WorldTransformComponent
+	{
+		glm::mat4 modelMatrix{ 1.0f };
+		glm::mat4 normalMatrix{ 1.0f };
+	};
+
+	//Makes the entity's TransformComponent relative to its parent, set through TransformSystem::setParent
+	struct HierarchyComponent
+	{
+		Entity parent{};
+		//Matrices of the local transform, combined with the parent's world matrices on propagation
+		WorldTransformComponent local{};
+	};
+
+	struct ModelComponent
+	{
+		std::shared_ptr<DyneModel> model{};
+		//Slot in the DyneTextureRegistry, changing it costs nothing and doesn't break instancing
+		uint32_t textureIndex = 0;
+	};
+
+	struct PointLightComponent
+	{
+		glm::vec3 color{ 1.0f };
+		float lightIntensity = 1.0f;
+		//Distance at which the light has faded out completely, bounds the clusters it is binned into
+		float lightRange = 10.0f;
+		//Size of the billboard drawn at the light
+		float radius = 0.1f;
+	};
+
+	//World space bounding sphere (xyz = center, w = radius) of a model placed by the given matrices
+	glm::vec4 computeWorldBoundingSphere(const DyneModel& model, const WorldTransformComponent& world);
+
+	//Entity with a transform & point light component
+	Entity createPointLight(
+		EntityRegistry& registry,
+		float intensity = 10.0f,
+		float radius = 0.1f,
+		glm::vec3 color = glm::vec3(1.0f),
+		float range = 10.0f);
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "EntityRegistry.hpp"
+
+namespace Dyne
+{
+	std::atomic<uint32_t> EntityRegistry::nextComponentTypeId{ 0 };
+
+	Entity EntityRegistry::create()
+	{
+		//Reuse a destroyed slot first, its generation was bumped on destroy
+		if (!freeIndices.empty())
+		{
+			uint32_t index = freeIndices.back();
+			freeIndices.pop_back();
+			return Entity{ index, generations[index] };
+		}
+
+		assert(generations.size() < Entity::INVALID_INDEX && "Entity count exceeds maximum amount!");
+		generations.push_back(0);
+		return Entity{ static_cast<uint32_t>(generations.size() - 1), 0 };
+	}
+
+	void EntityRegistry::destroy(Entity entity)
+	{
+		if (!isAlive(entity)) return;
+
+		for (auto& pool : pools)
+		{
+			if (pool != nullptr)
+			{
+				pool->remove(entity.index);
+			}
+		}
+
+		generations[entity.index]++;
+		freeIndices.push_back(entity.index);
+	}
+
+	bool EntityRegistry::isAlive(Entity entity) const
+	{
+		return entity.index < generations.size() && generations[entity.index] == entity.generation;
+	}
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Dyne
+{
+    // Generational handle: index slots are reused after destroy, the generation tells stale handles apart
+    struct Entity
+    {
+        static constexpr uint32_t INVALID_INDEX = ~0u;
+
+        uint32_t index = INVALID_INDEX;
+        uint32_t generation = 0;
+
+        bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const Entity& other) const { return !(*this == other); }
+    };
+
+    // Sparse set: components are packed in a dense array, the sparse array maps entity index -> dense position
+    class ComponentPoolBase
+    {
+    public:
+        virtual ~ComponentPoolBase() = default;
+
+        virtual void remove(uint32_t entityIndex) = 0;
+
+        bool has(uint32_t entityIndex) const { return entityIndex < sparse.size() && sparse[entityIndex] != INVALID_POSITION; }
+        size_t size() const { return entities.size(); }
+        // Changes whenever a component is added or removed, so anything holding pointers or dense
+        // positions into the pool can tell they went stale
+        uint64_t getVersion() const { return version; }
+
+        // Entity index of every component, in dense order
+        const std::vector<uint32_t>& getEntities() const { return entities; }
+
+    protected:
+        static constexpr uint32_t INVALID_POSITION = ~0u;
+
+        std::vector<uint32_t> sparse;
+        std::vector<uint32_t> entities;
+        uint64_t version = 0;
+    };
+
+    template<typename T>
+    class ComponentPool : public ComponentPoolBase
+    {
+    public:
+        template<typename... Args>
+        T& add(uint32_t entityIndex, Args&&... args)
+        {
+            assert(!has(entityIndex) && "Entity already has this component!");
+
+            if (entityIndex >= sparse.size())
+            {
+                sparse.resize(entityIndex + 1, INVALID_POSITION);
+            }
+            sparse[entityIndex] = static_cast<uint32_t>(components.size());
+            entities.push_back(entityIndex);
+            components.push_back(T{ std::forward<Args>(args)... });
+            version++;
+            return components.back();
+        }
+
+        // Moves the last component into the hole, so the dense array stays packed
+        void remove(uint32_t entityIndex) override
+        {
+            if (!has(entityIndex)) return;
+
+            uint32_t position = sparse[entityIndex];
+            uint32_t lastEntity = entities.back();
+
+            if (lastEntity != entityIndex)
+            {
+                components[position] = std::move(components.back());
+                entities[position] = lastEntity;
+                sparse[lastEntity] = position;
+            }
+
+            components.pop_back();
+            entities.pop_back();
+            sparse[entityIndex] = INVALID_POSITION;
+            version++;
+        }
+
+        T& get(uint32_t entityIndex)
+        {
+            assert(has(entityIndex) && "Entity does not have this component!");
+            return components[sparse[entityIndex]];
+        }
+
+        std::vector<T>& getComponents() { return components; }
+
+    private:
+        std::vector<T> components;
+    };
+
+    // Owns every entity and its components, one sparse set per component type. Systems walk the
+    // packed component arrays directly instead of testing every entity for what it has.
+    // Adding or removing components invalidates references & iteration, not thread safe.
+    class EntityRegistry
+    {
+    public:
+        EntityRegistry() = default;
+
+        EntityRegistry(const EntityRegistry&) = delete;
+        EntityRegistry& operator=(const EntityRegistry&) = delete;
+
+        Entity create();
+        // Removes all of the entity's components, stale handles fail isAlive afterwards
+        void destroy(Entity entity);
+        bool isAlive(Entity entity) const;
+        size_t getEntityCount() const { return generations.size() - freeIndices.size(); }
+        // Every entity index is below this, for systems that keep per entity side arrays
+        uint32_t getIndexCapacity() const { return static_cast<uint32_t>(generations.size()); }
+
+        template<typename T, typename... Args>
+        T& add(Entity entity, Args&&... args)
+        {
+            assert(isAlive(entity) && "Cannot add a component to a destroyed entity!");
+            return getPool<T>().add(entity.index, std::forward<Args>(args)...);
+        }
+
+        template<typename T>
+        void remove(Entity entity)
+        {
+            assert(isAlive(entity) && "Cannot remove a component from a destroyed entity!");
+            getPool<T>().remove(entity.index);
+        }
+
+        template<typename T>
+        bool has(Entity entity)
+        {
+            return isAlive(entity) && getPool<T>().has(entity.index);
+        }
+
+        template<typename T>
+        T& get(Entity entity)
+        {
+            assert(isAlive(entity) && "Cannot get a component of a destroyed entity!");
+            return getPool<T>().get(entity.index);
+        }
+
+        template<typename T>
+        T* tryGet(Entity entity)
+        {
+            if (!has<T>(entity)) return nullptr;
+            return &getPool<T>().get(entity.index);
+        }
+
+        template<typename T>
+        size_t count()
+        {
+            return getPool<T>().size();
+        }
+
+        // Packed storage of one component type, for systems that want to scan it themselves
+        template<typename T>
+        ComponentPool<T>& getPool()
+        {
+            uint32_t typeId = componentTypeId<T>();
+            if (typeId >= pools.size())
+            {
+                pools.resize(typeId + 1);
+            }
+            if (pools[typeId] == nullptr)
+            {
+                pools[typeId] = std::make_unique<ComponentPool<T>>();
+            }
+            return *static_cast<ComponentPool<T>*>(pools[typeId].get());
+        }
+
+        // Calls fn(Entity, First&, Rest&...) for every entity that has all of the components. Walks the
+        // first component's dense array in order, so list the rarest component first.
+        template<typename First, typename... Rest, typename Fn>
+        void each(Fn&& fn)
+        {
+            auto& firstPool = getPool<First>();
+            auto& firstComponents = firstPool.getComponents();
+            const auto& entities = firstPool.getEntities();
+            std::tuple<ComponentPool<Rest>&...> restPools{ getPool<Rest>()... };
+
+            for (size_t i = 0; i < entities.size(); i++)
+            {
+                uint32_t index = entities[i];
+                if (!(std::get<ComponentPool<Rest>&>(restPools).has(index) && ...)) continue;
+
+                fn(Entity{ index, generations[index] }, firstComponents[i], std::get<ComponentPool<Rest>&>(restPools).get(index)...);
+            }
+        }
+
+    private:
+        template<typename T>
+        static uint32_t componentTypeId()
+        {
+            static const uint32_t typeId = nextComponentTypeId++;
+            return typeId;
+        }
+
+        static std::atomic<uint32_t> nextComponentTypeId;
+
+        std::vector<uint32_t> generations;
+        std::vector<uint32_t> freeIndices;
+        std::vector<std::unique_ptr<ComponentPoolBase>> pools;
+    };
+}
@@ -5,7 +5,7 @@
 
 namespace Dyne
 {
-	void InputHandler::moveObjectInPlaneXZ(WindowHandler* window, float dt, GameObject& gameObject)
+	void InputHandler::moveObjectInPlaneXZ(WindowHandler* window, float dt, TransformComponent& transform)
 	{
 		if (glfwGetMouseButton(window->getHandle(), GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) setMouseEnabled(window, true);
 
@@ -48,14 +48,14 @@ namespace Dyne
 
 		if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon())
 		{
-			gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+			transform.rotation += lookSpeed * dt * glm::normalize(rotate);
 		}
 
-		gameObject.transform.rotation.x = glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f);
-		gameObject.transform.rotation.y = glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>());
+		transform.rotation.x = glm::clamp(transform.rotation.x, -1.5f, 1.5f);
+		transform.rotation.y = glm::mod(transform.rotation.y, glm::two_pi<float>());
 
-		float pitch = gameObject.transform.rotation.x;
-		float yaw = gameObject.transform.rotation.y;
+		float pitch = transform.rotation.x;
+		float yaw = transform.rotation.y;
 
 		const glm::vec3 forwardDir{ sin(yaw), -sin(pitch), cos(yaw)};
 		const glm::vec3 rightDir{ forwardDir.z, 0.0f, -forwardDir.x };
@@ -74,8 +74,23 @@ namespace Dyne
 
 		if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon())
 		{
-			gameObject.transform.translation += (speedBoost ? moveSpeed * speedMultiplier : moveSpeed) * dt * glm::normalize(moveDir);
+			transform.translation += (speedBoost ? moveSpeed * speedMultiplier : moveSpeed) * dt * glm::normalize(moveDir);
 		}
 		speedBoost = false;
+		transform.dirty = true;
+	}
+
+	bool InputHandler::pollPick(WindowHandler* window, glm::vec2& cursor)
+	{
+		bool isPickDown = glfwGetMouseButton(window->getHandle(), keys.pick) == GLFW_PRESS;
+		bool picked = isPickDown && !wasPickDown;
+		wasPickDown = isPickDown;
+		if (!picked) return false;
+
+		double cursorX, cursorY;
+		glfwGetCursorPos(window->getHandle(), &cursorX, &cursorY);
+		cursor.x = static_cast<float>(cursorX / window->getExtent().width) * 2.0f - 1.0f;
+		cursor.y = static_cast<float>(cursorY / window->getExtent().height) * 2.0f - 1.0f;
+		return true;
 	}
 }
\ No newline at end of file
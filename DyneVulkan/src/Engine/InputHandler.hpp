@@ -1,6 +1,6 @@
 #pragma once
 
-#include "GameObject.hpp"
+#include "Components.hpp"
 #include "../Window/WindowHandler.hpp"
 
 namespace Dyne
@@ -23,9 +23,13 @@ namespace Dyne
             int lshift = GLFW_KEY_LEFT_SHIFT;
             int rshift = GLFW_KEY_RIGHT_SHIFT;
             int x = GLFW_KEY_X;
+            int pick = GLFW_MOUSE_BUTTON_RIGHT;
         };
 
-        void moveObjectInPlaneXZ(WindowHandler* window, float dt, GameObject& gameObject);
+        void moveObjectInPlaneXZ(WindowHandler* window, float dt, TransformComponent& transform);
+        // True on the frame the pick button goes down, cursor is the picked point in normalized device coordinates.
+        // While mouse look is on the cursor sits in the middle of the window.
+        bool pollPick(WindowHandler* window, glm::vec2& cursor);
         void setMouseEnabled(WindowHandler* window ,bool value)
         { 
             isMouseEnabled = value; 
@@ -43,6 +47,7 @@ namespace Dyne
         double mouseOffsetX, mouseOffsetY;
 
         bool firstMouse = true;
+        bool wasPickDown = false;
         bool isMouseEnabled = false;
 
         float moveSpeed{ 0.0012f };
@@ -0,0 +1,433 @@
+#include "SceneBvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Dyne
+{
+	namespace
+	{
+		constexpr uint32_t INVALID_POSITION = ~0u;
+
+		enum class PlaneSide { Outside, Intersecting, Inside };
+
+		//Tests the box corners furthest along & against each plane normal
+		PlaneSide classifyBox(const Aabb& box, const std::array<glm::vec4, 6>& planes)
+		{
+			PlaneSide side = PlaneSide::Inside;
+			for (const glm::vec4& plane : planes)
+			{
+				glm::vec3 normal{ plane };
+				glm::vec3 furthest = glm::mix(box.min, box.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+				if (glm::dot(normal, furthest) + plane.w < 0.0f) return PlaneSide::Outside;
+
+				glm::vec3 nearest = glm::mix(box.max, box.min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+				if (glm::dot(normal, nearest) + plane.w < 0.0f) side = PlaneSide::Intersecting;
+			}
+			return side;
+		}
+
+		bool overlaps(const Aabb& a, const Aabb& b)
+		{
+			return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::lessThanEqual(b.min, a.max));
+		}
+
+		bool overlapsSphere(const Aabb& box, glm::vec3 center, float radiusSquared)
+		{
+			glm::vec3 closest = glm::clamp(center, box.min, box.max);
+			glm::vec3 offset = closest - center;
+			return glm::dot(offset, offset) <= radiusSquared;
+		}
+
+		//Slab test, returns the entry distance or FLT_MAX when the ray misses within maxDistance
+		float intersectRay(const Aabb& box, glm::vec3 origin, glm::vec3 inverseDirection, float maxDistance)
+		{
+			glm::vec3 t0 = (box.min - origin) * inverseDirection;
+			glm::vec3 t1 = (box.max - origin) * inverseDirection;
+			glm::vec3 tNear = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+
+			float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+			float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+			return enter <= exit ? enter : FLT_MAX;
+		}
+	}
+
+	void SceneBvh::update(EntityRegistry& registry)
+	{
+		if (!boundsDirty && registry.count<ModelComponent>() == syncedModelCount) return;
+
+		boundsDirty = false;
+		syncedModelCount = registry.count<ModelComponent>();
+
+		gatheredItems.clear();
+		registry.each<ModelComponent, WorldTransformComponent>([&](Entity entity, ModelComponent& model, WorldTransformComponent& world)
+		{
+			if (model.model == nullptr) return;
+
+			glm::vec4 sphere = computeWorldBoundingSphere(*model.model, world);
+			gatheredItems.push_back(Item{ Aabb{ glm::vec3(sphere) - sphere.w, glm::vec3(sphere) + sphere.w }, entity });
+		});
+
+		//Entities came or went, the tree has to be built again
+		bool sameEntities = gatheredItems.size() == items.size();
+		for (size_t i = 0; sameEntities && i < gatheredItems.size(); i++)
+		{
+			uint32_t index = gatheredItems[i].entity.index;
+			sameEntities = index < itemPositions.size() &&
+				itemPositions[index] != INVALID_POSITION &&
+				items[itemPositions[index]].entity == gatheredItems[i].entity;
+		}
+		if (!sameEntities)
+		{
+			build(gatheredItems);
+			return;
+		}
+
+		//Only bounds moved: refit, and rebuild once the refitted tree got too loose
+		for (const Item& item : gatheredItems)
+		{
+			items[itemPositions[item.entity.index]].bounds = item.bounds;
+		}
+		refit();
+
+		if (computeCost() > builtCost * REBUILD_COST_RATIO)
+		{
+			build(items);
+		}
+	}
+
+	void SceneBvh::build(std::vector<Item> newItems)
+	{
+		items = std::move(newItems);
+		nodes.clear();
+		itemPositions.clear();
+		builtCost = 0.0f;
+
+		if (items.empty()) return;
+
+		//A binary tree with at least one item per leaf never has more than 2n - 1 nodes
+		nodes.reserve(items.size() * 2);
+
+		Node root{};
+		root.first = 0;
+		root.count = static_cast<uint32_t>(items.size());
+		for (const Item& item : items)
+		{
+			root.bounds.grow(item.bounds);
+		}
+		nodes.push_back(root);
+
+		std::vector<uint32_t> pendingNodes{ 0 };
+		while (!pendingNodes.empty())
+		{
+			uint32_t nodeIndex = pendingNodes.back();
+			pendingNodes.pop_back();
+			subdivide(nodeIndex, pendingNodes);
+		}
+
+		//Items were reordered into leaf order
+		for (uint32_t i = 0; i < items.size(); i++)
+		{
+			uint32_t index = items[i].entity.index;
+			if (index >= itemPositions.size()) itemPositions.resize(index + 1, INVALID_POSITION);
+			itemPositions[index] = i;
+		}
+
+		builtCost = computeCost();
+	}
+
+	void SceneBvh::subdivide(uint32_t nodeIndex, std::vector<uint32_t>& pendingNodes)
+	{
+		const Node node = nodes[nodeIndex];
+		if (node.count <= MAX_LEAF_SIZE) return;
+
+		auto begin = items.begin() + node.first;
+		auto end = begin + node.count;
+
+		Aabb centroidBounds{};
+		for (auto it = begin; it != end; ++it)
+		{
+			centroidBounds.grow(it->bounds.center());
+		}
+		glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+		int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+		//Items sharing one centroid can't be told apart, any split keeps the leaves small
+		auto middle = begin + node.count / 2;
+		if (extent[axis] > 0.0f)
+		{
+			struct Bin
+			{
+				Aabb bounds{};
+				uint32_t count = 0;
+			};
+			std::array<Bin, SAH_BINS> bins{};
+
+			float binScale = SAH_BINS / extent[axis];
+			auto binOf = [&](const Item& item)
+			{
+				uint32_t bin = static_cast<uint32_t>((item.bounds.center()[axis] - centroidBounds.min[axis]) * binScale);
+				return std::min(bin, SAH_BINS - 1);
+			};
+
+			for (auto it = begin; it != end; ++it)
+			{
+				Bin& bin = bins[binOf(*it)];
+				bin.bounds.grow(it->bounds);
+				bin.count++;
+			}
+
+			//Sweep from the right for the suffix areas, then from the left to price every split
+			std::array<float, SAH_BINS> rightAreas{};
+			std::array<uint32_t, SAH_BINS> rightCounts{};
+			Aabb rightBounds{};
+			uint32_t rightCount = 0;
+			for (uint32_t i = SAH_BINS - 1; i > 0; i--)
+			{
+				rightBounds.grow(bins[i].bounds);
+				rightCount += bins[i].count;
+				rightAreas[i] = rightBounds.surfaceArea();
+				rightCounts[i] = rightCount;
+			}
+
+			uint32_t bestSplit = 0;
+			float bestCost = FLT_MAX;
+			Aabb leftBounds{};
+			uint32_t leftCount = 0;
+			for (uint32_t split = 1; split < SAH_BINS; split++)
+			{
+				leftBounds.grow(bins[split - 1].bounds);
+				leftCount += bins[split - 1].count;
+				if (leftCount == 0 || rightCounts[split] == 0) continue;
+
+				float cost = leftBounds.surfaceArea() * leftCount + rightAreas[split] * rightCounts[split];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestSplit = split;
+				}
+			}
+
+			if (bestSplit != 0)
+			{
+				middle = std::partition(begin, end, [&](const Item& item) { return binOf(item) < bestSplit; });
+			}
+		}
+
+		uint32_t leftFirst = node.first;
+		uint32_t leftItemCount = static_cast<uint32_t>(middle - begin);
+
+		Node left{};
+		left.first = leftFirst;
+		left.count = leftItemCount;
+		Node right{};
+		right.first = leftFirst + leftItemCount;
+		right.count = node.count - leftItemCount;
+		for (auto it = begin; it != middle; ++it) left.bounds.grow(it->bounds);
+		for (auto it = middle; it != end; ++it) right.bounds.grow(it->bounds);
+
+		uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+		nodes[nodeIndex].first = leftIndex;
+		nodes[nodeIndex].count = 0;
+		nodes.push_back(left);
+		nodes.push_back(right);
+
+		pendingNodes.push_back(leftIndex);
+		pendingNodes.push_back(leftIndex + 1);
+	}
+
+	void SceneBvh::refit()
+	{
+		//Children are always stored after their parent
+		for (size_t i = nodes.size(); i-- > 0;)
+		{
+			Node& node = nodes[i];
+			node.bounds = Aabb{};
+			if (node.count > 0)
+			{
+				for (uint32_t item = node.first; item < node.first + node.count; item++)
+				{
+					node.bounds.grow(items[item].bounds);
+				}
+			}
+			else
+			{
+				node.bounds.grow(nodes[node.first].bounds);
+				node.bounds.grow(nodes[node.first + 1].bounds);
+			}
+		}
+	}
+
+	float SceneBvh::computeCost() const
+	{
+		if (nodes.empty()) return 0.0f;
+
+		//Expected work per query: every inner node costs a box test, every leaf one test per item
+		float cost = 0.0f;
+		for (const Node& node : nodes)
+		{
+			cost += node.bounds.surfaceArea() * (node.count > 0 ? node.count : 1);
+		}
+		return cost / std::max(nodes[0].bounds.surfaceArea(), FLT_MIN);
+	}
+
+	void SceneBvh::collectSubtree(uint32_t nodeIndex, std::vector<Entity>& results) const
+	{
+		//Inner nodes don't keep their item range, so walk down to the leaves
+		std::vector<uint32_t> stack{ nodeIndex };
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+
+			if (node.count > 0)
+			{
+				for (uint32_t item = node.first; item < node.first + node.count; item++)
+				{
+					results.push_back(items[item].entity);
+				}
+				continue;
+			}
+			stack.push_back(node.first);
+			stack.push_back(node.first + 1);
+		}
+	}
+
+	void SceneBvh::queryFrustum(const std::array<glm::vec4, 6>& planes, std::vector<Entity>& results) const
+	{
+		if (nodes.empty()) return;
+
+		std::vector<uint32_t> stack{ 0 };
+		while (!stack.empty())
+		{
+			uint32_t nodeIndex = stack.back();
+			stack.pop_back();
+			const Node& node = nodes[nodeIndex];
+
+			PlaneSide side = classifyBox(node.bounds, planes);
+			if (side == PlaneSide::Outside) continue;
+			if (side == PlaneSide::Inside)
+			{
+				//Everything below a fully visible node is visible, no more tests needed
+				collectSubtree(nodeIndex, results);
+				continue;
+			}
+
+			if (node.count > 0)
+			{
+				for (uint32_t item = node.first; item < node.first + node.count; item++)
+				{
+					if (classifyBox(items[item].bounds, planes) != PlaneSide::Outside) results.push_back(items[item].entity);
+				}
+				continue;
+			}
+			stack.push_back(node.first);
+			stack.push_back(node.first + 1);
+		}
+	}
+
+	void SceneBvh::queryBox(const Aabb& box, std::vector<Entity>& results) const
+	{
+		if (nodes.empty()) return;
+
+		std::vector<uint32_t> stack{ 0 };
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+			if (!overlaps(node.bounds, box)) continue;
+
+			if (node.count > 0)
+			{
+				for (uint32_t item = node.first; item < node.first + node.count; item++)
+				{
+					if (overlaps(items[item].bounds, box)) results.push_back(items[item].entity);
+				}
+				continue;
+			}
+			stack.push_back(node.first);
+			stack.push_back(node.first + 1);
+		}
+	}
+
+	void SceneBvh::querySphere(glm::vec3 center, float radius, std::vector<Entity>& results) const
+	{
+		if (nodes.empty()) return;
+
+		float radiusSquared = radius * radius;
+		std::vector<uint32_t> stack{ 0 };
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+			if (!overlapsSphere(node.bounds, center, radiusSquared)) continue;
+
+			if (node.count > 0)
+			{
+				for (uint32_t item = node.first; item < node.first + node.count; item++)
+				{
+					if (overlapsSphere(items[item].bounds, center, radiusSquared)) results.push_back(items[item].entity);
+				}
+				continue;
+			}
+			stack.push_back(node.first);
+			stack.push_back(node.first + 1);
+		}
+	}
+
+	bool SceneBvh::raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, RayHit& hit) const
+	{
+		hit = RayHit{};
+		if (nodes.empty()) return false;
+
+		glm::vec3 inverseDirection = 1.0f / direction;
+		float closest = maxDistance;
+
+		struct Pending
+		{
+			uint32_t nodeIndex;
+			float distance;
+		};
+		std::vector<Pending> stack;
+
+		float rootDistance = intersectRay(nodes[0].bounds, origin, inverseDirection, closest);
+		if (rootDistance != FLT_MAX) stack.push_back({ 0, rootDistance });
+
+		while (!stack.empty())
+		{
+			Pending pending = stack.back();
+			stack.pop_back();
+			//A closer hit was found since this node was pushed
+			if (pending.distance > closest) continue;
+
+			const Node& node = nodes[pending.nodeIndex];
+			if (node.count > 0)
+			{
+				for (uint32_t item = node.first; item < node.first + node.count; item++)
+				{
+					float distance = intersectRay(items[item].bounds, origin, inverseDirection, closest);
+					if (distance != FLT_MAX && distance <= closest)
+					{
+						closest = distance;
+						hit.entity = items[item].entity;
+						hit.distance = distance;
+					}
+				}
+				continue;
+			}
+
+			//Visit the nearer child first so the farther one is more likely to be pruned
+			float leftDistance = intersectRay(nodes[node.first].bounds, origin, inverseDirection, closest);
+			float rightDistance = intersectRay(nodes[node.first + 1].bounds, origin, inverseDirection, closest);
+			Pending nearer{ node.first, leftDistance };
+			Pending farther{ node.first + 1, rightDistance };
+			if (rightDistance < leftDistance) std::swap(nearer, farther);
+
+			if (farther.distance != FLT_MAX) stack.push_back(farther);
+			if (nearer.distance != FLT_MAX) stack.push_back(nearer);
+		}
+
+		return hit.distance != FLT_MAX;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Components.hpp"
+#include "EntityRegistry.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+namespace Dyne
+{
+    struct Aabb
+    {
+        glm::vec3 min{ FLT_MAX };
+        glm::vec3 max{ -FLT_MAX };
+
+        void grow(const Aabb& other) { min = glm::min(min, other.min); max = glm::max(max, other.max); }
+        void grow(glm::vec3 point) { min = glm::min(min, point); max = glm::max(max, point); }
+        glm::vec3 center() const { return (min + max) * 0.5f; }
+        float surfaceArea() const
+        {
+            glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+            return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+        }
+    };
+
+    // Bounding volume hierarchy over the world bounds of every drawn entity, answers frustum, ray and
+    // overlap queries in logarithmic time instead of scanning the registry.
+    // Built top down with binned SAH. Moving objects only refit the node bounds, the tree is rebuilt
+    // once refitting made it noticeably worse than a fresh build, or when entities came or went.
+    class SceneBvh
+    {
+    public:
+        static constexpr uint32_t MAX_LEAF_SIZE = 4;
+        static constexpr uint32_t SAH_BINS = 16;
+        // Refitted trees are rebuilt once their SAH cost grew by this factor
+        static constexpr float REBUILD_COST_RATIO = 1.5f;
+
+        struct Item
+        {
+            Aabb bounds;
+            Entity entity;
+        };
+
+        struct RayHit
+        {
+            Entity entity{};
+            float distance = FLT_MAX;
+        };
+
+        // Call after transforms or models changed
+        void invalidate() { boundsDirty = true; }
+        // Brings the tree in line with the registry, queries see the scene as of the last update
+        void update(EntityRegistry& registry);
+
+        // Full SAH build over arbitrary items
+        void build(std::vector<Item> items);
+        // Recomputes every node's bounds bottom up after item bounds changed in place
+        void refit();
+
+        // Entities whose bounds intersect the frustum planes (xyz = inward normal), see Camera::getFrustumPlanes
+        void queryFrustum(const std::array<glm::vec4, 6>& planes, std::vector<Entity>& results) const;
+        void queryBox(const Aabb& box, std::vector<Entity>& results) const;
+        void querySphere(glm::vec3 center, float radius, std::vector<Entity>& results) const;
+        // Closest entity whose bounds the ray enters within maxDistance, direction must be normalized
+        bool raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, RayHit& hit) const;
+
+        size_t getItemCount() const { return items.size(); }
+        const std::vector<Item>& getItems() const { return items; }
+
+    private:
+        // Leaves have count > 0 and own items [first, first + count), inner nodes have both children at first & first + 1
+        struct Node
+        {
+            Aabb bounds;
+            uint32_t first = 0;
+            uint32_t count = 0;
+        };
+
+        void subdivide(uint32_t nodeIndex, std::vector<uint32_t>& pendingNodes);
+        float computeCost() const;
+        void collectSubtree(uint32_t nodeIndex, std::vector<Entity>& results) const;
+
+        std::vector<Node> nodes;
+        std::vector<Item> items;
+        // Entity index -> position in items, to refit in place
+        std::vector<uint32_t> itemPositions;
+        std::vector<Item> gatheredItems;
+
+        float builtCost = 0.0f;
+        size_t syncedModelCount = 0;
+        bool boundsDirty = true;
+    };
+
+    // Times the tree against linear scans over the same random scene and prints the results
+    void runSceneBvhBenchmark(uint32_t itemCount);
+}
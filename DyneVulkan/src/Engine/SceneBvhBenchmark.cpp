@@ -0,0 +1,178 @@
+#include "SceneBvh.hpp"
+#include "Camera.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace Dyne
+{
+	namespace
+	{
+		using Clock = std::chrono::high_resolution_clock;
+
+		double millisecondsSince(Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+
+		void printResult(const char* name, double bvhTime, double linearTime, size_t bvhResults, size_t linearResults)
+		{
+			std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+				<< " bvh " << std::setw(10) << bvhTime << " ms"
+				<< "   linear " << std::setw(10) << linearTime << " ms"
+				<< "   speedup " << std::setw(8) << std::setprecision(1) << linearTime / std::max(bvhTime, 1e-6) << "x";
+			if (bvhResults != linearResults)
+			{
+				std::cout << "   RESULT MISMATCH (" << bvhResults << " vs " << linearResults << ")";
+			}
+			std::cout << "\n";
+		}
+	}
+
+	void runSceneBvhBenchmark(uint32_t itemCount)
+	{
+		constexpr int FRUSTUM_QUERIES = 100;
+		constexpr int RAY_QUERIES = 1000;
+		constexpr int SPHERE_QUERIES = 1000;
+
+		//Random spheres at roughly constant density, so the visible share doesn't depend on the item count
+		std::mt19937 random{ 1234 };
+		float worldSize = 100.0f * std::cbrt(static_cast<float>(itemCount) / 1000.0f);
+		std::uniform_real_distribution<float> position(-worldSize, worldSize);
+		std::uniform_real_distribution<float> radius(0.5f, 3.0f);
+		std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		std::vector<SceneBvh::Item> items(itemCount);
+		for (uint32_t i = 0; i < itemCount; i++)
+		{
+			glm::vec3 center{ position(random), position(random), position(random) };
+			float r = radius(random);
+			items[i] = SceneBvh::Item{ Aabb{ center - r, center + r }, Entity{ i, 0 } };
+		}
+
+		std::cout << "Scene BVH benchmark, " << itemCount << " items\n";
+
+		SceneBvh bvh;
+		auto start = Clock::now();
+		bvh.build(items);
+		std::cout << "build      " << std::fixed << std::setprecision(3) << millisecondsSince(start) << " ms\n";
+
+		start = Clock::now();
+		bvh.refit();
+		std::cout << "refit      " << millisecondsSince(start) << " ms\n";
+
+		std::vector<Entity> results;
+		size_t bvhCount = 0;
+		size_t linearCount = 0;
+
+		//Frustum culling from random cameras inside the scene
+		std::vector<std::array<glm::vec4, 6>> frustums(FRUSTUM_QUERIES);
+		for (auto& frustum : frustums)
+		{
+			Camera camera{};
+			camera.setPerspectiveProjection(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, worldSize);
+			camera.setViewYXZ({ position(random), position(random), position(random) }, { 0.0f, angle(random), 0.0f });
+			frustum = camera.getFrustumPlanes();
+		}
+
+		start = Clock::now();
+		for (const auto& frustum : frustums)
+		{
+			results.clear();
+			bvh.queryFrustum(frustum, results);
+			bvhCount += results.size();
+		}
+		double bvhTime = millisecondsSince(start);
+
+		start = Clock::now();
+		for (const auto& frustum : frustums)
+		{
+			for (const auto& item : items)
+			{
+				bool inside = true;
+				for (const glm::vec4& plane : frustum)
+				{
+					glm::vec3 furthest = glm::mix(item.bounds.min, item.bounds.max, glm::greaterThanEqual(glm::vec3(plane), glm::vec3(0.0f)));
+					if (glm::dot(glm::vec3(plane), furthest) + plane.w < 0.0f)
+					{
+						inside = false;
+						break;
+					}
+				}
+				linearCount += inside;
+			}
+		}
+		printResult("frustum", bvhTime, millisecondsSince(start), bvhCount, linearCount);
+
+		//Picking rays from random points in random directions
+		std::vector<std::pair<glm::vec3, glm::vec3>> rays(RAY_QUERIES);
+		for (auto& ray : rays)
+		{
+			ray.first = { position(random), position(random), position(random) };
+			ray.second = glm::normalize(glm::vec3{ unit(random), unit(random), unit(random) } + glm::vec3(1e-4f));
+		}
+
+		bvhCount = 0;
+		linearCount = 0;
+		start = Clock::now();
+		for (const auto& ray : rays)
+		{
+			SceneBvh::RayHit hit;
+			bvhCount += bvh.raycast(ray.first, ray.second, FLT_MAX, hit);
+		}
+		bvhTime = millisecondsSince(start);
+
+		start = Clock::now();
+		for (const auto& ray : rays)
+		{
+			glm::vec3 inverseDirection = 1.0f / ray.second;
+			float closest = FLT_MAX;
+			for (const auto& item : items)
+			{
+				glm::vec3 t0 = (item.bounds.min - ray.first) * inverseDirection;
+				glm::vec3 t1 = (item.bounds.max - ray.first) * inverseDirection;
+				glm::vec3 tNear = glm::min(t0, t1);
+				glm::vec3 tFar = glm::max(t0, t1);
+				float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+				float exit = glm::min(glm::min(tFar.x, tFar.y), tFar.z);
+				if (enter <= exit && enter < closest) closest = enter;
+			}
+			linearCount += closest != FLT_MAX;
+		}
+		printResult("raycast", bvhTime, millisecondsSince(start), bvhCount, linearCount);
+
+		//Light sized spheres, e.g. which objects a point light reaches
+		std::vector<glm::vec4> spheres(SPHERE_QUERIES);
+		for (auto& sphere : spheres)
+		{
+			sphere = { position(random), position(random), position(random), 10.0f };
+		}
+
+		bvhCount = 0;
+		linearCount = 0;
+		start = Clock::now();
+		for (const auto& sphere : spheres)
+		{
+			results.clear();
+			bvh.querySphere(glm::vec3(sphere), sphere.w, results);
+			bvhCount += results.size();
+		}
+		bvhTime = millisecondsSince(start);
+
+		start = Clock::now();
+		for (const auto& sphere : spheres)
+		{
+			for (const auto& item : items)
+			{
+				glm::vec3 offset = glm::clamp(glm::vec3(sphere), item.bounds.min, item.bounds.max) - glm::vec3(sphere);
+				linearCount += glm::dot(offset, offset) <= sphere.w * sphere.w;
+			}
+		}
+		printResult("sphere", bvhTime, millisecondsSince(start), bvhCount, linearCount);
+	}
+}
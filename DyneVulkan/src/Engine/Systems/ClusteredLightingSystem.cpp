@@ -0,0 +1,260 @@
+#include "ClusteredLightingSystem.hpp"
+
+#include "../Components.hpp"
+#include "../../VulkanBackend/DyneSwapchain.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace Dyne
+{
+	//Layout matches ClusterUbo in cluster.comp (std140)
+	struct ClusterUbo
+	{
+		glm::mat4 view{ 1.0f };
+		glm::mat4 inverseProjection{ 1.0f };
+		glm::vec4 screen{ 0.0f };
+		glm::uvec4 grid{ 0u };
+		uint32_t maxLightIndices = 0;
+		uint32_t pad[3]{};
+	};
+
+	static constexpr uint32_t CLUSTER_WORKGROUP_SIZE = 128;
+	static constexpr uint32_t MAX_LIGHT_INDICES = ClusteredLightingSystem::CLUSTER_COUNT * ClusteredLightingSystem::AVERAGE_LIGHTS_PER_CLUSTER;
+
+	ClusteredLightingSystem::ClusteredLightingSystem(DyneDevice& device, DynePipelineCompiler& pipelineCompiler) : _deviceRef(device)
+	{
+		createBuffers();
+		createDescriptorSets();
+		createPipelineLayout();
+		createPipeline(pipelineCompiler);
+	}
+
+	ClusteredLightingSystem::~ClusteredLightingSystem()
+	{
+		//The compile job still uses the layout
+		clusterPipeline.wait();
+		vkDestroyPipelineLayout(_deviceRef.device(), clusterPipelineLayout, nullptr);
+	}
+
+	void ClusteredLightingSystem::createBuffers()
+	{
+		lightBuffers.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		clusterUboBuffers.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		clusterBuffers.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		lightIndexBuffers.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		lightIndexCounterBuffers.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+
+		for (int i = 0; i < DyneSwapchain::MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			//Written by the CPU every frame
+			lightBuffers[i] = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(PointLight),
+				MAX_LIGHTS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			lightBuffers[i]->map();
+
+			clusterUboBuffers[i] = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(ClusterUbo),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			clusterUboBuffers[i]->map();
+
+			//Written by the cluster pass every frame
+			clusterBuffers[i] = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(glm::uvec2),
+				CLUSTER_COUNT,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			lightIndexBuffers[i] = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(uint32_t),
+				MAX_LIGHT_INDICES,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			lightIndexCounterBuffers[i] = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(uint32_t),
+				1,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+	}
+
+	void ClusteredLightingSystem::createDescriptorSets()
+	{
+		clusterPool = DyneDescriptorPool::Builder(_deviceRef)
+			.setMaxSets(DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.build();
+
+		clusterSetLayout = DyneDescriptorSetLayout::Builder(_deviceRef)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(4, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.build();
+
+		clusterDescriptorSets.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		for (int i = 0; i < clusterDescriptorSets.size(); i++)
+		{
+			auto lightInfo = lightBuffers[i]->descriptorInfo();
+			auto clusterInfo = clusterBuffers[i]->descriptorInfo();
+			auto indexInfo = lightIndexBuffers[i]->descriptorInfo();
+			auto counterInfo = lightIndexCounterBuffers[i]->descriptorInfo();
+			auto uboInfo = clusterUboBuffers[i]->descriptorInfo();
+
+			DyneDescriptorWriter(*clusterSetLayout, *clusterPool)
+				.writeBuffer(0, &lightInfo)
+				.writeBuffer(1, &clusterInfo)
+				.writeBuffer(2, &indexInfo)
+				.writeBuffer(3, &counterInfo)
+				.writeBuffer(4, &uboInfo)
+				.build(clusterDescriptorSets[i]);
+		}
+	}
+
+	void ClusteredLightingSystem::createPipelineLayout()
+	{
+		VkDescriptorSetLayout clusterLayout = clusterSetLayout->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &clusterLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+		if (vkCreatePipelineLayout(_deviceRef.device(), &pipelineLayoutInfo, nullptr, &clusterPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create cluster pipeline layout!");
+		}
+	}
+
+	void ClusteredLightingSystem::createPipeline(DynePipelineCompiler& pipelineCompiler)
+	{
+		assert(clusterPipelineLayout != nullptr && "Cannot create pipeline before pipeline layout!");
+
+		clusterPipeline = DynePendingPipeline<DyneComputePipeline>(pipelineCompiler.compileCompute(
+			"shaders/cluster.comp.spv",
+			clusterPipelineLayout));
+	}
+
+	void ClusteredLightingSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo, VkExtent2D extent)
+	{
+		auto* lights = static_cast<PointLight*>(lightBuffers[frameInfo.frameIndex]->getMappedMemory());
+
+		lightCount = 0;
+		frameInfo.registry.each<PointLightComponent, WorldTransformComponent>([&](Entity, PointLightComponent& pointLight, WorldTransformComponent& transform)
+		{
+			assert(lightCount < MAX_LIGHTS && "Point light count exceeds maximum amount!");
+			if (lightCount == MAX_LIGHTS) return;
+
+			lights[lightCount].position = glm::vec4(glm::vec3(transform.modelMatrix[3]), pointLight.lightRange);
+			lights[lightCount].color = glm::vec4(pointLight.color * pointLight.lightIntensity, pointLight.radius);
+			lightCount += 1;
+		});
+
+		//Depth slices are spaced exponentially: slice = log(z) * scale + bias
+		float nearClip = frameInfo.camera.getNearClip();
+		float farClip = frameInfo.camera.getFarClip();
+		float logDepthRange = std::log(farClip / nearClip);
+
+		ubo.clusterParams = glm::vec4(
+			static_cast<float>(extent.width) / CLUSTER_X,
+			static_cast<float>(extent.height) / CLUSTER_Y,
+			CLUSTER_Z / logDepthRange,
+			-CLUSTER_Z * std::log(nearClip) / logDepthRange);
+		ubo.clusterGrid = glm::uvec4(CLUSTER_X, CLUSTER_Y, CLUSTER_Z, lightCount);
+
+		ClusterUbo clusterUbo{};
+		clusterUbo.view = frameInfo.camera.getView();
+		clusterUbo.inverseProjection = glm::inverse(frameInfo.camera.getProjection());
+		clusterUbo.screen = glm::vec4(static_cast<float>(extent.width), static_cast<float>(extent.height), nearClip, farClip);
+		clusterUbo.grid = ubo.clusterGrid;
+		clusterUbo.maxLightIndices = MAX_LIGHT_INDICES;
+		clusterUboBuffers[frameInfo.frameIndex]->writeToBuffer(&clusterUbo);
+	}
+
+	void ClusteredLightingSystem::buildClusters(FrameInfo& frameInfo)
+	{
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+		auto& clusterBuffer = clusterBuffers[frameInfo.frameIndex];
+
+		//Empty clusters while the pipeline compiles, surfaces are lit by the ambient term only
+		if (!clusterPipeline.isReady())
+		{
+			vkCmdFillBuffer(commandBuffer, clusterBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+			VkMemoryBarrier fillBarrier{};
+			fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0,
+				1, &fillBarrier,
+				0, nullptr,
+				0, nullptr
+			);
+			return;
+		}
+
+		vkCmdFillBuffer(commandBuffer, lightIndexCounterBuffers[frameInfo.frameIndex]->getBuffer(), 0, sizeof(uint32_t), 0);
+
+		VkMemoryBarrier clearBarrier{};
+		clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &clearBarrier,
+			0, nullptr,
+			0, nullptr
+		);
+
+		clusterPipeline.get()->bind(commandBuffer);
+		vkCmdBindDescriptorSets
+		(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			clusterPipelineLayout,
+			0, 1,
+			&clusterDescriptorSets[frameInfo.frameIndex],
+			0,
+			nullptr
+		);
+		vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + CLUSTER_WORKGROUP_SIZE - 1) / CLUSTER_WORKGROUP_SIZE, 1, 1);
+
+		VkMemoryBarrier clusterBarrier{};
+		clusterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		clusterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		clusterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0,
+			1, &clusterBarrier,
+			0, nullptr,
+			0, nullptr
+		);
+	}
+}
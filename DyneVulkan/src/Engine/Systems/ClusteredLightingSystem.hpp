@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../../VulkanBackend/DynePipeline.hpp"
+#include "../../VulkanBackend/DynePipelineCompiler.hpp"
+#include "../../VulkanBackend/DyneFrameInfo.hpp"
+#include "../../VulkanBackend/DyneBuffer.hpp"
+#include "../../VulkanBackend/DyneDescriptors.hpp"
+#include "../Components.hpp"
+#include "../Camera.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <stdexcept>
+#include <memory>
+#include <vector>
+
+namespace Dyne
+{
+    // Clustered forward lighting: point lights live in a storage buffer and a compute pass bins
+    // them into a grid of view space clusters (screen tiles x exponential depth slices). Fragments
+    // only shade the lights of their own cluster, which is capped, so the per pixel cost stays
+    // bounded no matter how many lights the scene has.
+    class ClusteredLightingSystem
+    {
+    public:
+        static constexpr uint32_t CLUSTER_X = 16;
+        static constexpr uint32_t CLUSTER_Y = 9;
+        static constexpr uint32_t CLUSTER_Z = 24;
+        static constexpr uint32_t CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+
+        // Must match MAX_LIGHTS_PER_CLUSTER in cluster.comp
+        static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+        // Sizes the shared light index list, crowded clusters may use more as long as the total fits
+        static constexpr uint32_t AVERAGE_LIGHTS_PER_CLUSTER = 32;
+
+        ClusteredLightingSystem(DyneDevice& device, DynePipelineCompiler& pipelineCompiler);
+        ~ClusteredLightingSystem();
+
+        ClusteredLightingSystem(const ClusteredLightingSystem&) = delete;
+        ClusteredLightingSystem operator=(const ClusteredLightingSystem&) = delete;
+
+        bool isReady() { return clusterPipeline.isReady(); }
+        uint32_t getLightCount() const { return lightCount; }
+
+        // Gathers the scene's point lights for this frame and fills in the ubo's cluster parameters
+        void update(FrameInfo& frameInfo, GlobalUbo& ubo, VkExtent2D extent);
+        // Must be recorded outside of a render pass, leaves every cluster empty until isReady()
+        void buildClusters(FrameInfo& frameInfo);
+
+        // Bound through the global set, read by the lit & point light shaders
+        VkDescriptorBufferInfo lightBufferInfo(int frameIndex) { return lightBuffers[frameIndex]->descriptorInfo(); }
+        VkDescriptorBufferInfo clusterBufferInfo(int frameIndex) { return clusterBuffers[frameIndex]->descriptorInfo(); }
+        VkDescriptorBufferInfo lightIndexBufferInfo(int frameIndex) { return lightIndexBuffers[frameIndex]->descriptorInfo(); }
+
+    private:
+        void createBuffers();
+        void createDescriptorSets();
+        void createPipelineLayout();
+        void createPipeline(DynePipelineCompiler& pipelineCompiler);
+
+        DyneDevice& _deviceRef;
+
+        DynePendingPipeline<DyneComputePipeline> clusterPipeline;
+        VkPipelineLayout clusterPipelineLayout;
+
+        std::unique_ptr<DyneDescriptorPool> clusterPool{};
+        std::unique_ptr<DyneDescriptorSetLayout> clusterSetLayout{};
+        std::vector<VkDescriptorSet> clusterDescriptorSets;
+
+        // One of each per frame in flight, the cluster pass of the next frame overlaps this frame's shading
+        std::vector<std::unique_ptr<DyneBuffer>> lightBuffers;
+        std::vector<std::unique_ptr<DyneBuffer>> clusterUboBuffers;
+        std::vector<std::unique_ptr<DyneBuffer>> clusterBuffers;
+        std::vector<std::unique_ptr<DyneBuffer>> lightIndexBuffers;
+        std::vector<std::unique_ptr<DyneBuffer>> lightIndexCounterBuffers;
+
+        uint32_t lightCount = 0;
+    };
+}
@@ -0,0 +1,176 @@
+#include "CullingSystem.hpp"
+
+#include "../../Utility/DyneSimd.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Dyne
+{
+	using namespace Simd;
+
+	static_assert(CullingSystem::BLOCK_SIZE % LANE_WIDTH == 0, "Block size must be a multiple of the SIMD width!");
+
+	CullingSystem::CullingSystem(DyneThreadPool& threadPool) : _threadPoolRef(threadPool)
+	{
+
+	}
+
+	void CullingSystem::rebuildBounds(EntityRegistry& registry)
+	{
+		auto& modelPool = registry.getPool<ModelComponent>();
+		auto& worldPool = registry.getPool<WorldTransformComponent>();
+		auto& models = modelPool.getComponents();
+		const auto& entities = modelPool.getEntities();
+
+		uint32_t objectCount = static_cast<uint32_t>(models.size());
+		uint32_t blockCount = (objectCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		objects.resize(objectCount);
+		boundsBlocks.resize(blockCount);
+		visibilityMasks.resize(blockCount);
+		boundsDirty = false;
+
+		//Levels follow their entity through the rebuild, the dense order changes as components come & go
+		lodByEntity.assign(registry.getIndexCapacity(), 0);
+		for (size_t i = 0; i < objectEntities.size(); i++)
+		{
+			if (objectEntities[i] < lodByEntity.size()) lodByEntity[objectEntities[i]] = lodLevels[i];
+		}
+		objectEntities = entities;
+		lodLevels.resize(objectCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			lodLevels[i] = lodByEntity[entities[i]];
+		}
+		modelPoolVersion = modelPool.getVersion();
+		worldPoolVersion = worldPool.getVersion();
+
+		//A radius of -infinity fails every plane, used for padding & objects that can't be drawn
+		const float neverVisible = -std::numeric_limits<float>::infinity();
+
+		_threadPoolRef.parallelFor(objectCount, MIN_OBJECTS_PER_CHUNK, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				BoundsBlock& block = boundsBlocks[i / BLOCK_SIZE];
+				uint32_t lane = i % BLOCK_SIZE;
+
+				DyneModel* model = models[i].model.get();
+				if (model == nullptr || !worldPool.has(entities[i]))
+				{
+					objects[i] = VisibleObject{};
+					block.centerX[lane] = block.centerY[lane] = block.centerZ[lane] = 0.0f;
+					block.radius[lane] = neverVisible;
+					continue;
+				}
+
+				const WorldTransformComponent& world = worldPool.get(entities[i]);
+				glm::vec4 sphere = computeWorldBoundingSphere(*model, world);
+
+				objects[i] = VisibleObject{ model, &world, entities[i] };
+				block.centerX[lane] = sphere.x;
+				block.centerY[lane] = sphere.y;
+				block.centerZ[lane] = sphere.z;
+				block.radius[lane] = sphere.w;
+			}
+		});
+
+		for (uint32_t i = objectCount; i < blockCount * BLOCK_SIZE; i++)
+		{
+			BoundsBlock& block = boundsBlocks[i / BLOCK_SIZE];
+			uint32_t lane = i % BLOCK_SIZE;
+			block.centerX[lane] = block.centerY[lane] = block.centerZ[lane] = 0.0f;
+			block.radius[lane] = neverVisible;
+		}
+	}
+
+	const std::vector<VisibleObject>& CullingSystem::cull(EntityRegistry& registry, const Camera& camera, float viewportHeight)
+	{
+		//Objects point into both pools, adding or removing either component moves them
+		if (boundsDirty || 
+			registry.getPool<ModelComponent>().getVersion() != modelPoolVersion || 
+			registry.getPool<WorldTransformComponent>().getVersion() != worldPoolVersion)
+		{
+			rebuildBounds(registry);
+		}
+
+		const std::array<glm::vec4, 6> planes = camera.getFrustumPlanes();
+		uint32_t blockCount = static_cast<uint32_t>(boundsBlocks.size());
+
+		//Camera looks down +z in view space, a sphere of radius r at depth z covers r * pixelScale / z pixels
+		const glm::mat4& view = camera.getView();
+		const glm::vec4 depthRow{ view[0][2], view[1][2], view[2][2], view[3][2] };
+		const float pixelScale = camera.getProjection()[1][1] * viewportHeight * 0.5f;
+
+		_threadPoolRef.parallelFor(blockCount, MIN_OBJECTS_PER_CHUNK / BLOCK_SIZE, [&](uint32_t begin, uint32_t end)
+		{
+			FloatLanes planeX[6], planeY[6], planeZ[6], planeW[6];
+			for (int p = 0; p < 6; p++)
+			{
+				planeX[p] = set1(planes[p].x);
+				planeY[p] = set1(planes[p].y);
+				planeZ[p] = set1(planes[p].z);
+				planeW[p] = set1(planes[p].w);
+			}
+
+			for (uint32_t b = begin; b < end; b++)
+			{
+				const BoundsBlock& block = boundsBlocks[b];
+				uint32_t mask = 0;
+
+				//A sphere is outside once its center lies further than its radius behind any plane
+				for (uint32_t base = 0; base < BLOCK_SIZE; base += LANE_WIDTH)
+				{
+					FloatLanes x = load(&block.centerX[base]);
+					FloatLanes y = load(&block.centerY[base]);
+					FloatLanes z = load(&block.centerZ[base]);
+					FloatLanes negativeRadius = sub(set1(0.0f), load(&block.radius[base]));
+
+					FloatLanes inside{};
+					for (int p = 0; p < 6; p++)
+					{
+						FloatLanes distance = add(add(mul(planeX[p], x), mul(planeY[p], y)), add(mul(planeZ[p], z), planeW[p]));
+						FloatLanes planeInside = greaterEqual(distance, negativeRadius);
+						inside = p == 0 ? planeInside : both(inside, planeInside);
+					}
+					mask |= maskBits(inside) << base;
+				}
+
+				visibilityMasks[b] = static_cast<uint8_t>(mask);
+
+				for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1)
+				{
+					if ((mask & 1) == 0) continue;
+
+					uint32_t i = b * BLOCK_SIZE + lane;
+					float radius = block.radius[lane];
+					float depth = depthRow.x * block.centerX[lane] + depthRow.y * block.centerY[lane] + depthRow.z * block.centerZ[lane] + depthRow.w;
+
+					//Full detail once the camera is inside the bounds
+					uint32_t lod = 0;
+					if (depth > radius)
+					{
+						lod = objects[i].model->selectLod(radius * pixelScale / depth, MAX_LOD_PIXEL_ERROR, lodLevels[i]);
+					}
+					lodLevels[i] = static_cast<uint8_t>(lod);
+				}
+			}
+		});
+
+		visibleObjects.clear();
+		for (uint32_t b = 0; b < blockCount; b++)
+		{
+			uint32_t mask = visibilityMasks[b];
+			for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1)
+			{
+				if ((mask & 1) == 0) continue;
+
+				uint32_t i = b * BLOCK_SIZE + lane;
+				visibleObjects.push_back(objects[i]);
+				visibleObjects.back().lod = lodLevels[i];
+			}
+		}
+
+		return visibleObjects;
+	}
+}
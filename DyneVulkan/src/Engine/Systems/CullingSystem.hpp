@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../../VulkanBackend/DyneModel.hpp"
+#include "../../Utility/DyneThreadPool.hpp"
+#include "../Components.hpp"
+#include "../EntityRegistry.hpp"
+#include "../Camera.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Dyne
+{
+    struct VisibleObject
+    {
+        DyneModel* model = nullptr;
+        const WorldTransformComponent* transform = nullptr;
+        // Its components are looked up when drawing, so texture changes need no invalidate()
+        uint32_t entityIndex = Entity::INVALID_INDEX;
+        uint32_t lod = 0;
+    };
+
+    // CPU frustum culling for the default render path. World space bounding spheres of every model are
+    // kept packed 8 to a block (structure of arrays), so each plane is tested against a whole block per
+    // SIMD instruction, and big scenes are split across the thread pool.
+    // The bounds are only rebuilt after invalidate() or when models or world transforms were added or removed.
+    // Visible objects also get their level of detail, picked by the size their bounds project to on screen.
+    class CullingSystem
+    {
+    public:
+        static constexpr uint32_t BLOCK_SIZE = 8;
+        // Smallest share of the objects tested by one thread
+        static constexpr uint32_t MIN_OBJECTS_PER_CHUNK = 8192;
+        // Simplification error a level of detail may show on screen
+        static constexpr float MAX_LOD_PIXEL_ERROR = 1.0f;
+
+        explicit CullingSystem(DyneThreadPool& threadPool);
+
+        CullingSystem(const CullingSystem&) = delete;
+        CullingSystem& operator=(const CullingSystem&) = delete;
+
+        // Call after transforms or models changed
+        void invalidate() { boundsDirty = true; }
+
+        // Objects whose bounds intersect the camera frustum, valid until the next cull or registry change.
+        // viewportHeight in pixels, to turn the perspective projection into on screen sizes
+        const std::vector<VisibleObject>& cull(EntityRegistry& registry, const Camera& camera, float viewportHeight);
+
+        uint32_t getObjectCount() const { return static_cast<uint32_t>(objects.size()); }
+
+    private:
+        struct BoundsBlock
+        {
+            alignas(32) float centerX[BLOCK_SIZE];
+            alignas(32) float centerY[BLOCK_SIZE];
+            alignas(32) float centerZ[BLOCK_SIZE];
+            alignas(32) float radius[BLOCK_SIZE];
+        };
+
+        void rebuildBounds(EntityRegistry& registry);
+
+        DyneThreadPool& _threadPoolRef;
+
+        std::vector<VisibleObject> objects;
+        std::vector<BoundsBlock> boundsBlocks;
+        // One bit per object of a block
+        std::vector<uint8_t> visibilityMasks;
+        // Level each object was last drawn at, for the hysteresis. Carried over by entity through rebuilds
+        std::vector<uint8_t> lodLevels;
+        // Entity index of every object, in the order of the last rebuild
+        std::vector<uint32_t> objectEntities;
+        // Scratch for carrying the levels over, indexed by entity
+        std::vector<uint8_t> lodByEntity;
+        std::vector<VisibleObject> visibleObjects;
+        bool boundsDirty = true;
+        // Pool versions the cached objects were built from
+        uint64_t modelPoolVersion = 0;
+        uint64_t worldPoolVersion = 0;
+    };
+}
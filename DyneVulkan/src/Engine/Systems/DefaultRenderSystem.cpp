@@ -1,50 +1,130 @@
 #include "DefaultRenderSystem.hpp"
 
-#include "../GameObject.hpp"
+#include "../Components.hpp"
+#include "../../VulkanBackend/DyneSwapchain.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include "../../Utility/DyneRadixSort.hpp"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <stdexcept>
 
 namespace Dyne
 {
-	struct DefaultPushConstants
+	static_assert(sizeof(InstanceData) == 2 * sizeof(glm::mat4) + sizeof(glm::uvec4), "InstanceData must match the shaders!");
+
+	//Sort key, most significant first: state (pipeline & descriptor sets 7 bits, index type 1) 8 bits | model 16 | lod 3 | depth 21 | object 16.
+	//Sorting groups draws by state, then by model & level of detail for instancing, then front to back against overdraw.
+	//The object index makes every key unique and tells the sorted key where it came from.
+	//Without bindless textures every draw samples one texture, so the texture index takes the top bits of the depth
+	//field there. Instances of a model sharing a texture then stay together and only the coarser depth orders them.
+	namespace
 	{
-		glm::mat4 modelMatrix{ 1.0f };
-		glm::mat4 normalMatrix{ 1.0f };
-	};
+		constexpr uint32_t SORT_STATE_SHIFT = 56;
+		constexpr uint32_t SORT_MODEL_SHIFT = 40;
+		constexpr uint32_t SORT_LOD_SHIFT = 37;
+		constexpr uint32_t SORT_DEPTH_SHIFT = 16;
+		constexpr uint64_t SORT_MODEL_MASK = 0xFFFF;
+		constexpr uint64_t SORT_LOD_MASK = 0x7;
+		constexpr uint64_t SORT_DEPTH_MASK = 0x1FFFFF;
+		constexpr uint64_t SORT_INDEX_MASK = 0xFFFF;
+		//Texture 8 bits | depth 13 within the depth field
+		constexpr uint32_t SORT_TEXTURE_SHIFT = 13;
+		constexpr uint32_t SORT_TEXTURE_BITS = 8;
+		constexpr uint64_t SORT_TEXTURE_MASK = 0xFF;
+
+		constexpr uint32_t LIT_PIPELINE_STATE = 0;
+
+		//Models with the same index type share the bound index buffer
+		uint32_t makeDrawState(uint32_t pipelineState, VkIndexType indexType)
+		{
+			return (pipelineState << 1) | (indexType == VK_INDEX_TYPE_UINT32 ? 1u : 0u);
+		}
 
-	DefaultRenderSystem::DefaultRenderSystem(DyneDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : _deviceRef(device)
+		static_assert(DefaultRenderSystem::MAX_INSTANCES - 1 <= SORT_INDEX_MASK, "Object index doesn't fit in the sort key!");
+		static_assert(DyneModel::MAX_LODS - 1 <= SORT_LOD_MASK, "Level of detail doesn't fit in the sort key!");
+		static_assert(DyneTextureRegistry::FIXED_TEXTURE_CAPACITY - 1 <= SORT_TEXTURE_MASK, "Texture index doesn't fit in the sort key!");
+		static_assert(((SORT_TEXTURE_MASK << SORT_TEXTURE_SHIFT) | (SORT_DEPTH_MASK >> SORT_TEXTURE_BITS)) == SORT_DEPTH_MASK, "Texture & depth must fill the depth field!");
+
+		//Model ids only keep their low bits, models sharing them still draw correctly but may split into more runs
+		uint64_t makeSortKey(uint32_t state, uint32_t modelId, uint32_t lod, uint64_t depth, uint32_t objectIndex)
+		{
+			return (static_cast<uint64_t>(state) << SORT_STATE_SHIFT) |
+				((modelId & SORT_MODEL_MASK) << SORT_MODEL_SHIFT) |
+				(static_cast<uint64_t>(lod) << SORT_LOD_SHIFT) |
+				(depth << SORT_DEPTH_SHIFT) |
+				objectIndex;
+		}
+	}
+
+	DefaultRenderSystem::DefaultRenderSystem(
+		DyneDevice& device, 
+		DynePipelineCompiler& pipelineCompiler, 
+		VkRenderPass renderPass, 
+		VkDescriptorSetLayout globalSetLayout,
+		const DyneTextureRegistry& textureRegistry,
+		VertexFormat vertexFormat) : _deviceRef(device), splitRunsByTexture(!textureRegistry.isBindless())
 	{
-		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		createInstanceBuffers();
+		createPipelineLayout(globalSetLayout, textureRegistry.getDescriptorSetLayout());
+		createPipeline(pipelineCompiler, renderPass, textureRegistry.getFragmentShader(), vertexFormat);
 	}
 
 	DefaultRenderSystem::~DefaultRenderSystem()
 	{
+		//The compile job still uses the layout
+		pipeline.wait();
 		vkDestroyPipelineLayout(_deviceRef.device(), pipelineLayout, nullptr);
 	}
 
-	void DefaultRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	void DefaultRenderSystem::createInstanceBuffers()
 	{
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(DefaultPushConstants);
+		instancePool = DyneDescriptorPool::Builder(_deviceRef)
+			.setMaxSets(DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.build();
+
+		instanceSetLayout = DyneDescriptorSetLayout::Builder(_deviceRef)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+			.build();
 
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+		instanceBuffers.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		instanceDescriptorSets.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		for (int i = 0; i < instanceBuffers.size(); i++)
+		{
+			instanceBuffers[i] = std::make_unique<DyneBuffer>
+				(
+					_deviceRef,
+					sizeof(InstanceData),
+					MAX_INSTANCES,
+					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+				);
+			instanceBuffers[i]->map();
+
+			auto bufferInfo = instanceBuffers[i]->descriptorInfo();
+			DyneDescriptorWriter(*instanceSetLayout, *instancePool)
+				.writeBuffer(0, &bufferInfo)
+				.build(instanceDescriptorSets[i]);
+		}
+	}
+
+	void DefaultRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout textureSetLayout)
+	{
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout, instanceSetLayout->getDescriptorSetLayout(), textureSetLayout };
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		if (vkCreatePipelineLayout(_deviceRef.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 		{
@@ -52,57 +132,158 @@ namespace Dyne
 		}
 	}
 
-	void DefaultRenderSystem::createPipeline(VkRenderPass renderPass)
+	void DefaultRenderSystem::createPipeline(DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass, const char* fragmentShader, VertexFormat vertexFormat)
 	{
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout!");
 
 		PipelineConfigInfo pipelineConfig{};
-		DynePipeline::defaultPipelineConfigInfo(pipelineConfig);
+		DynePipeline::defaultPipelineConfigInfo(pipelineConfig, vertexFormat);
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
-		pipeline = std::make_unique<DynePipeline>(
-			_deviceRef,
-			"shaders/shader.vert.spv",
-			"shaders/shader.frag.spv",
-			pipelineConfig);
+		pipeline = DynePendingPipeline<DynePipeline>(pipelineCompiler.compileGraphics(
+			getVertexFormatInfo(vertexFormat).vertexShader,
+			fragmentShader,
+			pipelineConfig));
+	}
+
+	void DefaultRenderSystem::renderGameObjects(FrameInfo& frameInfo, const std::vector<VisibleObject>& visibleObjects)
+	{
+		DynePipeline* activePipeline = pipeline.get();
+		if (visibleObjects.empty() || activePipeline == nullptr) return;
+
+		uint32_t instanceCount = buildDrawList(frameInfo, visibleObjects);
+
+		frameInfo.commandRecorder.record(
+			frameInfo.commandBuffer,
+			instanceCount,
+			MIN_INSTANCES_PER_CHUNK,
+			[&](VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end)
+			{
+				recordInstances(frameInfo, *activePipeline, commandBuffer, begin, end);
+			});
+
+		instanceBuffers[frameInfo.frameIndex]->flush();
 	}
 
-	void DefaultRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+	uint32_t DefaultRenderSystem::buildDrawList(FrameInfo& frameInfo, const std::vector<VisibleObject>& visibleObjects)
 	{
-		pipeline->bind(frameInfo.commandBuffer);
-		vkCmdBindDescriptorSets
-		(
-			frameInfo.commandBuffer, 
-			VK_PIPELINE_BIND_POINT_GRAPHICS, 
-			pipelineLayout, 
-			0, 1, 
-			&frameInfo.globalDescriptorSet, 
-			0, 
-			nullptr
-		);
-
-		for (auto& kv : frameInfo.gameObjects)
+		assert(visibleObjects.size() <= MAX_INSTANCES && "Instance count exceeds maximum amount!");
+		uint32_t objectCount = static_cast<uint32_t>(std::min<size_t>(visibleObjects.size(), MAX_INSTANCES));
+
+		//Camera looks down +z in view space, so the view z row gives the distance along the view direction
+		const glm::mat4& view = frameInfo.camera.getView();
+		const glm::vec4 depthRow{ view[0][2], view[1][2], view[2][2], view[3][2] };
+		const float depthScale = static_cast<float>(SORT_DEPTH_MASK) / frameInfo.camera.getFarClip();
+
+		auto& modelPool = frameInfo.registry.getPool<ModelComponent>();
+		sortKeys.resize(objectCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			const VisibleObject& object = visibleObjects[i];
+			float depth = glm::dot(depthRow, object.transform->modelMatrix[3]);
+			uint64_t quantizedDepth = static_cast<uint64_t>(glm::clamp(depth * depthScale, 0.0f, static_cast<float>(SORT_DEPTH_MASK)));
+			if (splitRunsByTexture)
+			{
+				uint64_t textureIndex = modelPool.get(object.entityIndex).textureIndex & SORT_TEXTURE_MASK;
+				quantizedDepth = (textureIndex << SORT_TEXTURE_SHIFT) | (quantizedDepth >> SORT_TEXTURE_BITS);
+			}
+
+			uint32_t state = makeDrawState(LIT_PIPELINE_STATE, object.model->getIndexType());
+			sortKeys[i] = makeSortKey(state, object.model->getId(), object.lod, quantizedDepth, i);
+		}
+		radixSort(sortKeys, sortScratch);
+
+		//Instances go out in key order, a new run starts wherever the state, the model, the level or the texture changes
+		instanceObjects.resize(objectCount);
+		instanceTextures.resize(objectCount);
+		drawRuns.clear();
+		for (uint32_t instance = 0; instance < objectCount; instance++)
 		{
-			auto& obj = kv.second;
-
-			if (obj.model == nullptr) continue;
-
-			DefaultPushConstants push{};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
-
-			vkCmdPushConstants
-			(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(DefaultPushConstants),
-				&push
-			);
-
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
+			uint64_t key = sortKeys[instance];
+			const VisibleObject& object = visibleObjects[key & SORT_INDEX_MASK];
+			uint32_t state = static_cast<uint32_t>(key >> SORT_STATE_SHIFT);
+			instanceObjects[instance] = &object;
+			instanceTextures[instance] = modelPool.get(object.entityIndex).textureIndex;
+			uint32_t textureIndex = splitRunsByTexture ? instanceTextures[instance] : 0;
+
+			if (drawRuns.empty() || 
+				drawRuns.back().model != object.model || 
+				drawRuns.back().lod != object.lod || 
+				drawRuns.back().state != state || 
+				drawRuns.back().textureIndex != textureIndex)
+			{
+				drawRuns.push_back(DrawRun{ object.model, state, object.lod, textureIndex, instance, 0 });
+			}
+			drawRuns.back().instanceCount++;
+		}
+
+		return objectCount;
+	}
+
+	void DefaultRenderSystem::recordInstances(
+		FrameInfo& frameInfo,
+		DynePipeline& activePipeline,
+		VkCommandBuffer commandBuffer,
+		uint32_t begin,
+		uint32_t end)
+	{
+		InstanceData* instances = static_cast<InstanceData*>(instanceBuffers[frameInfo.frameIndex]->getMappedMemory());
+		for (uint32_t instance = begin; instance < end; instance++)
+		{
+			const VisibleObject& object = *instanceObjects[instance];
+			instances[instance].modelMatrix = object.transform->modelMatrix;
+			instances[instance].normalMatrix = object.transform->normalMatrix;
+			instances[instance].material = glm::uvec4(instanceTextures[instance], 0u, 0u, 0u);
+		}
+
+		//Last run starting at or before begin
+		auto runIt = std::upper_bound(drawRuns.begin(), drawRuns.end(), begin, [](uint32_t instance, const DrawRun& run)
+		{
+			return instance < run.firstInstance;
+		}) - 1;
+
+		//Secondary buffers start without any state, after that only changes are bound
+		constexpr uint32_t NOTHING_BOUND = ~0u;
+		uint32_t boundPipelineState = NOTHING_BOUND;
+		DyneGeometryPool* boundGeometry = nullptr;
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		for (; runIt != drawRuns.end() && runIt->firstInstance < end; ++runIt)
+		{
+			const DrawRun& run = *runIt;
+			uint32_t runBegin = std::max(begin, run.firstInstance);
+			uint32_t runFinish = std::min(end, run.firstInstance + run.instanceCount);
+			if (runBegin >= runFinish) continue;
+
+			uint32_t pipelineState = run.state >> 1;
+			if (pipelineState != boundPipelineState)
+			{
+				//The lit pipeline & its sets are the only state so far
+				assert(pipelineState == LIT_PIPELINE_STATE && "Unknown draw state!");
+				activePipeline.bind(commandBuffer);
+
+				std::array<VkDescriptorSet, 3> descriptorSets{ frameInfo.globalDescriptorSet, instanceDescriptorSets[frameInfo.frameIndex], frameInfo.textureDescriptorSet };
+				vkCmdBindDescriptorSets
+				(
+					commandBuffer, 
+					VK_PIPELINE_BIND_POINT_GRAPHICS, 
+					pipelineLayout, 
+					0, static_cast<uint32_t>(descriptorSets.size()), 
+					descriptorSets.data(), 
+					0, 
+					nullptr
+				);
+				boundPipelineState = pipelineState;
+			}
+
+			if (&run.model->getGeometryPool() != boundGeometry || run.model->getIndexType() != boundIndexType)
+			{
+				run.model->bind(commandBuffer);
+				boundGeometry = &run.model->getGeometryPool();
+				boundIndexType = run.model->getIndexType();
+			}
+
+			run.model->draw(commandBuffer, runFinish - runBegin, runBegin, run.lod);
 		}
 	}
 }
\ No newline at end of file
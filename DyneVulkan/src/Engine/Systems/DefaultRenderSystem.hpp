@@ -1,10 +1,15 @@
 #pragma once
 
 #include "../../VulkanBackend/DynePipeline.hpp"
+#include "../../VulkanBackend/DynePipelineCompiler.hpp"
 #include "../../VulkanBackend/DyneFrameInfo.hpp"
 #include "../../VulkanBackend/DyneModel.hpp"
-#include "../GameObject.hpp"
+#include "../../VulkanBackend/DyneBuffer.hpp"
+#include "../../VulkanBackend/DyneDescriptors.hpp"
+#include "../../VulkanBackend/DyneTextureRegistry.hpp"
+#include "../Components.hpp"
 #include "../Camera.hpp"
+#include "CullingSystem.hpp"
 
 #include <iostream>
 #include <cstdlib>
@@ -17,24 +22,66 @@ namespace Dyne
     class DefaultRenderSystem
     {
     public:
+        //Per-frame capacity of the instance buffer, 144 bytes per instance
+        static constexpr uint32_t MAX_INSTANCES = 65536;
+        //Smallest share of the instances recorded by one thread, below it the threading overhead dominates
+        static constexpr uint32_t MIN_INSTANCES_PER_CHUNK = 512;
 
-        DefaultRenderSystem(DyneDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        //vertexFormat must be the one of the geometry pool the models live in, objects sample textureRegistry's table
+        DefaultRenderSystem(DyneDevice& device, DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, const DyneTextureRegistry& textureRegistry, VertexFormat vertexFormat);
         ~DefaultRenderSystem();
 
         DefaultRenderSystem(const DefaultRenderSystem&) = delete;
         DefaultRenderSystem operator=(const DefaultRenderSystem&) = delete;
 
-        void renderGameObjects(FrameInfo& frameInfo);
+        //Sorts the visible objects by state, model, level of detail & front to back depth and issues one instanced draw per
+        //run of equal state, model & level, draws nothing until the pipeline is compiled. Textures only split runs when the
+        //table isn't bindless.
+        //The instances are split across the frame's command recorder, the render pass must take secondary buffers.
+        void renderGameObjects(FrameInfo& frameInfo, const std::vector<VisibleObject>& visibleObjects);
+        bool isReady() { return pipeline.isReady(); }
 
 
     private:
-        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        //Consecutive sorted instances that share their state, model & level of detail, drawn with one instanced call
+        struct DrawRun
+        {
+            DyneModel* model = nullptr;
+            uint32_t state = 0;
+            uint32_t lod = 0;
+            //Only compared when the texture index has to be uniform across a draw
+            uint32_t textureIndex = 0;
+            uint32_t firstInstance = 0;
+            uint32_t instanceCount = 0;
+        };
+
+        void createInstanceBuffers();
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout textureSetLayout);
+        void createPipeline(DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass, const char* fragmentShader, VertexFormat vertexFormat);
+        //Writes & draws instances [begin, end), called from several threads at once
+        void recordInstances(FrameInfo& frameInfo, DynePipeline& activePipeline, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end);
+        //Sorts the visible objects by key and splits them into draw runs
+        uint32_t buildDrawList(FrameInfo& frameInfo, const std::vector<VisibleObject>& visibleObjects);
 
         DyneDevice& _deviceRef;
+        //Without descriptor indexing every draw must sample a single texture
+        bool splitRunsByTexture;
 
-        std::unique_ptr<DynePipeline> pipeline;
+        DynePendingPipeline<DynePipeline> pipeline;
         VkPipelineLayout pipelineLayout;
+
+        std::unique_ptr<DyneDescriptorPool> instancePool{};
+        std::unique_ptr<DyneDescriptorSetLayout> instanceSetLayout{};
+        std::vector<std::unique_ptr<DyneBuffer>> instanceBuffers;
+        std::vector<VkDescriptorSet> instanceDescriptorSets;
+
+        //Reused between frames so sorting doesn't reallocate
+        std::vector<uint64_t> sortKeys;
+        std::vector<uint64_t> sortScratch;
+        std::vector<const VisibleObject*> instanceObjects;
+        //Texture slot of every instance, read from the registry before the workers record
+        std::vector<uint32_t> instanceTextures;
+        std::vector<DrawRun> drawRuns;
     };
 }
 
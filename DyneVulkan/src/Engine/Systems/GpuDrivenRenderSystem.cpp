@@ -0,0 +1,617 @@
+#include "GpuDrivenRenderSystem.hpp"
+
+#include "../Components.hpp"
+#include "../../VulkanBackend/DyneSwapchain.hpp"
+#include "../../VulkanBackend/DyneUploadContext.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace Dyne
+{
+	//Layouts match the structs in cull.comp and meshlet_cull.comp (std430), InstanceData is shared with shader.vert
+	struct GpuCullData
+	{
+		glm::vec4 boundingSphere{ 0.0f };
+		uint32_t batchIndex = 0;
+		uint32_t pad[3]{};
+	};
+
+	struct GpuBatchData
+	{
+		uint32_t indexCount = 0;
+		uint32_t firstIndex = 0;
+		int32_t vertexOffset = 0;
+		//Draws with 32 bit indices go to the second command region
+		uint32_t wideIndices = 0;
+	};
+
+	struct GpuMeshletData
+	{
+		glm::vec4 boundingSphere{ 0.0f };
+		//xyz = axis, w = sine of the half angle
+		glm::vec4 cone{ 0.0f, 0.0f, 1.0f, 1.0f };
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		uint32_t pad[2]{};
+	};
+
+	struct CullPushConstants
+	{
+		glm::vec4 frustumPlanes[6];
+		uint32_t objectCount;
+		uint32_t wideRegionOffset;
+	};
+
+	struct ClusterCullPushConstants
+	{
+		glm::mat4 view;
+		//P00, P11, P30, P31, the projection terms of view space x & y
+		glm::vec4 projection;
+		glm::vec2 viewportSize;
+		float nearClip;
+		float farClip;
+		uint32_t clusterCount;
+		uint32_t wideRegionOffset;
+		uint32_t orthographic;
+	};
+	static_assert(sizeof(ClusterCullPushConstants) <= 128, "Push constants above the guaranteed minimum size!");
+
+	//Draw commands are split by index type, each region is drawn with its index buffer bound
+	static constexpr std::array<VkIndexType, 2> REGION_INDEX_TYPES{ VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 };
+
+	static constexpr uint32_t CULL_WORKGROUP_SIZE = 64;
+	static constexpr uint32_t MIN_OBJECT_CAPACITY = 1024;
+	static constexpr uint32_t MIN_BATCH_CAPACITY = 64;
+	static constexpr uint32_t MIN_MESHLET_CAPACITY = 1024;
+	static constexpr uint32_t MIN_CLUSTER_CAPACITY = 4096;
+
+	static uint32_t nextCapacity(uint32_t required, uint32_t minimum)
+	{
+		uint32_t capacity = minimum;
+		while (capacity < required) capacity *= 2;
+		return capacity;
+	}
+
+	GpuDrivenRenderSystem::GpuDrivenRenderSystem(
+		DyneDevice& device, 
+		DynePipelineCompiler& pipelineCompiler, 
+		VkRenderPass renderPass, 
+		VkDescriptorSetLayout globalSetLayout,
+		const DyneTextureRegistry& textureRegistry,
+		VertexFormat vertexFormat) : _deviceRef(device)
+	{
+		assert(device.supportsGpuDrivenRendering() && "Device lacks multiDrawIndirect / drawIndirectFirstInstance!");
+
+		createDescriptorSetLayout();
+		createPipelineLayouts(globalSetLayout, textureRegistry.getDescriptorSetLayout());
+		createPipelines(pipelineCompiler, renderPass, textureRegistry.getFragmentShader(), vertexFormat);
+		createDrawCountBuffers();
+	}
+
+	GpuDrivenRenderSystem::~GpuDrivenRenderSystem()
+	{
+		//The compile jobs still use the layouts
+		pipeline.wait();
+		cullPipeline.wait();
+		clusterCullPipeline.wait();
+		vkDestroyPipelineLayout(_deviceRef.device(), pipelineLayout, nullptr);
+		vkDestroyPipelineLayout(_deviceRef.device(), cullPipelineLayout, nullptr);
+		vkDestroyPipelineLayout(_deviceRef.device(), clusterCullPipelineLayout, nullptr);
+	}
+
+	void GpuDrivenRenderSystem::createDescriptorSetLayout()
+	{
+		cullPool = DyneDescriptorPool::Builder(_deviceRef)
+			.setMaxSets(DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 7 * DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.build();
+
+		//Binding 0 doubles as the instance buffer read by shader.vert through set 1, 5 & 6 are only read by the meshlet pass
+		cullSetLayout = DyneDescriptorSetLayout::Builder(_deviceRef)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.build();
+
+		cullDescriptorSets.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+		drawCommandBuffers.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		drawCountBuffers.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+	}
+
+	void GpuDrivenRenderSystem::createPipelineLayouts(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout textureSetLayout)
+	{
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout, cullSetLayout->getDescriptorSetLayout(), textureSetLayout };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+		if (vkCreatePipelineLayout(_deviceRef.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(CullPushConstants);
+
+		VkDescriptorSetLayout cullLayout = cullSetLayout->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo cullLayoutInfo{};
+		cullLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		cullLayoutInfo.setLayoutCount = 1;
+		cullLayoutInfo.pSetLayouts = &cullLayout;
+		cullLayoutInfo.pushConstantRangeCount = 1;
+		cullLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(_deviceRef.device(), &cullLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create cull pipeline layout!");
+		}
+
+		//Same set, larger push constants
+		VkPushConstantRange clusterPushConstantRange = pushConstantRange;
+		clusterPushConstantRange.size = sizeof(ClusterCullPushConstants);
+		VkPipelineLayoutCreateInfo clusterCullLayoutInfo = cullLayoutInfo;
+		clusterCullLayoutInfo.pPushConstantRanges = &clusterPushConstantRange;
+
+		if (vkCreatePipelineLayout(_deviceRef.device(), &clusterCullLayoutInfo, nullptr, &clusterCullPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create cluster cull pipeline layout!");
+		}
+	}
+
+	void GpuDrivenRenderSystem::createPipelines(DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass, const char* fragmentShader, VertexFormat vertexFormat)
+	{
+		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout!");
+
+		PipelineConfigInfo pipelineConfig{};
+		DynePipeline::defaultPipelineConfigInfo(pipelineConfig, vertexFormat);
+		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.pipelineLayout = pipelineLayout;
+		pipeline = DynePendingPipeline<DynePipeline>(pipelineCompiler.compileGraphics(
+			getVertexFormatInfo(vertexFormat).vertexShader,
+			fragmentShader,
+			pipelineConfig));
+
+		cullPipeline = DynePendingPipeline<DyneComputePipeline>(pipelineCompiler.compileCompute(
+			"shaders/cull.comp.spv",
+			cullPipelineLayout));
+
+		clusterCullPipeline = DynePendingPipeline<DyneComputePipeline>(pipelineCompiler.compileCompute(
+			"shaders/meshlet_cull.comp.spv",
+			clusterCullPipelineLayout));
+	}
+
+	void GpuDrivenRenderSystem::createDrawCountBuffers()
+	{
+		for (auto& countBuffer : drawCountBuffers)
+		{
+			countBuffer = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(uint32_t),
+				static_cast<uint32_t>(REGION_INDEX_TYPES.size()),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+	}
+
+	void GpuDrivenRenderSystem::ensureCapacity(uint32_t requiredObjects, uint32_t requiredBatches, uint32_t requiredMeshlets, uint32_t requiredClusters)
+	{
+		if (requiredObjects <= objectCapacity && 
+			requiredBatches <= batchCapacity && 
+			requiredMeshlets <= meshletCapacity && 
+			requiredClusters <= clusterCapacity) return;
+
+		//Frames in flight still use the old buffers and descriptor sets
+		vkDeviceWaitIdle(_deviceRef.device());
+
+		if (requiredObjects > objectCapacity || requiredClusters > clusterCapacity)
+		{
+			objectCapacity = std::max(objectCapacity, nextCapacity(requiredObjects, MIN_OBJECT_CAPACITY));
+			clusterCapacity = std::max(clusterCapacity, nextCapacity(requiredClusters, MIN_CLUSTER_CAPACITY));
+
+			instanceBuffer = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(InstanceData),
+				objectCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			cullDataBuffer = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(GpuCullData),
+				objectCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			clusterBuffer = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(glm::uvec2),
+				clusterCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			//At most one command per object culled whole and one per meshlet
+			for (auto& commandBuffer : drawCommandBuffers)
+			{
+				commandBuffer = std::make_unique<DyneBuffer>(
+					_deviceRef,
+					sizeof(VkDrawIndexedIndirectCommand),
+					objectCapacity + clusterCapacity,
+					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			}
+		}
+
+		if (requiredBatches > batchCapacity)
+		{
+			batchCapacity = nextCapacity(requiredBatches, MIN_BATCH_CAPACITY);
+
+			batchBuffer = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(GpuBatchData),
+				batchCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+
+		if (meshletBuffer == nullptr || requiredMeshlets > meshletCapacity)
+		{
+			meshletCapacity = nextCapacity(requiredMeshlets, MIN_MESHLET_CAPACITY);
+
+			meshletBuffer = std::make_unique<DyneBuffer>(
+				_deviceRef,
+				sizeof(GpuMeshletData),
+				meshletCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+
+		writeDescriptorSets();
+	}
+
+	void GpuDrivenRenderSystem::writeDescriptorSets()
+	{
+		for (int i = 0; i < cullDescriptorSets.size(); i++)
+		{
+			auto instanceInfo = instanceBuffer->descriptorInfo();
+			auto cullInfo = cullDataBuffer->descriptorInfo();
+			auto batchInfo = batchBuffer->descriptorInfo();
+			auto commandInfo = drawCommandBuffers[i]->descriptorInfo();
+			auto countInfo = drawCountBuffers[i]->descriptorInfo();
+			auto meshletInfo = meshletBuffer->descriptorInfo();
+			auto clusterInfo = clusterBuffer->descriptorInfo();
+
+			DyneDescriptorWriter writer(*cullSetLayout, *cullPool);
+			writer.writeBuffer(0, &instanceInfo)
+				.writeBuffer(1, &cullInfo)
+				.writeBuffer(2, &batchInfo)
+				.writeBuffer(3, &commandInfo)
+				.writeBuffer(4, &countInfo)
+				.writeBuffer(5, &meshletInfo)
+				.writeBuffer(6, &clusterInfo);
+
+			if (cullDescriptorSets[i] == VK_NULL_HANDLE)
+			{
+				writer.build(cullDescriptorSets[i]);
+			}
+			else
+			{
+				writer.overwrite(cullDescriptorSets[i]);
+			}
+		}
+	}
+
+	void GpuDrivenRenderSystem::rebuildObjectData(EntityRegistry& registry)
+	{
+		//One batch entry per distinct model, objects refer to it by index
+		std::unordered_map<DyneModel*, uint32_t> batchLookup;
+		std::vector<uint32_t> objectBatches;
+		std::vector<WorldTransformComponent*> transforms;
+		std::vector<uint32_t> textureIndices;
+		std::vector<uint32_t> clusterObjectBatches;
+		std::vector<WorldTransformComponent*> clusterTransforms;
+		std::vector<uint32_t> clusterTextureIndices;
+		batchModels.clear();
+
+		registry.each<ModelComponent, WorldTransformComponent>([&](Entity, ModelComponent& model, WorldTransformComponent& transform)
+		{
+			if (model.model == nullptr) return;
+
+			assert(model.model->hasIndices() && "GPU driven rendering requires indexed models!");
+
+			auto it = batchLookup.find(model.model.get());
+			if (it == batchLookup.end())
+			{
+				it = batchLookup.emplace(model.model.get(), static_cast<uint32_t>(batchModels.size())).first;
+				batchModels.push_back(model.model);
+			}
+
+			if (model.model->getMeshlets().size() >= MIN_CLUSTER_CULLED_MESHLETS)
+			{
+				clusterObjectBatches.push_back(it->second);
+				clusterTransforms.push_back(&transform);
+				clusterTextureIndices.push_back(model.textureIndex);
+			}
+			else
+			{
+				objectBatches.push_back(it->second);
+				transforms.push_back(&transform);
+				textureIndices.push_back(model.textureIndex);
+			}
+		});
+
+		//Objects culled whole come first, so cull.comp only runs over them
+		objectCulledCount = static_cast<uint32_t>(transforms.size());
+		objectBatches.insert(objectBatches.end(), clusterObjectBatches.begin(), clusterObjectBatches.end());
+		transforms.insert(transforms.end(), clusterTransforms.begin(), clusterTransforms.end());
+		textureIndices.insert(textureIndices.end(), clusterTextureIndices.begin(), clusterTextureIndices.end());
+
+		objectCount = static_cast<uint32_t>(transforms.size());
+		clusterCount = 0;
+		if (objectCount == 0) return;
+
+		std::vector<GpuBatchData> batchData(batchModels.size());
+		//First entry in the meshlet buffer of every batch culled per meshlet
+		std::vector<uint32_t> batchMeshletOffsets(batchModels.size(), 0);
+		std::vector<GpuMeshletData> meshletData;
+		for (size_t i = 0; i < batchModels.size(); i++)
+		{
+			batchData[i].indexCount = batchModels[i]->getIndexCount();
+			batchData[i].firstIndex = batchModels[i]->getFirstIndex();
+			batchData[i].vertexOffset = batchModels[i]->getVertexOffset();
+			batchData[i].wideIndices = batchModels[i]->getIndexType() == VK_INDEX_TYPE_UINT32;
+
+			const std::vector<Meshlet>& meshlets = batchModels[i]->getMeshlets();
+			if (meshlets.size() < MIN_CLUSTER_CULLED_MESHLETS) continue;
+
+			batchMeshletOffsets[i] = static_cast<uint32_t>(meshletData.size());
+			for (const Meshlet& meshlet : meshlets)
+			{
+				GpuMeshletData data{};
+				data.boundingSphere = glm::vec4(meshlet.center, meshlet.radius);
+				data.cone = glm::vec4(meshlet.coneAxis, meshlet.coneCutoff);
+				data.firstIndex = meshlet.firstIndex;
+				data.indexCount = meshlet.indexCount;
+				meshletData.push_back(data);
+			}
+		}
+
+		//One entry per meshlet of every object culled per meshlet, each may become a draw
+		std::vector<glm::uvec2> clusters;
+		regionDrawCounts.fill(0);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			uint32_t batch = objectBatches[i];
+			if (i < objectCulledCount)
+			{
+				regionDrawCounts[batchData[batch].wideIndices]++;
+				continue;
+			}
+
+			uint32_t meshletCount = static_cast<uint32_t>(batchModels[batch]->getMeshlets().size());
+			for (uint32_t m = 0; m < meshletCount; m++)
+			{
+				clusters.push_back(glm::uvec2(i, batchMeshletOffsets[batch] + m));
+			}
+			regionDrawCounts[batchData[batch].wideIndices] += meshletCount;
+		}
+		clusterCount = static_cast<uint32_t>(clusters.size());
+
+		assert(objectCulledCount + clusterCount <= _deviceRef.properties.limits.maxDrawIndirectCount && "Draw count exceeds maxDrawIndirectCount!");
+		ensureCapacity(objectCount, static_cast<uint32_t>(batchModels.size()), static_cast<uint32_t>(meshletData.size()), clusterCount);
+
+		std::vector<InstanceData> instanceData(objectCount);
+		std::vector<GpuCullData> cullData(objectCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			instanceData[i].modelMatrix = transforms[i]->modelMatrix;
+			instanceData[i].normalMatrix = transforms[i]->normalMatrix;
+			instanceData[i].material = glm::uvec4(textureIndices[i], 0u, 0u, 0u);
+			cullData[i].boundingSphere = batchModels[objectBatches[i]]->getBoundingSphere();
+			cullData[i].batchIndex = objectBatches[i];
+		}
+
+		//Submitted ahead of this frame's command buffer, the upload batch barriers order it against frames in flight
+		auto& uploadContext = _deviceRef.uploadContext();
+		uploadContext.uploadBuffer(instanceBuffer->getBuffer(), instanceData.data(), sizeof(InstanceData) * objectCount);
+		uploadContext.uploadBuffer(cullDataBuffer->getBuffer(), cullData.data(), sizeof(GpuCullData) * objectCount);
+		uploadContext.uploadBuffer(batchBuffer->getBuffer(), batchData.data(), sizeof(GpuBatchData) * batchData.size());
+		if (clusterCount > 0)
+		{
+			uploadContext.uploadBuffer(meshletBuffer->getBuffer(), meshletData.data(), sizeof(GpuMeshletData) * meshletData.size());
+			uploadContext.uploadBuffer(clusterBuffer->getBuffer(), clusters.data(), sizeof(glm::uvec2) * clusterCount);
+		}
+		uploadContext.submit();
+	}
+
+	void GpuDrivenRenderSystem::cull(FrameInfo& frameInfo, VkExtent2D viewportExtent)
+	{
+		assert(isReady() && "GPU driven pipelines are still compiling!");
+
+		size_t modelCount = frameInfo.registry.count<ModelComponent>();
+		if (builtVersion != sceneVersion || builtModelCount != modelCount)
+		{
+			rebuildObjectData(frameInfo.registry);
+			builtVersion = sceneVersion;
+			builtModelCount = modelCount;
+		}
+
+		if (objectCount == 0) return;
+
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+		auto& drawCommandBuffer = drawCommandBuffers[frameInfo.frameIndex];
+		auto& drawCountBuffer = drawCountBuffers[frameInfo.frameIndex];
+
+		//Reset the count; without a count buffer the unused command slots must draw nothing
+		vkCmdFillBuffer(commandBuffer, drawCountBuffer->getBuffer(), 0, sizeof(uint32_t) * REGION_INDEX_TYPES.size(), 0);
+		if (!_deviceRef.supportsDrawIndirectCount())
+		{
+			vkCmdFillBuffer(commandBuffer, drawCommandBuffer->getBuffer(), 0, sizeof(VkDrawIndexedIndirectCommand) * (objectCulledCount + clusterCount), 0);
+		}
+
+		VkMemoryBarrier clearBarrier{};
+		clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &clearBarrier,
+			0, nullptr,
+			0, nullptr
+		);
+
+		//Both passes append to the same regions, the atomics keep their slots apart
+		if (objectCulledCount > 0)
+		{
+			CullPushConstants push{};
+			auto planes = frameInfo.camera.getFrustumPlanes();
+			for (int i = 0; i < 6; i++)
+			{
+				push.frustumPlanes[i] = planes[i];
+			}
+			push.objectCount = objectCulledCount;
+			push.wideRegionOffset = regionDrawCounts[0];
+
+			cullPipeline.get()->bind(commandBuffer);
+			vkCmdBindDescriptorSets
+			(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_COMPUTE,
+				cullPipelineLayout,
+				0, 1,
+				&cullDescriptorSets[frameInfo.frameIndex],
+				0,
+				nullptr
+			);
+			vkCmdPushConstants
+			(
+				commandBuffer,
+				cullPipelineLayout,
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				0,
+				sizeof(CullPushConstants),
+				&push
+			);
+			vkCmdDispatch(commandBuffer, (objectCulledCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+		}
+
+		if (clusterCount > 0)
+		{
+			const glm::mat4& projection = frameInfo.camera.getProjection();
+
+			ClusterCullPushConstants push{};
+			push.view = frameInfo.camera.getView();
+			push.projection = glm::vec4(projection[0][0], projection[1][1], projection[3][0], projection[3][1]);
+			push.viewportSize = glm::vec2(static_cast<float>(viewportExtent.width), static_cast<float>(viewportExtent.height));
+			push.nearClip = frameInfo.camera.getNearClip();
+			push.farClip = frameInfo.camera.getFarClip();
+			push.clusterCount = clusterCount;
+			push.wideRegionOffset = regionDrawCounts[0];
+			push.orthographic = projection[2][3] == 0.0f;
+
+			clusterCullPipeline.get()->bind(commandBuffer);
+			vkCmdBindDescriptorSets
+			(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_COMPUTE,
+				clusterCullPipelineLayout,
+				0, 1,
+				&cullDescriptorSets[frameInfo.frameIndex],
+				0,
+				nullptr
+			);
+			vkCmdPushConstants
+			(
+				commandBuffer,
+				clusterCullPipelineLayout,
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				0,
+				sizeof(ClusterCullPushConstants),
+				&push
+			);
+			vkCmdDispatch(commandBuffer, (clusterCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+		}
+
+		VkMemoryBarrier cullBarrier{};
+		cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+			0,
+			1, &cullBarrier,
+			0, nullptr,
+			0, nullptr
+		);
+	}
+
+	void GpuDrivenRenderSystem::render(FrameInfo& frameInfo)
+	{
+		if (objectCount == 0) return;
+
+		pipeline.get()->bind(frameInfo.commandBuffer);
+
+		std::array<VkDescriptorSet, 3> descriptorSets{ frameInfo.globalDescriptorSet, cullDescriptorSets[frameInfo.frameIndex], frameInfo.textureDescriptorSet };
+		vkCmdBindDescriptorSets
+		(
+			frameInfo.commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelineLayout,
+			0, static_cast<uint32_t>(descriptorSets.size()),
+			descriptorSets.data(),
+			0,
+			nullptr
+		);
+
+		VkBuffer drawCommandBuffer = drawCommandBuffers[frameInfo.frameIndex]->getBuffer();
+		VkBuffer drawCountBuffer = drawCountBuffers[frameInfo.frameIndex]->getBuffer();
+		constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+		uint32_t regionStart = 0;
+		for (size_t region = 0; region < REGION_INDEX_TYPES.size(); region++)
+		{
+			uint32_t regionSize = regionDrawCounts[region];
+			if (regionSize == 0) continue;
+
+			frameInfo.geometryPool.bind(frameInfo.commandBuffer, REGION_INDEX_TYPES[region]);
+			VkDeviceSize commandOffset = static_cast<VkDeviceSize>(regionStart) * stride;
+
+			if (_deviceRef.supportsDrawIndirectCount())
+			{
+				_deviceRef.cmdDrawIndexedIndirectCount(
+					frameInfo.commandBuffer,
+					drawCommandBuffer, commandOffset,
+					drawCountBuffer, sizeof(uint32_t) * region,
+					regionSize, stride);
+			}
+			else
+			{
+				vkCmdDrawIndexedIndirect(
+					frameInfo.commandBuffer,
+					drawCommandBuffer, commandOffset,
+					regionSize, stride);
+			}
+			regionStart += regionSize;
+		}
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../../VulkanBackend/DynePipeline.hpp"
+#include "../../VulkanBackend/DynePipelineCompiler.hpp"
+#include "../../VulkanBackend/DyneFrameInfo.hpp"
+#include "../../VulkanBackend/DyneModel.hpp"
+#include "../../VulkanBackend/DyneBuffer.hpp"
+#include "../../VulkanBackend/DyneDescriptors.hpp"
+#include "../../VulkanBackend/DyneTextureRegistry.hpp"
+#include "../Components.hpp"
+#include "../Camera.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <stdexcept>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace Dyne
+{
+    // Decides the visible set on the GPU: a compute pass frustum culls every object and appends
+    // VkDrawIndexedIndirectCommands to a compacted list per index type, each drawn by a single indirect
+    // call out of the shared geometry pool. Per-object data is only uploaded when the scene changes, so the
+    // per-frame CPU cost does not depend on the number of objects.
+    // Objects of large models are culled per meshlet instead by a second pass, with frustum, backface cone and
+    // small size tests, and every surviving meshlet gets its own command for its index range.
+    class GpuDrivenRenderSystem
+    {
+    public:
+
+        // vertexFormat must be the one of the geometry pool the models live in, objects sample textureRegistry's table.
+        // Every indirect command draws a single object, so its texture index is uniform across the draw either way
+        GpuDrivenRenderSystem(DyneDevice& device, DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, const DyneTextureRegistry& textureRegistry, VertexFormat vertexFormat);
+        ~GpuDrivenRenderSystem();
+
+        GpuDrivenRenderSystem(const GpuDrivenRenderSystem&) = delete;
+        GpuDrivenRenderSystem operator=(const GpuDrivenRenderSystem&) = delete;
+
+        // Forces the object data to be re-uploaded, call after moving, retargeting or retexturing objects
+        void invalidate() { sceneVersion++; }
+
+        // Models with at least this many meshlets are culled per meshlet, smaller ones aren't worth the extra draws
+        static constexpr uint32_t MIN_CLUSTER_CULLED_MESHLETS = 8;
+
+        // All pipelines compiled, until then the caller falls back to another render system
+        bool isReady() { return pipeline.isReady() && cullPipeline.isReady() && clusterCullPipeline.isReady(); }
+
+        // Must be recorded outside of a render pass, cull & render require isReady()
+        // viewportExtent is needed to reject meshlets too small to cover a pixel center
+        void cull(FrameInfo& frameInfo, VkExtent2D viewportExtent);
+        void render(FrameInfo& frameInfo);
+
+    private:
+        void createDescriptorSetLayout();
+        void createPipelineLayouts(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout textureSetLayout);
+        void createPipelines(DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass, const char* fragmentShader, VertexFormat vertexFormat);
+        void createDrawCountBuffers();
+
+        void rebuildObjectData(EntityRegistry& registry);
+        void ensureCapacity(uint32_t objectCount, uint32_t batchCount, uint32_t meshletCount, uint32_t clusterCount);
+        void writeDescriptorSets();
+
+        DyneDevice& _deviceRef;
+
+        DynePendingPipeline<DynePipeline> pipeline;
+        DynePendingPipeline<DyneComputePipeline> cullPipeline;
+        DynePendingPipeline<DyneComputePipeline> clusterCullPipeline;
+        VkPipelineLayout pipelineLayout;
+        VkPipelineLayout cullPipelineLayout;
+        VkPipelineLayout clusterCullPipelineLayout;
+
+        std::unique_ptr<DyneDescriptorPool> cullPool{};
+        std::unique_ptr<DyneDescriptorSetLayout> cullSetLayout{};
+        std::vector<VkDescriptorSet> cullDescriptorSets;
+
+        // Written only on rebuild, shared by all frames
+        std::unique_ptr<DyneBuffer> instanceBuffer;
+        std::unique_ptr<DyneBuffer> cullDataBuffer;
+        std::unique_ptr<DyneBuffer> batchBuffer;
+        std::unique_ptr<DyneBuffer> meshletBuffer;
+        // Object & meshlet index of every meshlet to cull
+        std::unique_ptr<DyneBuffer> clusterBuffer;
+
+        // Written by the cull pass every frame
+        std::vector<std::unique_ptr<DyneBuffer>> drawCommandBuffers;
+        std::vector<std::unique_ptr<DyneBuffer>> drawCountBuffers;
+
+        // Keeps the referenced mesh ranges alive until the next rebuild
+        std::vector<std::shared_ptr<DyneModel>> batchModels;
+        uint32_t objectCount = 0;
+        // The first objects are culled whole, the rest per meshlet
+        uint32_t objectCulledCount = 0;
+        uint32_t clusterCount = 0;
+        // Command slots for draws with 16 & 32 bit indices, sizes of the two regions
+        std::array<uint32_t, 2> regionDrawCounts{};
+        uint32_t objectCapacity = 0;
+        uint32_t batchCapacity = 0;
+        uint32_t meshletCapacity = 0;
+        uint32_t clusterCapacity = 0;
+
+        uint64_t sceneVersion = 1;
+        uint64_t builtVersion = 0;
+        size_t builtModelCount = 0;
+    };
+}
+
@@ -1,6 +1,6 @@
 #include "PointLightSystem.hpp"
 
-#include "../GameObject.hpp"
+#include "../Components.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -13,39 +13,33 @@
 
 namespace Dyne
 {
-	struct PointLightPushConstants
-	{
-		glm::vec4 position{};
-		glm::vec4 color{};
-		float radius;
-	};
-
-	PointLightRenderSystem::PointLightRenderSystem(DyneDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : _deviceRef(device)
+	PointLightRenderSystem::PointLightRenderSystem(
+		DyneDevice& device, 
+		DynePipelineCompiler& pipelineCompiler, 
+		VkRenderPass renderPass, 
+		VkDescriptorSetLayout globalSetLayout) : _deviceRef(device)
 	{
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		createPipeline(pipelineCompiler, renderPass);
 	}
 
 	PointLightRenderSystem::~PointLightRenderSystem()
 	{
+		//The compile job still uses the layout
+		pipeline.wait();
 		vkDestroyPipelineLayout(_deviceRef.device(), pipelineLayout, nullptr);
 	}
 
 	void PointLightRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
 	{
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(PointLightPushConstants);
-
 		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		if (vkCreatePipelineLayout(_deviceRef.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 		{
@@ -53,7 +47,7 @@ namespace Dyne
 		}
 	}
 
-	void PointLightRenderSystem::createPipeline(VkRenderPass renderPass)
+	void PointLightRenderSystem::createPipeline(DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass)
 	{
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout!");
 
@@ -63,44 +57,18 @@ namespace Dyne
 		pipelineConfig.bindingDescriptions.clear();
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
-		pipeline = std::make_unique<DynePipeline>(
-			_deviceRef,
+		pipeline = DynePendingPipeline<DynePipeline>(pipelineCompiler.compileGraphics(
 			"shaders/pointlight.vert.spv",
 			"shaders/pointlight.frag.spv",
-			pipelineConfig);
+			pipelineConfig));
 	}
 
-	void PointLightRenderSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo)
+	void PointLightRenderSystem::render(FrameInfo& frameInfo, uint32_t lightCount)
 	{
-		auto rotateLight = glm::rotate
-		(
-			glm::mat4(1.0f),
-			frameInfo.frameTime,
-			{ 0.0f, -1.0f, 0.0f }
-		);
-
-		int lightIndex = 0;
-		for (auto& kv : frameInfo.gameObjects)
-		{
-			auto& obj = kv.second;
-			if (obj.pointLight == nullptr) continue;
-
-			assert(lightIndex < MAX_LIGHTS && "Point light count exceeds maximum amount!");
-
-			obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.0f));
+		DynePipeline* activePipeline = pipeline.get();
+		if (activePipeline == nullptr || lightCount == 0) return;
 
-			ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.0f);
-			ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-
-			lightIndex += 1;
-		}
-
-		ubo.numLights = lightIndex;
-	}
-
-	void PointLightRenderSystem::render(FrameInfo& frameInfo)
-	{
-		pipeline->bind(frameInfo.commandBuffer);
+		activePipeline->bind(frameInfo.commandBuffer);
 		vkCmdBindDescriptorSets
 		(
 			frameInfo.commandBuffer,
@@ -111,27 +79,8 @@ namespace Dyne
 			0,
 			nullptr
 		);
-		
-		for (auto& kv : frameInfo.gameObjects)
-		{
-			auto& obj = kv.second;
-			if (obj.pointLight == nullptr) continue;
 
-			PointLightPushConstants push{};
-			push.position = glm::vec4(obj.transform.translation, 1.0f);
-			push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-			push.radius = obj.transform.scale.x;
-
-			vkCmdPushConstants
-			(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PointLightPushConstants),
-				&push
-			);
-			vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
-		}
+		//Positions & colors come from the light buffer in the global set
+		vkCmdDraw(frameInfo.commandBuffer, 6, lightCount, 0, 0);
 	}
 }
\ No newline at end of file
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "../../VulkanBackend/DynePipeline.hpp"
+#include "../../VulkanBackend/DynePipelineCompiler.hpp"
 #include "../../VulkanBackend/DyneFrameInfo.hpp"
 #include "../../VulkanBackend/DyneModel.hpp"
-#include "../GameObject.hpp"
+#include "../Components.hpp"
 #include "../Camera.hpp"
 
 #include <iostream>
@@ -18,22 +19,22 @@ namespace Dyne
     {
     public:
 
-        PointLightRenderSystem(DyneDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        PointLightRenderSystem(DyneDevice& device, DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
         ~PointLightRenderSystem();
 
         PointLightRenderSystem(const PointLightRenderSystem&) = delete;
         PointLightRenderSystem operator=(const PointLightRenderSystem&) = delete;
 
-        void update(FrameInfo& frameInfo, GlobalUbo& ubo);
-        void render(FrameInfo& frameInfo);
+        //Draws one billboard per light in the light buffer, skipped until the pipeline is compiled
+        void render(FrameInfo& frameInfo, uint32_t lightCount);
 
     private:
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(DynePipelineCompiler& pipelineCompiler, VkRenderPass renderPass);
 
         DyneDevice& _deviceRef;
 
-        std::unique_ptr<DynePipeline> pipeline;
+        DynePendingPipeline<DynePipeline> pipeline;
         VkPipelineLayout pipelineLayout;
     };
 }
@@ -0,0 +1,215 @@
+#include "TextureStreamingSystem.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+namespace Dyne
+{
+	TextureStreamingSystem::TextureStreamingSystem(AssetStreamer& assetStreamer, DyneTextureRegistry& textureRegistry, VkDeviceSize budgetBytes)
+		: _assetStreamerRef(assetStreamer), _textureRegistryRef(textureRegistry), budget(budgetBytes)
+	{
+		slotTextures.resize(textureRegistry.getCapacity(), NOT_STREAMED);
+	}
+
+	uint32_t TextureStreamingSystem::requestTexture(const std::string& filepath)
+	{
+		uint32_t slot = _textureRegistryRef.add(_textureRegistryRef.getDefaultTexture());
+		uint32_t textureIndex = static_cast<uint32_t>(textures.size());
+		slotTextures[slot] = textureIndex;
+
+		StreamedTexture& texture = textures.emplace_back();
+		texture.filepath = filepath;
+		texture.slot = slot;
+
+		//Only the tail comes first, the chain is unknown until its header was read
+		request(textureIndex, 0, TAIL_EXTENT);
+		return slot;
+	}
+
+	void TextureStreamingSystem::request(uint32_t textureIndex, uint32_t requestedLod, uint32_t maxExtent)
+	{
+		textures[textureIndex].requestedLod = requestedLod;
+		pendingRequests++;
+
+		_assetStreamerRef.requestTexture(textures[textureIndex].filepath, [this, textureIndex](std::shared_ptr<DyneTexture> image)
+		{
+			StreamedTexture& texture = textures[textureIndex];
+			if (texture.levelBytes.empty())
+			{
+				//The tail's image starts at the first level small enough, everything past it stays for good
+				texture.width = image->sourceWidth();
+				texture.height = image->sourceHeight();
+				texture.tailLod = image->minLod();
+				for (uint32_t level = 0; level < image->sourceMipLevels(); level++)
+				{
+					texture.levelBytes.push_back(getImageLevelSize(image->format(), std::max(texture.width >> level, 1u), std::max(texture.height >> level, 1u)));
+				}
+				texture.levelLastUsed.assign(texture.levelBytes.size(), 0);
+				texture.wantedLod = texture.tailLod;
+				texture.targetLod = texture.tailLod;
+			}
+
+			texture.residentLod = image->minLod();
+			texture.requestedLod = NO_REQUEST;
+			pendingRequests--;
+
+			//Frames in flight keep the old image alive through their copy of the table
+			_textureRegistryRef.replace(texture.slot, std::move(image));
+		}, maxExtent, [this, textureIndex](std::exception_ptr error)
+		{
+			//The slot keeps what it showed, the request is freed for other textures & retried later
+			StreamedTexture& texture = textures[textureIndex];
+			texture.requestedLod = NO_REQUEST;
+			texture.retryFrame = frame + RETRY_DELAY_FRAMES;
+			pendingRequests--;
+
+			try
+			{
+				std::rethrow_exception(error);
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << e.what() << ", retrying later" << std::endl;
+			}
+		});
+	}
+
+	VkDeviceSize TextureStreamingSystem::chainBytes(const StreamedTexture& texture, uint32_t firstLod)
+	{
+		VkDeviceSize bytes = 0;
+		for (uint32_t level = firstLod; level < texture.levelBytes.size(); level++)
+		{
+			bytes += texture.levelBytes[level];
+		}
+		return bytes;
+	}
+
+	void TextureStreamingSystem::update(EntityRegistry& registry, const Camera& camera, float viewportHeight)
+	{
+		frame++;
+
+		for (StreamedTexture& texture : textures)
+		{
+			texture.wantedLod = texture.tailLod;
+		}
+
+		//Camera looks down +z in view space, a sphere of radius r at distance d covers about 2 * r * pixelScale / d pixels.
+		//Objects outside the frustum count too, so turning around doesn't show blurry textures
+		const glm::mat4& view = camera.getView();
+		const float pixelScale = camera.getProjection()[1][1] * viewportHeight * 0.5f;
+		const float nearClip = camera.getNearClip();
+
+		registry.each<ModelComponent, WorldTransformComponent>([&](Entity, ModelComponent& modelComponent, WorldTransformComponent& world)
+		{
+			if (modelComponent.model == nullptr || modelComponent.textureIndex >= slotTextures.size()) return;
+
+			uint32_t textureIndex = slotTextures[modelComponent.textureIndex];
+			if (textureIndex == NOT_STREAMED) return;
+			StreamedTexture& texture = textures[textureIndex];
+			if (texture.levelBytes.empty() || texture.wantedLod == 0) return;
+
+			glm::vec4 sphere = computeWorldBoundingSphere(*modelComponent.model, world);
+			float distance = glm::length(glm::vec3(view * glm::vec4(glm::vec3(sphere), 1.0f))) - sphere.w;
+			float pixels = 2.0f * sphere.w * pixelScale / std::max(distance, nearClip);
+
+			//One texel per pixel across the object, the texture is assumed to be spread over it once
+			float texels = static_cast<float>(std::max(texture.width, texture.height));
+			uint32_t lod = texture.tailLod;
+			if (pixels >= 1.0f)
+			{
+				lod = static_cast<uint32_t>(std::clamp(std::floor(std::log2(texels / pixels)), 0.0f, static_cast<float>(texture.tailLod)));
+			}
+			texture.wantedLod = std::min(texture.wantedLod, lod);
+		});
+
+		//Levels dropped earlier that are wanted again still count as more recent than ones nobody wants
+		VkDeviceSize plannedBytes = 0;
+		stats = {};
+		for (StreamedTexture& texture : textures)
+		{
+			if (texture.levelBytes.empty()) continue;
+
+			for (uint32_t level = texture.wantedLod; level < texture.levelBytes.size(); level++)
+			{
+				texture.levelLastUsed[level] = frame;
+			}
+
+			//Resident levels that are no longer needed stay cached until the budget runs out
+			texture.targetLod = std::min(texture.wantedLod, texture.residentLod);
+			plannedBytes += chainBytes(texture, texture.targetLod);
+
+			stats.residentBytes += chainBytes(texture, texture.residentLod);
+			stats.requestedBytes += chainBytes(texture, texture.wantedLod);
+			stats.textureCount++;
+		}
+
+		//Over budget, drop the largest level of the texture used least recently until the rest fits. Among
+		//levels in use this frame the biggest goes first, it frees the most for the least loss of detail
+		while (plannedBytes > budget)
+		{
+			StreamedTexture* victim = nullptr;
+			for (StreamedTexture& texture : textures)
+			{
+				if (texture.levelBytes.empty() || texture.targetLod >= texture.tailLod) continue;
+
+				if (victim == nullptr)
+				{
+					victim = &texture;
+					continue;
+				}
+
+				uint64_t lastUsed = texture.levelLastUsed[texture.targetLod];
+				uint64_t victimLastUsed = victim->levelLastUsed[victim->targetLod];
+				if (lastUsed < victimLastUsed || (lastUsed == victimLastUsed && texture.levelBytes[texture.targetLod] > victim->levelBytes[victim->targetLod]))
+				{
+					victim = &texture;
+				}
+			}
+			//Only tails are left, they stay even past the budget
+			if (victim == nullptr) break;
+
+			plannedBytes -= victim->levelBytes[victim->targetLod];
+			victim->targetLod++;
+		}
+
+		//Drops go out before loads so memory is freed before more is taken
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (uint32_t textureIndex = 0; textureIndex < textures.size() && pendingRequests < MAX_PENDING_REQUESTS; textureIndex++)
+			{
+				StreamedTexture& texture = textures[textureIndex];
+				if (texture.requestedLod != NO_REQUEST || frame < texture.retryFrame) continue;
+
+				//Only a failed tail leaves a texture without one, it is loaded again like the first time
+				if (texture.levelBytes.empty())
+				{
+					if (pass == 1) request(textureIndex, 0, TAIL_EXTENT);
+					continue;
+				}
+
+				bool drop = texture.targetLod > texture.residentLod;
+				bool load = texture.targetLod < texture.residentLod;
+				if (pass == 0 ? !drop : !load) continue;
+
+				uint32_t maxExtent = std::max(std::max(texture.width >> texture.targetLod, 1u), std::max(texture.height >> texture.targetLod, 1u));
+				request(textureIndex, texture.targetLod, maxExtent);
+			}
+		}
+
+		for (const StreamedTexture& texture : textures)
+		{
+			if (!texture.levelBytes.empty() && texture.residentLod > texture.wantedLod)
+			{
+				stats.degradedCount++;
+			}
+			if (frame < texture.retryFrame)
+			{
+				stats.failedCount++;
+			}
+		}
+		stats.budgetBytes = budget;
+		stats.pendingCount = pendingRequests;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../../VulkanBackend/DyneTexture.hpp"
+#include "../../VulkanBackend/DyneTextureRegistry.hpp"
+#include "../AssetStreamer.hpp"
+#include "../Components.hpp"
+#include "../EntityRegistry.hpp"
+#include "../Camera.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Dyne
+{
+    // Keeps each streamed texture's mip chain only as deep as the objects sampling it need. A texture first
+    // loads its small tail levels, so it shows up at once, then the levels above are streamed in as the
+    // objects using it cover more of the screen.
+    // Levels that aren't needed stay resident as long as the budget allows. Past it, the levels used least
+    // recently are dropped first, so scenes whose textures don't fit in memory at once still draw.
+    // A texture's resident levels always form one image starting at its minLod. Loading or dropping levels
+    // builds the new image next to the old one and swaps it into the texture's registry slot, the old image
+    // is freed once no frame in flight samples it anymore.
+    class TextureStreamingSystem
+    {
+    public:
+        // Largest side of the levels every texture loads first and never drops
+        static constexpr uint32_t TAIL_EXTENT = 64;
+        // Residency changes in flight at once, each rebuilds a whole image
+        static constexpr uint32_t MAX_PENDING_REQUESTS = 8;
+        // Frames a texture waits before a failed load is tried again
+        static constexpr uint64_t RETRY_DELAY_FRAMES = 300;
+
+        struct Stats
+        {
+            // Bytes of the images drawn from right now
+            VkDeviceSize residentBytes = 0;
+            // Bytes every texture would take at the level its objects want, regardless of the budget
+            VkDeviceSize requestedBytes = 0;
+            VkDeviceSize budgetBytes = 0;
+            uint32_t textureCount = 0;
+            // Textures drawn with fewer levels than their objects want
+            uint32_t degradedCount = 0;
+            uint32_t pendingCount = 0;
+            // Textures waiting to retry a load that failed
+            uint32_t failedCount = 0;
+        };
+
+        TextureStreamingSystem(AssetStreamer& assetStreamer, DyneTextureRegistry& textureRegistry, VkDeviceSize budgetBytes);
+
+        TextureStreamingSystem(const TextureStreamingSystem&) = delete;
+        TextureStreamingSystem& operator=(const TextureStreamingSystem&) = delete;
+
+        // Registry slot for filepath, holding the registry's default texture until the tail has streamed in
+        uint32_t requestTexture(const std::string& filepath);
+
+        // Picks the levels every texture needs from the screen size of the objects using it and requests
+        // the changes. viewportHeight in pixels, to turn the perspective projection into on screen sizes.
+        // Call once per frame after AssetStreamer::update()
+        void update(EntityRegistry& registry, const Camera& camera, float viewportHeight);
+
+        void setBudget(VkDeviceSize budgetBytes) { budget = budgetBytes; }
+        VkDeviceSize getBudget() const { return budget; }
+        const Stats& getStats() const { return stats; }
+
+    private:
+        static constexpr uint32_t NO_REQUEST = UINT32_MAX;
+        static constexpr uint32_t NOT_STREAMED = UINT32_MAX;
+
+        struct StreamedTexture
+        {
+            std::string filepath;
+            uint32_t slot = 0;
+            // Known once the tail is resident, size of level 0 and the bytes of every level of the file
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<VkDeviceSize> levelBytes;
+            // First level of the tail, the file's levels from here on are always resident
+            uint32_t tailLod = 0;
+            // First level of the image in the slot, only meaningful once the tail is resident
+            uint32_t residentLod = 0;
+            // First level of the image being built, NO_REQUEST when none is
+            uint32_t requestedLod = NO_REQUEST;
+            // First level the objects using it want this frame
+            uint32_t wantedLod = 0;
+            // Level the budget allows this frame
+            uint32_t targetLod = 0;
+            // Frame each level was last wanted in
+            std::vector<uint64_t> levelLastUsed;
+            // No request is made before this frame, set when a load failed
+            uint64_t retryFrame = 0;
+        };
+
+        // Rebuilds the texture's image from the first level no larger than maxExtent
+        void request(uint32_t textureIndex, uint32_t requestedLod, uint32_t maxExtent);
+        // Bytes of the levels from firstLod to the end of the chain
+        static VkDeviceSize chainBytes(const StreamedTexture& texture, uint32_t firstLod);
+
+        AssetStreamer& _assetStreamerRef;
+        DyneTextureRegistry& _textureRegistryRef;
+        VkDeviceSize budget;
+
+        std::vector<StreamedTexture> textures;
+        // Index into textures for every registry slot, NOT_STREAMED for slots that aren't streamed
+        std::vector<uint32_t> slotTextures;
+        uint64_t frame = 0;
+        uint32_t pendingRequests = 0;
+        Stats stats{};
+    };
+}
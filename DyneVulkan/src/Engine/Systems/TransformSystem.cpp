@@ -0,0 +1,376 @@
+#include "TransformSystem.hpp"
+
+#include "../../Utility/DyneSimd.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Dyne
+{
+	namespace
+	{
+		using namespace Simd;
+
+		static_assert(TransformSystem::BATCH_SIZE % LANE_WIDTH == 0, "Batch size must be a multiple of the SIMD width!");
+
+		//Cephes style sin & cos: reduce around the nearest multiple of pi/2, evaluate both polynomials
+		//on [-pi/4, pi/4] and swap / negate them by quadrant
+		inline void sinCos(FloatLanes x, FloatLanes& sinX, FloatLanes& cosX)
+		{
+			FloatLanes q = roundNearest(mul(x, set1(0.636619772367581343f)));
+			FloatLanes r = sub(x, mul(q, set1(1.5703125f)));
+			r = sub(r, mul(q, set1(4.837512969970703125e-4f)));
+			r = sub(r, mul(q, set1(7.54978995489188216e-8f)));
+
+			FloatLanes r2 = mul(r, r);
+			FloatLanes sinR = add(r, mul(mul(r, r2),
+				add(set1(-1.6666654611e-1f), mul(r2, add(set1(8.3321608736e-3f), mul(r2, set1(-1.9515295891e-4f)))))));
+			FloatLanes cosR = add(sub(set1(1.0f), mul(set1(0.5f), r2)), mul(mul(r2, r2),
+				add(set1(4.166664568298827e-2f), mul(r2, add(set1(-1.388731625493765e-3f), mul(r2, set1(2.443315711809948e-5f)))))));
+
+			//Quadrant as one of -2..2, k and k + 4 are the same quadrant
+			FloatLanes k = sub(q, mul(set1(4.0f), roundNearest(mul(q, set1(0.25f)))));
+			FloatLanes k2 = mul(k, k);
+			FloatLanes swap = equal(k2, set1(1.0f));
+			FloatLanes negateSin = either(equal(k2, set1(4.0f)), equal(k, set1(-1.0f)));
+			FloatLanes negateCos = either(equal(k2, set1(4.0f)), equal(k, set1(1.0f)));
+
+			FloatLanes s = select(swap, cosR, sinR);
+			FloatLanes c = select(swap, sinR, cosR);
+			sinX = select(negateSin, sub(set1(0.0f), s), s);
+			cosX = select(negateCos, sub(set1(0.0f), c), c);
+		}
+	}
+
+	TransformSystem::TransformSystem(DyneThreadPool& threadPool) : _threadPoolRef(threadPool)
+	{
+
+	}
+
+	uint32_t TransformSystem::update(EntityRegistry& registry)
+	{
+		if (registry.count<WorldTransformComponent>() != registry.count<TransformComponent>())
+		{
+			addMissingWorldTransforms(registry);
+		}
+		//Parents have a transform, destroying one changes the transform pool
+		uint64_t transformVersion = registry.getPool<TransformComponent>().getVersion();
+		if (transformVersion != transformPoolVersion)
+		{
+			transformPoolVersion = transformVersion;
+			detachOrphans(registry);
+		}
+		if (hierarchyChanged || registry.count<HierarchyComponent>() != builtHierarchyCount)
+		{
+			rebuildHierarchy(registry);
+		}
+		if (worldChanged.size() < registry.getIndexCapacity())
+		{
+			worldChanged.resize(registry.getIndexCapacity(), 0);
+		}
+
+		if (updateDirtyTransforms(registry) == 0) return 0;
+		propagateHierarchy(registry);
+
+		//Renderers only care about objects they draw, moving pivots & lights doesn't invalidate their scene
+		uint32_t movedModelCount = 0;
+		for (uint32_t entityIndex : registry.getPool<ModelComponent>().getEntities())
+		{
+			movedModelCount += worldChanged[entityIndex];
+		}
+
+		std::fill(worldChanged.begin(), worldChanged.end(), static_cast<uint8_t>(0));
+		return movedModelCount;
+	}
+
+	void TransformSystem::setParent(EntityRegistry& registry, Entity child, Entity parent)
+	{
+		assert(registry.has<TransformComponent>(child) && "Only entities with a transform can be parented!");
+
+		if (!registry.isAlive(parent))
+		{
+			registry.remove<HierarchyComponent>(child);
+		}
+		else
+		{
+			assert(registry.has<TransformComponent>(parent) && "Parent entity needs a transform!");
+
+			//Walking up from the new parent must never reach the child
+			for (Entity ancestor = parent; registry.isAlive(ancestor);)
+			{
+				if (ancestor == child)
+				{
+					throw std::runtime_error("failed to set parent, the entity would become its own ancestor!");
+				}
+				auto* ancestorHierarchy = registry.tryGet<HierarchyComponent>(ancestor);
+				if (ancestorHierarchy == nullptr) break;
+				ancestor = ancestorHierarchy->parent;
+			}
+
+			if (auto* hierarchy = registry.tryGet<HierarchyComponent>(child))
+			{
+				hierarchy->parent = parent;
+			}
+			else
+			{
+				registry.add<HierarchyComponent>(child, parent);
+			}
+		}
+
+		//The transform now means something else, its world matrices have to be rebuilt
+		registry.get<TransformComponent>(child).dirty = true;
+		hierarchyChanged = true;
+	}
+
+	uint32_t TransformSystem::updateDirtyTransforms(EntityRegistry& registry)
+	{
+		auto& transformPool = registry.getPool<TransformComponent>();
+		auto& worldPool = registry.getPool<WorldTransformComponent>();
+		auto& hierarchyPool = registry.getPool<HierarchyComponent>();
+		auto& transforms = transformPool.getComponents();
+		const auto& entities = transformPool.getEntities();
+
+		TransformLanes lanes;
+		WorldTransformComponent* outputs[BATCH_SIZE];
+		uint32_t batchCount = 0;
+		uint32_t updatedCount = 0;
+
+		//Static transforms cost one flag test, the rest are gathered into lanes
+		for (size_t i = 0; i < transforms.size(); i++)
+		{
+			auto& transform = transforms[i];
+			if (!transform.dirty) continue;
+
+			transform.dirty = false;
+			uint32_t entityIndex = entities[i];
+			if (!worldPool.has(entityIndex)) continue;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				lanes.translation[axis][batchCount] = transform.translation[axis];
+				lanes.rotation[axis][batchCount] = transform.rotation[axis];
+				lanes.scale[axis][batchCount] = transform.scale[axis];
+			}
+			//Children get their local matrices, propagation turns them into world matrices
+			outputs[batchCount++] = hierarchyPool.has(entityIndex) ? &hierarchyPool.get(entityIndex).local : &worldPool.get(entityIndex);
+			worldChanged[entityIndex] = 1;
+
+			if (batchCount == BATCH_SIZE)
+			{
+				computeBatch(lanes, outputs, batchCount);
+				updatedCount += batchCount;
+				batchCount = 0;
+			}
+		}
+
+		if (batchCount > 0)
+		{
+			//Unused lanes get an identity transform so the kernel never divides by zero
+			for (uint32_t lane = batchCount; lane < BATCH_SIZE; lane++)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					lanes.translation[axis][lane] = 0.0f;
+					lanes.rotation[axis][lane] = 0.0f;
+					lanes.scale[axis][lane] = 1.0f;
+				}
+			}
+			computeBatch(lanes, outputs, batchCount);
+			updatedCount += batchCount;
+		}
+
+		return updatedCount;
+	}
+
+	void TransformSystem::propagateHierarchy(EntityRegistry& registry)
+	{
+		auto& worldPool = registry.getPool<WorldTransformComponent>();
+		auto& hierarchyPool = registry.getPool<HierarchyComponent>();
+
+		//A level only reads the world matrices of the level above, which is complete by then
+		for (size_t level = 0; level + 1 < levelOffsets.size(); level++)
+		{
+			uint32_t levelBegin = levelOffsets[level];
+			uint32_t levelSize = levelOffsets[level + 1] - levelBegin;
+
+			_threadPoolRef.parallelFor(levelSize, MIN_NODES_PER_CHUNK, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = levelBegin + begin; i < levelBegin + end; i++)
+				{
+					const HierarchyNode& node = hierarchyNodes[i];
+
+					//Orphans were detached at the start of update(), the parent check only guards the lookup
+					bool hasParent = registry.isAlive(node.parent) && worldPool.has(node.parent.index);
+					if (!worldChanged[node.entityIndex] && !(hasParent && worldChanged[node.parent.index])) continue;
+
+					const WorldTransformComponent& local = hierarchyPool.get(node.entityIndex).local;
+					WorldTransformComponent& world = worldPool.get(node.entityIndex);
+					if (hasParent)
+					{
+						const WorldTransformComponent& parentWorld = worldPool.get(node.parent.index);
+						world.modelMatrix = parentWorld.modelMatrix * local.modelMatrix;
+						world.normalMatrix = parentWorld.normalMatrix * local.normalMatrix;
+					}
+					else
+					{
+						world = local;
+					}
+
+					worldChanged[node.entityIndex] = 1;
+				}
+			});
+		}
+	}
+
+	void TransformSystem::detachOrphans(EntityRegistry& registry)
+	{
+		orphanedEntities.clear();
+		registry.each<HierarchyComponent>([&](Entity entity, HierarchyComponent& hierarchy)
+		{
+			if (!registry.isAlive(hierarchy.parent)) orphanedEntities.push_back(entity);
+		});
+
+		//Removing invalidates the iteration above, so it happens afterwards
+		for (Entity entity : orphanedEntities)
+		{
+			setParent(registry, entity, Entity{});
+		}
+	}
+
+	void TransformSystem::rebuildHierarchy(EntityRegistry& registry)
+	{
+		constexpr uint32_t UNKNOWN_DEPTH = ~0u;
+
+		auto& hierarchyPool = registry.getPool<HierarchyComponent>();
+		auto& hierarchies = hierarchyPool.getComponents();
+		const auto& entities = hierarchyPool.getEntities();
+
+		hierarchyChanged = false;
+		builtHierarchyCount = hierarchies.size();
+
+		//Roots are depth 0, walk up from each child until a known depth and number the chain on the way back
+		std::vector<uint32_t> depths(registry.getIndexCapacity(), UNKNOWN_DEPTH);
+		std::vector<uint32_t> chain;
+		uint32_t maxDepth = 0;
+		for (uint32_t entityIndex : entities)
+		{
+			chain.clear();
+			uint32_t current = entityIndex;
+			while (depths[current] == UNKNOWN_DEPTH && hierarchyPool.has(current))
+			{
+				chain.push_back(current);
+				Entity parent = hierarchyPool.get(current).parent;
+				current = registry.isAlive(parent) ? parent.index : Entity::INVALID_INDEX;
+				if (current == Entity::INVALID_INDEX) break;
+			}
+
+			uint32_t depth = current != Entity::INVALID_INDEX && depths[current] != UNKNOWN_DEPTH ? depths[current] : 0;
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+			{
+				depths[*it] = ++depth;
+			}
+			maxDepth = std::max(maxDepth, depth);
+		}
+
+		//Counting sort by depth, level d holds the children at depth d + 1
+		levelOffsets.assign(maxDepth + 1, 0);
+		for (uint32_t entityIndex : entities)
+		{
+			levelOffsets[depths[entityIndex]]++;
+		}
+		for (uint32_t depth = 1; depth <= maxDepth; depth++)
+		{
+			levelOffsets[depth] += levelOffsets[depth - 1];
+		}
+
+		std::vector<uint32_t> cursors(levelOffsets.begin(), levelOffsets.end() - 1);
+		hierarchyNodes.resize(entities.size());
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			uint32_t depth = depths[entities[i]];
+			hierarchyNodes[cursors[depth - 1]++] = HierarchyNode{ entities[i], hierarchies[i].parent };
+		}
+	}
+
+	void TransformSystem::addMissingWorldTransforms(EntityRegistry& registry)
+	{
+		auto& worldPool = registry.getPool<WorldTransformComponent>();
+
+		missingEntities.clear();
+		registry.each<TransformComponent>([&](Entity entity, TransformComponent&)
+		{
+			if (!worldPool.has(entity.index)) missingEntities.push_back(entity);
+		});
+
+		//Adding invalidates the iteration above, so it happens afterwards
+		for (Entity entity : missingEntities)
+		{
+			registry.add<WorldTransformComponent>(entity);
+			registry.get<TransformComponent>(entity).dirty = true;
+		}
+	}
+
+	void TransformSystem::computeBatch(const TransformLanes& lanes, WorldTransformComponent* const* outputs, uint32_t count)
+	{
+		assert(count <= BATCH_SIZE && "Transform batch overflow!");
+
+		//Row = matrix element (9 model, 9 normal), column = lane
+		alignas(32) float results[18][BATCH_SIZE];
+
+		for (uint32_t base = 0; base < BATCH_SIZE; base += LANE_WIDTH)
+		{
+			FloatLanes s1, c1, s2, c2, s3, c3;
+			sinCos(load(&lanes.rotation[1][base]), s1, c1);
+			sinCos(load(&lanes.rotation[0][base]), s2, c2);
+			sinCos(load(&lanes.rotation[2][base]), s3, c3);
+
+			//Same terms as TransformComponent::mat4(), translation * rY * rX * rZ * scale
+			FloatLanes s1s2 = mul(s1, s2);
+			FloatLanes c1s2 = mul(c1, s2);
+			FloatLanes rotation[9] =
+			{
+				add(mul(c1, c3), mul(s1s2, s3)),
+				mul(c2, s3),
+				sub(mul(c1s2, s3), mul(c3, s1)),
+				sub(mul(c3, s1s2), mul(c1, s3)),
+				mul(c2, c3),
+				add(mul(c1s2, c3), mul(s1, s3)),
+				mul(c2, s1),
+				sub(set1(0.0f), s2),
+				mul(c1, c2)
+			};
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				FloatLanes scale = load(&lanes.scale[axis][base]);
+				FloatLanes inverseScale = div(set1(1.0f), scale);
+				for (int row = 0; row < 3; row++)
+				{
+					store(&results[axis * 3 + row][base], mul(rotation[axis * 3 + row], scale));
+					store(&results[9 + axis * 3 + row][base], mul(rotation[axis * 3 + row], inverseScale));
+				}
+			}
+		}
+
+		for (uint32_t lane = 0; lane < count; lane++)
+		{
+			auto& world = *outputs[lane];
+			for (int column = 0; column < 3; column++)
+			{
+				world.modelMatrix[column] = glm::vec4(
+					results[column * 3 + 0][lane],
+					results[column * 3 + 1][lane],
+					results[column * 3 + 2][lane],
+					0.0f);
+				world.normalMatrix[column] = glm::vec4(
+					results[9 + column * 3 + 0][lane],
+					results[9 + column * 3 + 1][lane],
+					results[9 + column * 3 + 2][lane],
+					0.0f);
+			}
+			world.modelMatrix[3] = glm::vec4(lanes.translation[0][lane], lanes.translation[1][lane], lanes.translation[2][lane], 1.0f);
+			world.normalMatrix[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+}
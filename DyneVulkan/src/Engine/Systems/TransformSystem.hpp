@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../Components.hpp"
+#include "../EntityRegistry.hpp"
+#include "../../Utility/DyneThreadPool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Dyne
+{
+    // Keeps every WorldTransformComponent in sync with its TransformComponent. Only dirty transforms
+    // are recomputed: they are gathered into structure-of-arrays lanes and run through a SIMD kernel
+    // 8 at a time, so static geometry costs a flag test per frame and moving objects share the trig.
+    //
+    // Children (entities with a HierarchyComponent) are then combined with their parent's world matrices.
+    // The hierarchy is kept flat & sorted by depth, each level only reads the one before it, so levels
+    // are propagated in order and the nodes of a level in parallel. Only nodes below a change are touched.
+    class TransformSystem
+    {
+    public:
+        static constexpr uint32_t BATCH_SIZE = 8;
+        // Smallest slice of a hierarchy level worth handing to another thread
+        static constexpr uint32_t MIN_NODES_PER_CHUNK = 2048;
+
+        explicit TransformSystem(DyneThreadPool& threadPool);
+
+        TransformSystem(const TransformSystem&) = delete;
+        TransformSystem& operator=(const TransformSystem&) = delete;
+
+        // Returns how many entities with a model moved, 0 when cached scene data is still valid
+        uint32_t update(EntityRegistry& registry);
+
+        // Attaches child below parent, keeping its TransformComponent as the local transform.
+        // Pass an invalid Entity{} to detach it again. Throws when parent is child or one of its descendants.
+        // Children of a destroyed parent are detached on the next update, their local transform becomes their world transform.
+        void setParent(EntityRegistry& registry, Entity child, Entity parent);
+
+    private:
+        // Inputs of one batch, one array per scalar so the kernel loads whole lanes
+        struct TransformLanes
+        {
+            alignas(32) float translation[3][BATCH_SIZE];
+            alignas(32) float rotation[3][BATCH_SIZE];
+            alignas(32) float scale[3][BATCH_SIZE];
+        };
+
+        struct HierarchyNode
+        {
+            uint32_t entityIndex;
+            Entity parent;
+        };
+
+        void addMissingWorldTransforms(EntityRegistry& registry);
+        uint32_t updateDirtyTransforms(EntityRegistry& registry);
+        void propagateHierarchy(EntityRegistry& registry);
+        void detachOrphans(EntityRegistry& registry);
+        void rebuildHierarchy(EntityRegistry& registry);
+        static void computeBatch(const TransformLanes& lanes, WorldTransformComponent* const* outputs, uint32_t count);
+
+        DyneThreadPool& _threadPoolRef;
+
+        std::vector<Entity> missingEntities;
+        std::vector<Entity> orphanedEntities;
+
+        // Hierarchy nodes sorted by depth, level i is [levelOffsets[i], levelOffsets[i + 1])
+        std::vector<HierarchyNode> hierarchyNodes;
+        std::vector<uint32_t> levelOffsets;
+        size_t builtHierarchyCount = 0;
+        bool hierarchyChanged = false;
+        uint64_t transformPoolVersion = 0;
+
+        // Per entity index, set when its world matrices changed this update so its children follow
+        std::vector<uint8_t> worldChanged;
+    };
+}
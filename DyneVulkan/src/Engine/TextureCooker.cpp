@@ -0,0 +1,139 @@
+#include "TextureCooker.hpp"
+#include "../Utility/DyneThreadPool.hpp"
+#include "../VulkanBackend/DyneTexture.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+namespace Dyne
+{
+	namespace
+	{
+		using Clock = std::chrono::high_resolution_clock;
+
+		std::string toLower(std::string text)
+		{
+			std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			return text;
+		}
+
+		bool isNormalMap(const std::string& stem)
+		{
+			std::string name = toLower(stem);
+			return name.find("_normal") != std::string::npos || name.find("_nrm") != std::string::npos;
+		}
+
+		bool hasTranslucentPixels(const unsigned char* pixels, uint32_t width, uint32_t height)
+		{
+			size_t pixelCount = static_cast<size_t>(width) * height;
+			for (size_t i = 0; i < pixelCount; i++)
+			{
+				if (pixels[i * 4 + 3] != 255) return true;
+			}
+			return false;
+		}
+
+		VkFormat getCookedFormat(BcFormat format, bool srgb)
+		{
+			switch (format)
+			{
+			case BcFormat::BC1: return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+			case BcFormat::BC3: return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+			case BcFormat::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+			case BcFormat::BC7: return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+			}
+			return VK_FORMAT_UNDEFINED;
+		}
+
+		const char* getFormatName(BcFormat format)
+		{
+			switch (format)
+			{
+			case BcFormat::BC1: return "BC1";
+			case BcFormat::BC3: return "BC3";
+			case BcFormat::BC5: return "BC5";
+			case BcFormat::BC7: return "BC7";
+			}
+			return "?";
+		}
+	}
+
+	void runTextureCooker(const std::string& directory, std::optional<BcFormat> forcedFormat)
+	{
+		DyneThreadPool threadPool;
+		VkDeviceSize totalSourceBytes = 0;
+		VkDeviceSize totalCookedBytes = 0;
+
+		std::cout << "Cooking textures in " << directory << " with " << threadPool.getThreadCount() << " workers\n";
+		for (const auto& entry : std::filesystem::directory_iterator(directory))
+		{
+			std::string extension = toLower(entry.path().extension().string());
+			if (!entry.is_regular_file() || (extension != ".png" && extension != ".jpg" && extension != ".jpeg" && extension != ".tga"))
+			{
+				continue;
+			}
+
+			std::filesystem::path cookedPath = std::filesystem::path{ entry.path() }.replace_extension(".ktx2");
+			try
+			{
+				auto start = Clock::now();
+				DyneTexture::Builder builder{};
+				builder.loadPixels(entry.path().string());
+
+				//Normals are vectors, BC5 keeps x & y and the shader rebuilds z
+				bool normalMap = isNormalMap(entry.path().stem().string());
+				BcFormat format = forcedFormat ? *forcedFormat :
+					normalMap ? BcFormat::BC5 :
+					hasTranslucentPixels(builder.bPixels.get(), builder.bWidth, builder.bHeight) ? BcFormat::BC7 : BcFormat::BC1;
+				bool srgb = !normalMap && format != BcFormat::BC5;
+				builder.generateMips(srgb);
+
+				Ktx2Image image{};
+				image.format = getCookedFormat(format, srgb);
+				image.width = builder.bWidth;
+				image.height = builder.bHeight;
+				image.levels.push_back(compressImage(builder.bPixels.get(), builder.bWidth, builder.bHeight, format, &threadPool));
+				for (size_t level = 0; level < builder.bMipPixels.size(); level++)
+				{
+					uint32_t levelWidth = std::max(builder.bWidth >> (level + 1), 1u);
+					uint32_t levelHeight = std::max(builder.bHeight >> (level + 1), 1u);
+					image.levels.push_back(compressImage(builder.bMipPixels[level].data(), levelWidth, levelHeight, format, &threadPool));
+				}
+				writeKtx2(cookedPath.string(), image);
+
+				VkDeviceSize sourceBytes = static_cast<VkDeviceSize>(builder.bWidth) * builder.bHeight * 4;
+				for (const auto& level : builder.bMipPixels)
+				{
+					sourceBytes += level.size();
+				}
+				VkDeviceSize cookedBytes = 0;
+				for (const auto& level : image.levels)
+				{
+					cookedBytes += level.size();
+				}
+				totalSourceBytes += sourceBytes;
+				totalCookedBytes += cookedBytes;
+
+				std::cout << std::left << std::setw(28) << entry.path().filename().string() << std::right
+					<< " " << getFormatName(format) << " " << image.width << "x" << image.height << ", " << image.levels.size() << " levels   "
+					<< std::setw(10) << sourceBytes << " -> " << std::setw(9) << cookedBytes << " bytes   "
+					<< std::fixed << std::setprecision(1) << static_cast<double>(sourceBytes) / cookedBytes << "x   "
+					<< std::setprecision(1) << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms\n";
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "failed to cook " << entry.path().string() << ": " << e.what() << std::endl;
+			}
+		}
+
+		if (totalCookedBytes > 0)
+		{
+			std::cout << "total " << totalSourceBytes << " -> " << totalCookedBytes << " bytes, "
+				<< std::fixed << std::setprecision(1) << static_cast<double>(totalSourceBytes) / totalCookedBytes << "x smaller in video memory\n";
+		}
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../Utility/DyneBcEncoder.hpp"
+
+#include <optional>
+#include <string>
+
+namespace Dyne
+{
+    // Compresses every png, jpg & tga in directory into a <name>.ktx2 beside it with the full mip chain, which
+    // DyneTexture::Builder::load then prefers over the source. Unless forced, opaque textures become BC1, ones with
+    // alpha BC7 and *_normal / *_nrm textures BC5. Prints the sizes and timings
+    void runTextureCooker(const std::string& directory, std::optional<BcFormat> forcedFormat);
+}
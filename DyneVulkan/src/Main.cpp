@@ -1,9 +1,44 @@
 #include "Application.hpp"
+#include "Engine/SceneBvh.hpp"
+#include "Engine/TextureCooker.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
 
 using namespace Dyne;
 
-int main() 
+int main(int argc, char** argv) 
 {
+    //--bench-bvh [item count] times the scene BVH against linear scans instead of opening the editor
+    if (argc > 1 && std::string(argv[1]) == "--bench-bvh")
+    {
+        uint32_t itemCount = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1000000;
+        runSceneBvhBenchmark(itemCount);
+        return 0;
+    }
+
+    //--cook-textures [directory] [bc1|bc3|bc5|bc7] compresses the textures into KTX2 files the engine loads instead
+    if (argc > 1 && std::string(argv[1]) == "--cook-textures")
+    {
+        std::string directory = argc > 2 ? argv[2] : "textures";
+        std::optional<BcFormat> format;
+        std::string formatName = argc > 3 ? argv[3] : "";
+        if (formatName == "bc1") format = BcFormat::BC1;
+        else if (formatName == "bc3") format = BcFormat::BC3;
+        else if (formatName == "bc5") format = BcFormat::BC5;
+        else if (formatName == "bc7") format = BcFormat::BC7;
+        else if (!formatName.empty())
+        {
+            std::cerr << "unknown texture format " << formatName << std::endl;
+            std::cerr << "usage: " << argv[0] << " --cook-textures [directory] [bc1|bc3|bc5|bc7]" << std::endl;
+            return EXIT_FAILURE;
+        }
+        runTextureCooker(directory, format);
+        return 0;
+    }
+
     Application editor;
     editor.run();
     return 0;
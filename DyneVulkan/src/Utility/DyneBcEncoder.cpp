@@ -0,0 +1,545 @@
+#include "DyneBcEncoder.hpp"
+
+#include "DyneSimd.hpp"
+#include "DyneThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Dyne
+{
+	namespace
+	{
+		constexpr uint32_t BLOCK_PIXELS = 16;
+		static_assert(BLOCK_PIXELS % Simd::LANE_WIDTH == 0, "A block must split into whole lanes!");
+
+		//BC7 interpolation weights of 4 bit indices, out of 64
+		constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		//Share of the first endpoint in each BC1 palette entry, in index order
+		constexpr float BC1_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		//The block's pixels split into channels, so Simd lanes run over pixels
+		struct BlockChannels
+		{
+			alignas(32) float values[4][BLOCK_PIXELS];
+		};
+
+		void loadChannels(const uint8_t* pixels, BlockChannels& channels)
+		{
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					channels.values[c][i] = static_cast<float>(pixels[i * 4 + c]);
+				}
+			}
+		}
+
+		//Picks the nearest palette entry for every pixel over channels [firstChannel, firstChannel + channelCount).
+		//Returns the summed squared error
+		float selectIndices(
+			const BlockChannels& channels,
+			uint32_t firstChannel,
+			uint32_t channelCount,
+			const float (*palette)[4],
+			uint32_t paletteSize,
+			uint8_t* indices)
+		{
+			alignas(32) float bestIndices[BLOCK_PIXELS];
+			alignas(32) float bestErrors[BLOCK_PIXELS];
+			for (uint32_t base = 0; base < BLOCK_PIXELS; base += Simd::LANE_WIDTH)
+			{
+				Simd::FloatLanes best = Simd::set1(std::numeric_limits<float>::max());
+				Simd::FloatLanes bestIndex = Simd::set1(0.0f);
+				for (uint32_t k = 0; k < paletteSize; k++)
+				{
+					Simd::FloatLanes error = Simd::set1(0.0f);
+					for (uint32_t c = 0; c < channelCount; c++)
+					{
+						Simd::FloatLanes diff = Simd::sub(Simd::load(&channels.values[firstChannel + c][base]), Simd::set1(palette[k][c]));
+						error = Simd::add(error, Simd::mul(diff, diff));
+					}
+
+					//Ties keep the lower index
+					Simd::FloatLanes keep = Simd::greaterEqual(error, best);
+					best = Simd::select(keep, best, error);
+					bestIndex = Simd::select(keep, bestIndex, Simd::set1(static_cast<float>(k)));
+				}
+				Simd::store(&bestIndices[base], bestIndex);
+				Simd::store(&bestErrors[base], best);
+			}
+
+			float totalError = 0.0f;
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				indices[i] = static_cast<uint8_t>(bestIndices[i]);
+				totalError += bestErrors[i];
+			}
+			return totalError;
+		}
+
+		//Mean and principal axis of the pixels over the first channelCount channels, by power iteration on their
+		//covariance. The axis is zero for a single colored block
+		void principalAxis(const BlockChannels& channels, uint32_t channelCount, float* mean, float* axis)
+		{
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				float sum = 0.0f;
+				for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+				{
+					sum += channels.values[c][i];
+				}
+				mean[c] = sum / BLOCK_PIXELS;
+			}
+
+			float covariance[4][4]{};
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				for (uint32_t a = 0; a < channelCount; a++)
+				{
+					for (uint32_t b = a; b < channelCount; b++)
+					{
+						covariance[a][b] += (channels.values[a][i] - mean[a]) * (channels.values[b][i] - mean[b]);
+					}
+				}
+			}
+
+			//Starting from the row of the widest channel can't be orthogonal to the principal axis
+			uint32_t widest = 0;
+			for (uint32_t a = 0; a < channelCount; a++)
+			{
+				for (uint32_t b = 0; b < a; b++)
+				{
+					covariance[a][b] = covariance[b][a];
+				}
+				if (covariance[a][a] > covariance[widest][widest]) widest = a;
+			}
+
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				axis[c] = covariance[widest][c];
+			}
+
+			for (int iteration = 0; iteration < 8; iteration++)
+			{
+				float next[4]{};
+				float largest = 0.0f;
+				for (uint32_t a = 0; a < channelCount; a++)
+				{
+					for (uint32_t b = 0; b < channelCount; b++)
+					{
+						next[a] += covariance[a][b] * axis[b];
+					}
+					largest = std::max(largest, std::fabs(next[a]));
+				}
+				if (largest <= 0.0f) break;
+
+				for (uint32_t c = 0; c < channelCount; c++)
+				{
+					axis[c] = next[c] / largest;
+				}
+			}
+
+			float length = 0.0f;
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				length += axis[c] * axis[c];
+			}
+			length = std::sqrt(length);
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				axis[c] = length > 0.0f ? axis[c] / length : 0.0f;
+			}
+		}
+
+		//Endpoints of the pixels' extent along their principal axis
+		void fitEndpoints(const BlockChannels& channels, uint32_t channelCount, float* endpoint0, float* endpoint1)
+		{
+			float mean[4];
+			float axis[4];
+			principalAxis(channels, channelCount, mean, axis);
+
+			float minT = 0.0f;
+			float maxT = 0.0f;
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				float t = 0.0f;
+				for (uint32_t c = 0; c < channelCount; c++)
+				{
+					t += (channels.values[c][i] - mean[c]) * axis[c];
+				}
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				endpoint0[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+				endpoint1[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+			}
+		}
+
+		//Least squares endpoints for fixed indices, weights[index] being the share of the first endpoint.
+		//False when the indices don't pin both endpoints down
+		bool solveEndpoints(
+			const BlockChannels& channels,
+			uint32_t channelCount,
+			const uint8_t* indices,
+			const float* weights,
+			float* endpoint0,
+			float* endpoint1)
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ap[4]{};
+			float bp[4]{};
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				float a = weights[indices[i]];
+				float b = 1.0f - a;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint32_t c = 0; c < channelCount; c++)
+				{
+					ap[c] += a * channels.values[c][i];
+					bp[c] += b * channels.values[c][i];
+				}
+			}
+
+			float determinant = aa * bb - ab * ab;
+			if (std::fabs(determinant) < 1e-6f) return false;
+
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				endpoint0[c] = std::clamp((ap[c] * bb - bp[c] * ab) / determinant, 0.0f, 255.0f);
+				endpoint1[c] = std::clamp((bp[c] * aa - ap[c] * ab) / determinant, 0.0f, 255.0f);
+			}
+			return true;
+		}
+
+		uint16_t packRgb565(const float* color)
+		{
+			uint32_t r = static_cast<uint32_t>(color[0] * (31.0f / 255.0f) + 0.5f);
+			uint32_t g = static_cast<uint32_t>(color[1] * (63.0f / 255.0f) + 0.5f);
+			uint32_t b = static_cast<uint32_t>(color[2] * (31.0f / 255.0f) + 0.5f);
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void unpackRgb565(uint16_t packed, float* color)
+		{
+			uint32_t r = packed >> 11;
+			uint32_t g = (packed >> 5) & 63;
+			uint32_t b = packed & 31;
+			color[0] = static_cast<float>((r << 3) | (r >> 2));
+			color[1] = static_cast<float>((g << 2) | (g >> 4));
+			color[2] = static_cast<float>((b << 3) | (b >> 2));
+			color[3] = 255.0f;
+		}
+
+		//Orders the endpoints for the 4 color mode and picks the indices, equal endpoints leave a single color
+		float evaluateBc1(const BlockChannels& channels, uint16_t& color0, uint16_t& color1, uint8_t* indices)
+		{
+			if (color0 < color1) std::swap(color0, color1);
+
+			float palette[4][4];
+			unpackRgb565(color0, palette[0]);
+			unpackRgb565(color1, palette[1]);
+			for (int c = 0; c < 4; c++)
+			{
+				palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+				palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+			}
+			return selectIndices(channels, 0, 3, palette, color0 == color1 ? 1 : 4, indices);
+		}
+
+		void encodeColorBlock(const BlockChannels& channels, uint8_t* block)
+		{
+			float endpoint0[4];
+			float endpoint1[4];
+			fitEndpoints(channels, 3, endpoint0, endpoint1);
+
+			//Inset so the extremes land between palette entries rather than past them
+			for (int c = 0; c < 3; c++)
+			{
+				float inset = (endpoint0[c] - endpoint1[c]) / 16.0f;
+				endpoint0[c] -= inset;
+				endpoint1[c] += inset;
+			}
+
+			uint16_t color0 = packRgb565(endpoint0);
+			uint16_t color1 = packRgb565(endpoint1);
+			uint8_t indices[BLOCK_PIXELS];
+			float error = evaluateBc1(channels, color0, color1, indices);
+
+			//One refinement of the endpoints against the chosen indices
+			if (color0 != color1 && solveEndpoints(channels, 3, indices, BC1_WEIGHTS, endpoint0, endpoint1))
+			{
+				uint16_t refined0 = packRgb565(endpoint0);
+				uint16_t refined1 = packRgb565(endpoint1);
+				uint8_t refinedIndices[BLOCK_PIXELS];
+				float refinedError = evaluateBc1(channels, refined0, refined1, refinedIndices);
+				if (refinedError < error)
+				{
+					color0 = refined0;
+					color1 = refined1;
+					std::memcpy(indices, refinedIndices, BLOCK_PIXELS);
+				}
+			}
+
+			uint32_t indexBits = 0;
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				indexBits |= static_cast<uint32_t>(indices[i]) << (2 * i);
+			}
+			block[0] = static_cast<uint8_t>(color0 & 0xFF);
+			block[1] = static_cast<uint8_t>(color0 >> 8);
+			block[2] = static_cast<uint8_t>(color1 & 0xFF);
+			block[3] = static_cast<uint8_t>(color1 >> 8);
+			for (int i = 0; i < 4; i++)
+			{
+				block[4 + i] = static_cast<uint8_t>(indexBits >> (8 * i));
+			}
+		}
+
+		//BC4 block of one channel, always in the 8 value mode
+		void encodeChannelBlock(const BlockChannels& channels, uint32_t channel, uint8_t* block)
+		{
+			const float* values = channels.values[channel];
+			float minValue = *std::min_element(values, values + BLOCK_PIXELS);
+			float maxValue = *std::max_element(values, values + BLOCK_PIXELS);
+
+			uint8_t value0 = static_cast<uint8_t>(maxValue);
+			uint8_t value1 = static_cast<uint8_t>(minValue);
+			uint8_t indices[BLOCK_PIXELS]{};
+			if (value0 > value1)
+			{
+				float palette[8][4]{};
+				palette[0][0] = value0;
+				palette[1][0] = value1;
+				for (int i = 2; i < 8; i++)
+				{
+					palette[i][0] = ((8 - i) * static_cast<float>(value0) + (i - 1) * static_cast<float>(value1)) / 7.0f;
+				}
+				selectIndices(channels, channel, 1, palette, 8, indices);
+			}
+
+			uint64_t indexBits = 0;
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				indexBits |= static_cast<uint64_t>(indices[i]) << (3 * i);
+			}
+			block[0] = value0;
+			block[1] = value1;
+			for (int i = 0; i < 6; i++)
+			{
+				block[2 + i] = static_cast<uint8_t>(indexBits >> (8 * i));
+			}
+		}
+
+		//Mode 6 endpoint, 7 bits per channel plus a shared lowest bit
+		struct Bc7Endpoint
+		{
+			uint8_t values[4];
+			uint8_t pBit;
+		};
+
+		Bc7Endpoint quantizeBc7Endpoint(const float* endpoint)
+		{
+			Bc7Endpoint best{};
+			float bestError = std::numeric_limits<float>::max();
+			for (uint8_t pBit = 0; pBit < 2; pBit++)
+			{
+				Bc7Endpoint candidate{};
+				candidate.pBit = pBit;
+				float error = 0.0f;
+				for (int c = 0; c < 4; c++)
+				{
+					float quantized = std::clamp(std::round((endpoint[c] - pBit) * 0.5f), 0.0f, 127.0f);
+					candidate.values[c] = static_cast<uint8_t>(quantized);
+					float difference = quantized * 2.0f + pBit - endpoint[c];
+					error += difference * difference;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					best = candidate;
+				}
+			}
+			return best;
+		}
+
+		float evaluateBc7(const BlockChannels& channels, const Bc7Endpoint& endpoint0, const Bc7Endpoint& endpoint1, uint8_t* indices)
+		{
+			float palette[16][4];
+			for (int c = 0; c < 4; c++)
+			{
+				int value0 = (endpoint0.values[c] << 1) | endpoint0.pBit;
+				int value1 = (endpoint1.values[c] << 1) | endpoint1.pBit;
+				for (int k = 0; k < 16; k++)
+				{
+					palette[k][c] = static_cast<float>(((64 - BC7_WEIGHTS[k]) * value0 + BC7_WEIGHTS[k] * value1 + 32) >> 6);
+				}
+			}
+			return selectIndices(channels, 0, 4, palette, 16, indices);
+		}
+
+		struct BitWriter
+		{
+			uint8_t* data;
+			uint32_t position = 0;
+
+			void write(uint32_t value, uint32_t bitCount)
+			{
+				for (uint32_t bit = 0; bit < bitCount; bit++, position++)
+				{
+					data[position >> 3] |= static_cast<uint8_t>(((value >> bit) & 1) << (position & 7));
+				}
+			}
+		};
+	}
+
+	uint32_t getBcBlockBytes(BcFormat format)
+	{
+		return format == BcFormat::BC1 ? 8 : 16;
+	}
+
+	void encodeBc1Block(const uint8_t* pixels, uint8_t* block)
+	{
+		BlockChannels channels;
+		loadChannels(pixels, channels);
+		encodeColorBlock(channels, block);
+	}
+
+	void encodeBc3Block(const uint8_t* pixels, uint8_t* block)
+	{
+		BlockChannels channels;
+		loadChannels(pixels, channels);
+		encodeChannelBlock(channels, 3, block);
+		encodeColorBlock(channels, block + 8);
+	}
+
+	void encodeBc5Block(const uint8_t* pixels, uint8_t* block)
+	{
+		BlockChannels channels;
+		loadChannels(pixels, channels);
+		encodeChannelBlock(channels, 0, block);
+		encodeChannelBlock(channels, 1, block + 8);
+	}
+
+	void encodeBc7Block(const uint8_t* pixels, uint8_t* block)
+	{
+		BlockChannels channels;
+		loadChannels(pixels, channels);
+
+		float endpoint0[4];
+		float endpoint1[4];
+		fitEndpoints(channels, 4, endpoint0, endpoint1);
+
+		Bc7Endpoint quantized0 = quantizeBc7Endpoint(endpoint0);
+		Bc7Endpoint quantized1 = quantizeBc7Endpoint(endpoint1);
+		uint8_t indices[BLOCK_PIXELS];
+		float error = evaluateBc7(channels, quantized0, quantized1, indices);
+
+		float weights[16];
+		for (int k = 0; k < 16; k++)
+		{
+			weights[k] = (64 - BC7_WEIGHTS[k]) / 64.0f;
+		}
+
+		//Refine the endpoints against the chosen indices while that still helps
+		for (int iteration = 0; iteration < 2; iteration++)
+		{
+			if (!solveEndpoints(channels, 4, indices, weights, endpoint0, endpoint1)) break;
+
+			Bc7Endpoint refined0 = quantizeBc7Endpoint(endpoint0);
+			Bc7Endpoint refined1 = quantizeBc7Endpoint(endpoint1);
+			uint8_t refinedIndices[BLOCK_PIXELS];
+			float refinedError = evaluateBc7(channels, refined0, refined1, refinedIndices);
+			if (refinedError >= error) break;
+
+			error = refinedError;
+			quantized0 = refined0;
+			quantized1 = refined1;
+			std::memcpy(indices, refinedIndices, BLOCK_PIXELS);
+		}
+
+		//The first pixel's index is stored without its top bit, so it has to point into the first half
+		if (indices[0] >= 8)
+		{
+			std::swap(quantized0, quantized1);
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				indices[i] = static_cast<uint8_t>(15 - indices[i]);
+			}
+		}
+
+		std::memset(block, 0, 16);
+		BitWriter writer{ block };
+		writer.write(1 << 6, 7);
+		for (int c = 0; c < 4; c++)
+		{
+			writer.write(quantized0.values[c], 7);
+			writer.write(quantized1.values[c], 7);
+		}
+		writer.write(quantized0.pBit, 1);
+		writer.write(quantized1.pBit, 1);
+		writer.write(indices[0], 3);
+		for (uint32_t i = 1; i < BLOCK_PIXELS; i++)
+		{
+			writer.write(indices[i], 4);
+		}
+		assert(writer.position == 128 && "BC7 mode 6 block must be 128 bits!");
+	}
+
+	std::vector<uint8_t> compressImage(const uint8_t* pixels, uint32_t width, uint32_t height, BcFormat format, DyneThreadPool* threadPool)
+	{
+		assert(width > 0 && height > 0 && "Cannot compress an empty image!");
+
+		uint32_t blocksX = (width + 3) / 4;
+		uint32_t blocksY = (height + 3) / 4;
+		uint32_t blockBytes = getBcBlockBytes(format);
+		std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+		auto encodeRows = [&](uint32_t begin, uint32_t end)
+		{
+			uint8_t blockPixels[BLOCK_PIXELS * 4];
+			for (uint32_t by = begin; by < end; by++)
+			{
+				for (uint32_t bx = 0; bx < blocksX; bx++)
+				{
+					for (uint32_t y = 0; y < 4; y++)
+					{
+						uint32_t sourceY = std::min(by * 4 + y, height - 1);
+						for (uint32_t x = 0; x < 4; x++)
+						{
+							uint32_t sourceX = std::min(bx * 4 + x, width - 1);
+							std::memcpy(&blockPixels[(y * 4 + x) * 4], &pixels[(static_cast<size_t>(sourceY) * width + sourceX) * 4], 4);
+						}
+					}
+
+					uint8_t* block = &blocks[(static_cast<size_t>(by) * blocksX + bx) * blockBytes];
+					switch (format)
+					{
+					case BcFormat::BC1: encodeBc1Block(blockPixels, block); break;
+					case BcFormat::BC3: encodeBc3Block(blockPixels, block); break;
+					case BcFormat::BC5: encodeBc5Block(blockPixels, block); break;
+					case BcFormat::BC7: encodeBc7Block(blockPixels, block); break;
+					}
+				}
+			}
+		};
+
+		if (threadPool != nullptr)
+		{
+			threadPool->parallelFor(blocksY, 1, encodeRows);
+		}
+		else
+		{
+			encodeRows(0, blocksY);
+		}
+		return blocks;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Dyne
+{
+	class DyneThreadPool;
+
+	// Block compressed formats the encoder writes, all on 4x4 pixel blocks
+	enum class BcFormat : uint8_t
+	{
+		BC1,	//RGB, 8 bytes a block
+		BC3,	//RGB + separately coded alpha, 16 bytes
+		BC5,	//Two independent channels taken from red & green, for normal maps, 16 bytes
+		BC7		//RGBA at much higher quality than BC3, 16 bytes. Only mode 6 is written
+	};
+
+	uint32_t getBcBlockBytes(BcFormat format);
+
+	// Encode one block of 16 RGBA8 pixels, row by row, into getBcBlockBytes(format) bytes.
+	// Index selection runs on Simd lanes over the block's pixels.
+	void encodeBc1Block(const uint8_t* pixels, uint8_t* block);
+	void encodeBc3Block(const uint8_t* pixels, uint8_t* block);
+	void encodeBc5Block(const uint8_t* pixels, uint8_t* block);
+	void encodeBc7Block(const uint8_t* pixels, uint8_t* block);
+
+	// Compresses a tightly packed RGBA8 image, rows of blocks spread over threadPool when given.
+	// Partial blocks at the right & bottom edges repeat the last column & row.
+	std::vector<uint8_t> compressImage(const uint8_t* pixels, uint32_t width, uint32_t height, BcFormat format, DyneThreadPool* threadPool = nullptr);
+}
@@ -0,0 +1,298 @@
+#include "DyneMeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Dyne
+{
+	namespace
+	{
+		//FIFO cache as timestamps, a vertex is cached while fewer than cacheSize misses happened since it was loaded
+		struct CacheSimulation
+		{
+			std::vector<uint32_t> loadTimes;
+			uint32_t time;
+			uint32_t cacheSize;
+
+			CacheSimulation(uint32_t vertexCount, uint32_t size) : loadTimes(vertexCount, 0), time(size + 1), cacheSize(size)
+			{
+
+			}
+
+			bool isCached(uint32_t vertex) const { return time - loadTimes[vertex] <= cacheSize; }
+
+			//Returns true on a miss
+			bool access(uint32_t vertex)
+			{
+				if (isCached(vertex)) return false;
+				loadTimes[vertex] = time++;
+				return true;
+			}
+
+			void flush() { time += cacheSize + 1; }
+		};
+
+		//Triangles around every vertex, those of vertex v are [offsets[v], offsets[v + 1])
+		void buildTriangleAdjacency(
+			const uint32_t* indices,
+			size_t indexCount,
+			uint32_t vertexCount,
+			std::vector<uint32_t>& offsets,
+			std::vector<uint32_t>& triangles)
+		{
+			offsets.assign(vertexCount + 1, 0);
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				offsets[indices[i] + 1]++;
+			}
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				offsets[v + 1] += offsets[v];
+			}
+
+			triangles.resize(indexCount);
+			std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+	}
+
+	VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStats stats{};
+		if (indexCount < 3) return stats;
+
+		CacheSimulation cache(vertexCount, cacheSize);
+		std::vector<uint8_t> referenced(vertexCount, 0);
+		uint32_t misses = 0;
+		uint32_t referencedCount = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			misses += cache.access(indices[i]);
+			referencedCount += referenced[indices[i]] == 0;
+			referenced[indices[i]] = 1;
+		}
+
+		stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+		stats.atvr = static_cast<float>(misses) / static_cast<float>(referencedCount);
+		return stats;
+	}
+
+	void optimizeVertexCache(
+		uint32_t* indices,
+		size_t indexCount,
+		uint32_t vertexCount,
+		uint32_t cacheSize,
+		std::vector<uint32_t>* clusterStarts)
+	{
+		assert(indexCount % 3 == 0 && "Index count must be a multiple of 3!");
+		if (clusterStarts != nullptr) clusterStarts->clear();
+		if (indexCount == 0) return;
+
+		uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+		std::vector<uint32_t> adjacencyOffsets;
+		std::vector<uint32_t> adjacency;
+		buildTriangleAdjacency(indices, indexCount, vertexCount, adjacencyOffsets, adjacency);
+
+		//Triangles still to be emitted around every vertex
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+		}
+
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> output;
+		output.reserve(indexCount);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		CacheSimulation cache(vertexCount, cacheSize);
+		uint32_t scanCursor = 0;
+
+		//Fanning starts at the first vertex that has triangles
+		while (scanCursor < vertexCount && liveTriangles[scanCursor] == 0) scanCursor++;
+		uint32_t fanVertex = scanCursor;
+		if (clusterStarts != nullptr) clusterStarts->push_back(0);
+
+		while (fanVertex < vertexCount)
+		{
+			//Emit every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (uint32_t a = adjacencyOffsets[fanVertex]; a < adjacencyOffsets[fanVertex + 1]; a++)
+			{
+				uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) continue;
+				emitted[triangle] = 1;
+
+				for (int corner = 0; corner < 3; corner++)
+				{
+					uint32_t vertex = indices[triangle * 3 + corner];
+					output.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+					cache.access(vertex);
+				}
+			}
+
+			//Next fan around the candidate that stays in the cache longest without being evicted by its own triangles
+			uint32_t nextVertex = vertexCount;
+			int bestPriority = -1;
+			for (uint32_t vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0) continue;
+
+				int priority = 0;
+				uint32_t age = cache.time - cache.loadTimes[vertex];
+				if (age + 2 * liveTriangles[vertex] <= cacheSize) priority = static_cast<int>(age);
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					nextVertex = vertex;
+				}
+			}
+
+			//Dead end, back up through recently used vertices, then fall back to a scan
+			if (nextVertex == vertexCount)
+			{
+				while (!deadEnds.empty() && nextVertex == vertexCount)
+				{
+					uint32_t vertex = deadEnds.back();
+					deadEnds.pop_back();
+					if (liveTriangles[vertex] > 0) nextVertex = vertex;
+				}
+				if (nextVertex == vertexCount)
+				{
+					while (scanCursor < vertexCount && liveTriangles[scanCursor] == 0) scanCursor++;
+					nextVertex = scanCursor;
+					if (clusterStarts != nullptr && nextVertex < vertexCount) clusterStarts->push_back(static_cast<uint32_t>(output.size() / 3));
+				}
+			}
+
+			fanVertex = nextVertex;
+		}
+
+		assert(output.size() == indexCount && "Cache optimization lost triangles!");
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	void optimizeOverdraw(
+		uint32_t* indices,
+		size_t indexCount,
+		const std::vector<glm::vec3>& positions,
+		float threshold,
+		uint32_t cacheSize)
+	{
+		assert(indexCount % 3 == 0 && "Index count must be a multiple of 3!");
+		if (indexCount == 0) return;
+
+		uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+		uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+
+		//Hard boundaries are where the cache order had to jump anyway, splitting there costs nothing
+		std::vector<uint32_t> hardStarts;
+		optimizeVertexCache(indices, indexCount, vertexCount, cacheSize, &hardStarts);
+		hardStarts.push_back(triangleCount);
+
+		float targetAcmr = analyzeVertexCache(indices, indexCount, vertexCount, cacheSize).acmr * threshold;
+
+		//Soft boundaries split a cluster wherever restarting with a cold cache keeps it under the target
+		std::vector<uint32_t> clusterStarts;
+		CacheSimulation cache(vertexCount, cacheSize);
+		for (size_t h = 0; h + 1 < hardStarts.size(); h++)
+		{
+			uint32_t clusterStart = hardStarts[h];
+			uint32_t misses = 0;
+			clusterStarts.push_back(clusterStart);
+			cache.flush();
+
+			for (uint32_t t = hardStarts[h]; t < hardStarts[h + 1]; t++)
+			{
+				for (int corner = 0; corner < 3; corner++)
+				{
+					misses += cache.access(indices[t * 3 + corner]);
+				}
+
+				uint32_t clusterSize = t + 1 - clusterStart;
+				if (t + 1 < hardStarts[h + 1] && static_cast<float>(misses) <= targetAcmr * static_cast<float>(clusterSize))
+				{
+					clusterStart = t + 1;
+					misses = 0;
+					clusterStarts.push_back(clusterStart);
+					cache.flush();
+				}
+			}
+		}
+		clusterStarts.push_back(triangleCount);
+
+		//Area weighted centroid of the whole mesh
+		glm::vec3 meshCenter{ 0.0f };
+		float meshArea = 0.0f;
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			const glm::vec3& p0 = positions[indices[t * 3]];
+			const glm::vec3& p1 = positions[indices[t * 3 + 1]];
+			const glm::vec3& p2 = positions[indices[t * 3 + 2]];
+			float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+			meshCenter += (p0 + p1 + p2) * area;
+			meshArea += area * 3.0f;
+		}
+		if (meshArea > 0.0f) meshCenter /= meshArea;
+
+		//Clusters facing away from the center are on the outside and likely in front, they are drawn first
+		struct Cluster
+		{
+			uint32_t first;
+			uint32_t count;
+			float sortKey;
+		};
+		std::vector<Cluster> clusters(clusterStarts.size() - 1);
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			Cluster& cluster = clusters[c];
+			cluster.first = clusterStarts[c];
+			cluster.count = clusterStarts[c + 1] - clusterStarts[c];
+
+			glm::vec3 centroid{ 0.0f };
+			glm::vec3 normal{ 0.0f };
+			float area = 0.0f;
+			for (uint32_t t = cluster.first; t < cluster.first + cluster.count; t++)
+			{
+				const glm::vec3& p0 = positions[indices[t * 3]];
+				const glm::vec3& p1 = positions[indices[t * 3 + 1]];
+				const glm::vec3& p2 = positions[indices[t * 3 + 2]];
+				glm::vec3 triangleNormal = glm::cross(p1 - p0, p2 - p0);
+				float triangleArea = glm::length(triangleNormal);
+				centroid += (p0 + p1 + p2) * triangleArea;
+				normal += triangleNormal;
+				area += triangleArea * 3.0f;
+			}
+			if (area > 0.0f) centroid /= area;
+			float normalLength = glm::length(normal);
+			cluster.sortKey = normalLength > 0.0f ? glm::dot(centroid - meshCenter, normal / normalLength) : 0.0f;
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+		std::vector<uint32_t> reordered;
+		reordered.reserve(indexCount);
+		for (const Cluster& cluster : clusters)
+		{
+			reordered.insert(reordered.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+		}
+		std::copy(reordered.begin(), reordered.end(), indices);
+	}
+
+	std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t& usedVertexCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, NOT_REFERENCED);
+		usedVertexCount = 0;
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == NOT_REFERENCED) remap[index] = usedVertexCount++;
+			index = remap[index];
+		}
+		return remap;
+	}
+}
\ No newline at end of file
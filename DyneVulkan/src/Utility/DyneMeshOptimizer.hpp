@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Dyne
+{
+	// Post transform cache size the optimizations target, close to what current GPUs reuse
+	constexpr uint32_t DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+	struct VertexCacheStats
+	{
+		// Average cache miss ratio, vertex shader runs per triangle. 0.5 is the ideal for big regular meshes, 3 the worst
+		float acmr = 0.0f;
+		// Average transformed vertex ratio, vertex shader runs per referenced vertex. 1 is the ideal
+		float atvr = 0.0f;
+	};
+
+	// Simulates a FIFO post transform cache over a triangle list
+	VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+
+	// Reorders the triangles for the post transform cache (Tipsify, Sander et al. 2007).
+	// clusterStarts receives the first triangle of every spot where the walk had to jump, the cache is cold there.
+	void optimizeVertexCache(
+		uint32_t* indices,
+		size_t indexCount,
+		uint32_t vertexCount,
+		uint32_t cacheSize = DEFAULT_VERTEX_CACHE_SIZE,
+		std::vector<uint32_t>* clusterStarts = nullptr);
+
+	// Reorders cache optimized triangles to draw the outside of the mesh first, so less of it gets shaded and then hidden.
+	// The order is split into clusters that may raise the ACMR by at most threshold, clusters facing away from the
+	// center go first.
+	void optimizeOverdraw(
+		uint32_t* indices,
+		size_t indexCount,
+		const std::vector<glm::vec3>& positions,
+		float threshold = 1.05f,
+		uint32_t cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+
+	// Renumbers the vertices in the order the indices first use them, so vertex fetches walk memory forward.
+	// Rewrites indices and returns the new index of every old vertex, NOT_REFERENCED for vertices no index uses.
+	constexpr uint32_t NOT_REFERENCED = ~0u;
+	std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t& usedVertexCount);
+}
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include "DyneMeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Dyne
+{
+	namespace
+	{
+		//Open edges weigh this much more than faces, so outlines survive longer than interior detail
+		constexpr float BORDER_WEIGHT = 10.0f;
+
+		//Sum of weighted squared distances to a set of planes, (n.p + d)^2 expanded into its symmetric terms
+		struct Quadric
+		{
+			float xx = 0.0f, yy = 0.0f, zz = 0.0f, xy = 0.0f, xz = 0.0f, yz = 0.0f;
+			float dx = 0.0f, dy = 0.0f, dz = 0.0f, dd = 0.0f;
+			float weight = 0.0f;
+
+			void addPlane(glm::vec3 normal, float distance, float planeWeight)
+			{
+				xx += planeWeight * normal.x * normal.x;
+				yy += planeWeight * normal.y * normal.y;
+				zz += planeWeight * normal.z * normal.z;
+				xy += planeWeight * normal.x * normal.y;
+				xz += planeWeight * normal.x * normal.z;
+				yz += planeWeight * normal.y * normal.z;
+				dx += planeWeight * normal.x * distance;
+				dy += planeWeight * normal.y * distance;
+				dz += planeWeight * normal.z * distance;
+				dd += planeWeight * distance * distance;
+				weight += planeWeight;
+			}
+
+			void add(const Quadric& other)
+			{
+				xx += other.xx; yy += other.yy; zz += other.zz;
+				xy += other.xy; xz += other.xz; yz += other.yz;
+				dx += other.dx; dy += other.dy; dz += other.dz;
+				dd += other.dd;
+				weight += other.weight;
+			}
+
+			//Weighted mean squared distance of p to the planes
+			float evaluate(glm::vec3 p) const
+			{
+				float sum =
+					xx * p.x * p.x + yy * p.y * p.y + zz * p.z * p.z +
+					2.0f * (xy * p.x * p.y + xz * p.x * p.z + yz * p.y * p.z) +
+					2.0f * (dx * p.x + dy * p.y + dz * p.z) + dd;
+				return weight > 0.0f ? std::fabs(sum) / weight : 0.0f;
+			}
+		};
+
+		enum class VertexKind : uint8_t
+		{
+			Manifold,	//Collapses onto any neighbour
+			Border,		//On one open boundary, only collapses along it
+			Locked		//Seams, corners & non manifold vertices stay where they are
+		};
+
+		struct Collapse
+		{
+			uint32_t from;
+			//The vertex (not just the position) the triangles of from switch to, keeps the attributes on from's side of a seam
+			uint32_t to;
+			float error;
+		};
+
+		uint64_t edgeKey(uint32_t a, uint32_t b)
+		{
+			return (static_cast<uint64_t>(a) << 32) | b;
+		}
+	}
+
+	std::vector<uint32_t> simplifyMesh(
+		const std::vector<glm::vec3>& positions,
+		const std::vector<uint32_t>& indices,
+		size_t targetIndexCount,
+		float targetError,
+		float* resultError)
+	{
+		std::vector<uint32_t> result = indices;
+		if (resultError != nullptr) *resultError = 0.0f;
+
+		uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+		if (result.size() <= targetIndexCount || vertexCount == 0) return result;
+
+		//Vertices that only differ in their attributes share a position, the first of them stands in for all.
+		//Collapsing just one of them would tear the seam open, so shared positions are locked.
+		std::vector<uint32_t> canonical(vertexCount);
+		std::vector<VertexKind> kinds(vertexCount, VertexKind::Manifold);
+		{
+			std::vector<uint32_t> sorted(vertexCount);
+			std::iota(sorted.begin(), sorted.end(), 0);
+			std::sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b)
+			{
+				const glm::vec3& pa = positions[a];
+				const glm::vec3& pb = positions[b];
+				if (pa.x != pb.x) return pa.x < pb.x;
+				if (pa.y != pb.y) return pa.y < pb.y;
+				return pa.z < pb.z;
+			});
+
+			for (uint32_t first = 0; first < vertexCount;)
+			{
+				uint32_t last = first + 1;
+				while (last < vertexCount && positions[sorted[last]] == positions[sorted[first]]) last++;
+
+				for (uint32_t i = first; i < last; i++)
+				{
+					canonical[sorted[i]] = sorted[first];
+				}
+				if (last - first > 1) kinds[sorted[first]] = VertexKind::Locked;
+				first = last;
+			}
+		}
+
+		auto isDegenerate = [&](const uint32_t* triangle)
+		{
+			uint32_t a = canonical[triangle[0]];
+			uint32_t b = canonical[triangle[1]];
+			uint32_t c = canonical[triangle[2]];
+			return a == b || b == c || c == a;
+		};
+
+		//Half edges between canonical vertices, an edge is open when its twin is missing
+		std::vector<uint64_t> halfEdges;
+		auto buildHalfEdges = [&]()
+		{
+			halfEdges.clear();
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (int e = 0; e < 3; e++)
+				{
+					halfEdges.push_back(edgeKey(canonical[result[i + e]], canonical[result[i + (e + 1) % 3]]));
+				}
+			}
+			std::sort(halfEdges.begin(), halfEdges.end());
+		};
+		auto hasHalfEdge = [&](uint32_t a, uint32_t b)
+		{
+			return std::binary_search(halfEdges.begin(), halfEdges.end(), edgeKey(a, b));
+		};
+		auto isOpenEdge = [&](uint32_t a, uint32_t b)
+		{
+			return hasHalfEdge(a, b) != hasHalfEdge(b, a);
+		};
+
+		//Drop triangles that are degenerate to begin with
+		size_t writeIndex = 0;
+		for (size_t i = 0; i + 2 < result.size(); i += 3)
+		{
+			if (isDegenerate(&result[i])) continue;
+			std::copy_n(&result[i], 3, &result[writeIndex]);
+			writeIndex += 3;
+		}
+		result.resize(writeIndex);
+		buildHalfEdges();
+
+		//Vertices on open edges become borders, unless several boundaries meet in them
+		std::vector<Quadric> quadrics(vertexCount);
+		std::vector<uint8_t> openEdgeCounts(vertexCount, 0);
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t corners[3] = { canonical[result[i]], canonical[result[i + 1]], canonical[result[i + 2]] };
+			glm::vec3 p0 = positions[corners[0]];
+			glm::vec3 normal = glm::cross(positions[corners[1]] - p0, positions[corners[2]] - p0);
+			float doubleArea = glm::length(normal);
+			if (doubleArea == 0.0f) continue;
+			normal /= doubleArea;
+
+			for (uint32_t corner : corners)
+			{
+				quadrics[corner].addPlane(normal, -glm::dot(normal, p0), doubleArea * 0.5f);
+			}
+
+			for (int e = 0; e < 3; e++)
+			{
+				uint32_t a = corners[e];
+				uint32_t b = corners[(e + 1) % 3];
+				if (!isOpenEdge(a, b)) continue;
+
+				openEdgeCounts[a] = static_cast<uint8_t>(std::min(openEdgeCounts[a] + 1, 255));
+				openEdgeCounts[b] = static_cast<uint8_t>(std::min(openEdgeCounts[b] + 1, 255));
+
+				//Plane through the edge standing upright on the triangle keeps the outline in place
+				glm::vec3 edge = positions[b] - positions[a];
+				float edgeLength = glm::length(edge);
+				if (edgeLength == 0.0f) continue;
+				glm::vec3 edgeNormal = glm::normalize(glm::cross(edge, normal));
+				float distance = -glm::dot(edgeNormal, positions[a]);
+				quadrics[a].addPlane(edgeNormal, distance, edgeLength * edgeLength * BORDER_WEIGHT);
+				quadrics[b].addPlane(edgeNormal, distance, edgeLength * edgeLength * BORDER_WEIGHT);
+			}
+		}
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if (kinds[v] != VertexKind::Manifold || openEdgeCounts[v] == 0) continue;
+			kinds[v] = openEdgeCounts[v] == 2 ? VertexKind::Border : VertexKind::Locked;
+		}
+
+		const float errorLimit = targetError * targetError;
+		float maxError = 0.0f;
+
+		std::vector<uint32_t> adjacencyOffsets;
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> collapses;
+		std::vector<uint8_t> touched;
+		std::vector<uint32_t> collapseTargets(vertexCount);
+
+		//Each pass collapses the cheapest edges whose neighbourhoods don't overlap, then rewrites the triangles
+		while (result.size() > targetIndexCount)
+		{
+			uint32_t triangleCount = static_cast<uint32_t>(result.size() / 3);
+
+			//Triangles around each canonical vertex
+			adjacencyOffsets.assign(vertexCount + 1, 0);
+			for (uint32_t index : result)
+			{
+				adjacencyOffsets[canonical[index] + 1]++;
+			}
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			}
+			adjacency.resize(result.size());
+			{
+				std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; t++)
+				{
+					for (int corner = 0; corner < 3; corner++)
+					{
+						adjacency[cursors[canonical[result[t * 3 + corner]]]++] = t;
+					}
+				}
+			}
+
+			collapses.clear();
+			auto addCollapse = [&](uint32_t from, uint32_t to)
+			{
+				uint32_t fromVertex = canonical[from];
+				uint32_t toVertex = canonical[to];
+				if (kinds[fromVertex] == VertexKind::Locked) return;
+				if (kinds[fromVertex] == VertexKind::Border && (kinds[toVertex] == VertexKind::Manifold || !isOpenEdge(fromVertex, toVertex))) return;
+
+				Quadric merged = quadrics[fromVertex];
+				merged.add(quadrics[toVertex]);
+				collapses.push_back(Collapse{ fromVertex, to, merged.evaluate(positions[toVertex]) });
+			};
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (int e = 0; e < 3; e++)
+				{
+					//Inner edges show up in two triangles, only one of them adds the pair
+					uint32_t a = result[i + e];
+					uint32_t b = result[i + (e + 1) % 3];
+					if (canonical[a] > canonical[b] && hasHalfEdge(canonical[b], canonical[a])) continue;
+					addCollapse(a, b);
+					addCollapse(b, a);
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+			//Moving from onto to must not turn any remaining triangle around from over
+			auto flipsTriangle = [&](uint32_t fromVertex, uint32_t toVertex)
+			{
+				for (uint32_t a = adjacencyOffsets[fromVertex]; a < adjacencyOffsets[fromVertex + 1]; a++)
+				{
+					const uint32_t* triangle = &result[adjacency[a] * 3];
+					glm::vec3 corners[3];
+					bool vanishes = false;
+					for (int corner = 0; corner < 3; corner++)
+					{
+						uint32_t vertex = canonical[triangle[corner]];
+						vanishes |= vertex == toVertex;
+						corners[corner] = positions[vertex];
+					}
+					if (vanishes) continue;
+
+					glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+					for (int corner = 0; corner < 3; corner++)
+					{
+						if (canonical[triangle[corner]] == fromVertex) corners[corner] = positions[toVertex];
+					}
+					glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+					if (glm::dot(before, after) <= 0.0f) return true;
+				}
+				return false;
+			};
+
+			size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+			size_t removedTriangles = 0;
+			uint32_t collapseCount = 0;
+			touched.assign(vertexCount, 0);
+			std::iota(collapseTargets.begin(), collapseTargets.end(), 0);
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapse.error > errorLimit || removedTriangles >= trianglesToRemove) break;
+
+				uint32_t toVertex = canonical[collapse.to];
+				if (touched[collapse.from] || touched[toVertex]) continue;
+				if (flipsTriangle(collapse.from, toVertex)) continue;
+
+				//The whole one ring is locked for the rest of the pass, so the flip test above stays valid
+				for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++)
+				{
+					const uint32_t* triangle = &result[adjacency[a] * 3];
+					bool vanishes = false;
+					for (int corner = 0; corner < 3; corner++)
+					{
+						uint32_t vertex = canonical[triangle[corner]];
+						touched[vertex] = 1;
+						vanishes |= vertex == toVertex;
+					}
+					removedTriangles += vanishes;
+				}
+
+				collapseTargets[collapse.from] = collapse.to;
+				quadrics[toVertex].add(quadrics[collapse.from]);
+				maxError = std::max(maxError, collapse.error);
+				collapseCount++;
+			}
+			if (collapseCount == 0) break;
+
+			writeIndex = 0;
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				uint32_t triangle[3] = { collapseTargets[result[i]], collapseTargets[result[i + 1]], collapseTargets[result[i + 2]] };
+				if (isDegenerate(triangle)) continue;
+				std::copy_n(triangle, 3, &result[writeIndex]);
+				writeIndex += 3;
+			}
+			result.resize(writeIndex);
+			buildHalfEdges();
+		}
+
+		if (resultError != nullptr) *resultError = std::sqrt(maxError);
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Dyne
+{
+	// Quadric error edge collapse simplification. The cheapest edges are collapsed first until the index count
+	// drops to targetIndexCount or the next collapse would move the surface further than targetError, a distance
+	// in the units of positions. Open borders only collapse along themselves and vertices split by attribute
+	// seams stay in place, so the outline and the seams don't tear.
+	// Returns a triangle list over the same vertices, resultError receives the largest error introduced.
+	std::vector<uint32_t> simplifyMesh(
+		const std::vector<glm::vec3>& positions,
+		const std::vector<uint32_t>& indices,
+		size_t targetIndexCount,
+		float targetError,
+		float* resultError = nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "DyneMeshlets.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+namespace Dyne
+{
+	namespace
+	{
+		void computeMeshletBounds(Meshlet& meshlet, const uint32_t* indices, const std::vector<glm::vec3>& positions)
+		{
+			const uint32_t* first = indices + meshlet.firstIndex;
+
+			glm::vec3 minPos = positions[first[0]];
+			glm::vec3 maxPos = positions[first[0]];
+			for (uint32_t i = 1; i < meshlet.indexCount; i++)
+			{
+				minPos = glm::min(minPos, positions[first[i]]);
+				maxPos = glm::max(maxPos, positions[first[i]]);
+			}
+			meshlet.center = (minPos + maxPos) * 0.5f;
+			meshlet.radius = 0.0f;
+			for (uint32_t i = 0; i < meshlet.indexCount; i++)
+			{
+				meshlet.radius = std::max(meshlet.radius, glm::length(positions[first[i]] - meshlet.center));
+			}
+
+			//Cone around the average face normal, wide enough for the normal furthest from it
+			std::vector<glm::vec3> normals;
+			normals.reserve(meshlet.indexCount / 3);
+			glm::vec3 normalSum{ 0.0f };
+			for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+			{
+				const glm::vec3& p0 = positions[first[i]];
+				const glm::vec3& p1 = positions[first[i + 1]];
+				const glm::vec3& p2 = positions[first[i + 2]];
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float length = glm::length(normal);
+				if (length <= 0.0f) continue;
+
+				normals.push_back(normal / length);
+				normalSum += normals.back();
+			}
+
+			float sumLength = glm::length(normalSum);
+			if (normals.empty() || sumLength <= 1e-6f) return;
+
+			glm::vec3 axis = normalSum / sumLength;
+			float minDot = 1.0f;
+			for (const glm::vec3& normal : normals)
+			{
+				minDot = std::min(minDot, glm::dot(normal, axis));
+			}
+
+			//Half angles of 90 degrees and more always have some triangle facing the viewer
+			if (minDot <= 0.0f) return;
+
+			meshlet.coneAxis = axis;
+			meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+		}
+	}
+
+	std::vector<Meshlet> buildMeshlets(
+		uint32_t* indices,
+		size_t indexCount,
+		const std::vector<glm::vec3>& positions,
+		uint32_t maxVertices,
+		uint32_t maxTriangles)
+	{
+		assert(indexCount % 3 == 0 && "Index count must be a multiple of 3!");
+		assert(maxVertices >= 3 && maxTriangles >= 1 && "Meshlets must hold at least one triangle!");
+
+		std::vector<Meshlet> meshlets;
+		if (indexCount == 0) return meshlets;
+
+		uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+		uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+
+		//Triangles around every vertex, those of vertex v are [adjacencyOffsets[v], adjacencyOffsets[v + 1])
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			adjacencyOffsets[indices[i] + 1]++;
+		}
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+		std::vector<uint32_t> adjacency(indexCount);
+		std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<glm::vec3> centroids(triangleCount);
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			centroids[t] = (positions[indices[t * 3]] + positions[indices[t * 3 + 1]] + positions[indices[t * 3 + 2]]) / 3.0f;
+		}
+
+		//A vertex is part of the current meshlet when its stamp matches the meshlet's number
+		std::vector<uint32_t> stamps(vertexCount, ~0u);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> meshletVertices;
+		std::vector<uint32_t> output;
+		output.reserve(indexCount);
+
+		auto countNewVertices = [&](uint32_t triangle, uint32_t meshletNumber)
+		{
+			const uint32_t* corners = &indices[triangle * 3];
+			uint32_t count = stamps[corners[0]] != meshletNumber;
+			count += stamps[corners[1]] != meshletNumber && corners[1] != corners[0];
+			count += stamps[corners[2]] != meshletNumber && corners[2] != corners[0] && corners[2] != corners[1];
+			return count;
+		};
+
+		Meshlet current{};
+		glm::vec3 centroidSum{ 0.0f };
+		uint32_t meshletNumber = 0;
+		uint32_t seedCursor = 0;
+
+		auto finishMeshlet = [&]()
+		{
+			meshlets.push_back(current);
+			current = Meshlet{};
+			current.firstIndex = static_cast<uint32_t>(output.size());
+			centroidSum = glm::vec3{ 0.0f };
+			meshletVertices.clear();
+			meshletNumber++;
+		};
+
+		for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			//Grow the meshlet by the adjacent triangle adding the fewest vertices, then the one closest to its center
+			uint32_t next = triangleCount;
+			if (current.indexCount > 0)
+			{
+				glm::vec3 center = centroidSum / static_cast<float>(current.indexCount / 3);
+				uint32_t bestNewVertices = ~0u;
+				float bestDistance = 0.0f;
+				for (uint32_t vertex : meshletVertices)
+				{
+					for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++)
+					{
+						uint32_t triangle = adjacency[a];
+						if (emitted[triangle]) continue;
+
+						uint32_t newVertices = countNewVertices(triangle, meshletNumber);
+						if (current.vertexCount + newVertices > maxVertices) continue;
+
+						glm::vec3 offset = centroids[triangle] - center;
+						float distance = glm::dot(offset, offset);
+						if (newVertices < bestNewVertices || (newVertices == bestNewVertices && distance < bestDistance))
+						{
+							next = triangle;
+							bestNewVertices = newVertices;
+							bestDistance = distance;
+						}
+					}
+				}
+
+				//Nothing connected fits, the next seed starts a new meshlet
+				if (next == triangleCount) finishMeshlet();
+			}
+
+			if (next == triangleCount)
+			{
+				while (emitted[seedCursor]) seedCursor++;
+				next = seedCursor;
+			}
+
+			uint32_t newVertices = countNewVertices(next, meshletNumber);
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = indices[next * 3 + corner];
+				if (stamps[vertex] != meshletNumber)
+				{
+					stamps[vertex] = meshletNumber;
+					meshletVertices.push_back(vertex);
+				}
+				output.push_back(vertex);
+			}
+			emitted[next] = 1;
+			centroidSum += centroids[next];
+			current.vertexCount += newVertices;
+			current.indexCount += 3;
+
+			if (current.indexCount / 3 == maxTriangles) finishMeshlet();
+		}
+		if (current.indexCount > 0) meshlets.push_back(current);
+
+		std::copy(output.begin(), output.end(), indices);
+		for (Meshlet& meshlet : meshlets)
+		{
+			computeMeshletBounds(meshlet, indices, positions);
+		}
+		return meshlets;
+	}
+
+	bool isClosedMesh(const uint32_t* indices, size_t indexCount, const std::vector<glm::vec3>& positions)
+	{
+		if (indexCount == 0) return false;
+
+		//Weld vertices with equal positions, so uv & normal seams don't count as open edges
+		std::vector<uint32_t> order(positions.size());
+		std::iota(order.begin(), order.end(), 0u);
+		auto lessPosition = [&](uint32_t a, uint32_t b)
+		{
+			const glm::vec3& pa = positions[a];
+			const glm::vec3& pb = positions[b];
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			return pa.z < pb.z;
+		};
+		std::sort(order.begin(), order.end(), lessPosition);
+
+		std::vector<uint32_t> welded(positions.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			bool samePosition = i > 0 && positions[order[i]] == positions[order[i - 1]];
+			welded[order[i]] = samePosition ? welded[order[i - 1]] : order[i];
+		}
+
+		std::vector<uint64_t> edges;
+		edges.reserve(indexCount);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t from = welded[indices[i + corner]];
+				uint32_t to = welded[indices[i + (corner + 1) % 3]];
+				if (from != to) edges.push_back((static_cast<uint64_t>(from) << 32) | to);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		//Each edge needs its twin running the other way
+		for (uint64_t edge : edges)
+		{
+			uint64_t twin = (edge << 32) | (edge >> 32);
+			if (!std::binary_search(edges.begin(), edges.end(), twin)) return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Dyne
+{
+	// Limits of one meshlet, the usual mesh shader sizes so the clusters stay small enough to cull usefully
+	constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+	constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	// A run of consecutive triangles of an index list, with the bounds the cluster culling tests against
+	struct Meshlet
+	{
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		uint32_t vertexCount = 0;
+
+		glm::vec3 center{ 0.0f };
+		float radius = 0.0f;
+
+		// Every triangle normal is within the cone around coneAxis. coneCutoff is the sine of its half angle,
+		// 1 when the triangles can't all face away from a viewpoint at once
+		glm::vec3 coneAxis{ 0.0f, 0.0f, 1.0f };
+		float coneCutoff = 1.0f;
+	};
+
+	// Groups the triangles into meshlets, each grown from a seed over adjacent triangles while it stays compact and
+	// within the limits. Rewrites indices so every meshlet is a consecutive range, seeds follow the current order.
+	std::vector<Meshlet> buildMeshlets(
+		uint32_t* indices,
+		size_t indexCount,
+		const std::vector<glm::vec3>& positions,
+		uint32_t maxVertices = MESHLET_MAX_VERTICES,
+		uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+	// True when every edge is shared by two oppositely wound triangles, vertices welded by position.
+	// Only then are back faces always hidden and may clusters of them be culled.
+	bool isClosedMesh(const uint32_t* indices, size_t indexCount, const std::vector<glm::vec3>& positions);
+}
@@ -0,0 +1,49 @@
+#include "DyneRadixSort.hpp"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace Dyne
+{
+	void radixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch)
+	{
+		constexpr int PASS_COUNT = 8;
+		constexpr int BUCKET_COUNT = 256;
+
+		size_t keyCount = keys.size();
+		if (keyCount < 2) return;
+
+		//Histograms of every byte in one read of the keys, 8KB that stay on the stack
+		std::array<std::array<uint32_t, BUCKET_COUNT>, PASS_COUNT> histograms{};
+		for (uint64_t key : keys)
+		{
+			for (int pass = 0; pass < PASS_COUNT; pass++)
+			{
+				histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+			}
+		}
+
+		scratch.resize(keyCount);
+		for (int pass = 0; pass < PASS_COUNT; pass++)
+		{
+			auto& histogram = histograms[pass];
+			int shift = pass * 8;
+			if (histogram[(keys[0] >> shift) & 0xFF] == keyCount) continue;
+
+			uint32_t offset = 0;
+			for (auto& count : histogram)
+			{
+				uint32_t bucketSize = count;
+				count = offset;
+				offset += bucketSize;
+			}
+
+			for (uint64_t key : keys)
+			{
+				scratch[histogram[(key >> shift) & 0xFF]++] = key;
+			}
+			std::swap(keys, scratch);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Dyne
+{
+	//LSD radix sort of 64 bit keys, one byte per pass. Bytes that are the same in every key skip their pass,
+	//so unused key fields cost nothing. The sorted keys end up in keys, scratch is resized as needed.
+	void radixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch);
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+#include <cstdint>
+
+namespace Dyne
+{
+	// Thin wrappers over the widest float vector the build enables, so kernels are written once.
+	// AVX when the compiler targets it, the SSE2 baseline otherwise. Loads & stores must be 32 byte aligned.
+	namespace Simd
+	{
+#if defined(__AVX__)
+		using FloatLanes = __m256;
+		constexpr uint32_t LANE_WIDTH = 8;
+
+		inline FloatLanes load(const float* source) { return _mm256_load_ps(source); }
+		inline void store(float* destination, FloatLanes value) { _mm256_store_ps(destination, value); }
+		inline FloatLanes set1(float value) { return _mm256_set1_ps(value); }
+		inline FloatLanes add(FloatLanes a, FloatLanes b) { return _mm256_add_ps(a, b); }
+		inline FloatLanes sub(FloatLanes a, FloatLanes b) { return _mm256_sub_ps(a, b); }
+		inline FloatLanes mul(FloatLanes a, FloatLanes b) { return _mm256_mul_ps(a, b); }
+		inline FloatLanes div(FloatLanes a, FloatLanes b) { return _mm256_div_ps(a, b); }
+		inline FloatLanes roundNearest(FloatLanes value) { return _mm256_round_ps(value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		inline FloatLanes equal(FloatLanes a, FloatLanes b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+		inline FloatLanes greaterEqual(FloatLanes a, FloatLanes b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+		inline FloatLanes both(FloatLanes a, FloatLanes b) { return _mm256_and_ps(a, b); }
+		inline FloatLanes either(FloatLanes a, FloatLanes b) { return _mm256_or_ps(a, b); }
+		inline FloatLanes select(FloatLanes mask, FloatLanes a, FloatLanes b) { return _mm256_blendv_ps(b, a, mask); }
+		// One bit per lane, set where the mask lane is true
+		inline uint32_t maskBits(FloatLanes mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+#else
+		using FloatLanes = __m128;
+		constexpr uint32_t LANE_WIDTH = 4;
+
+		inline FloatLanes load(const float* source) { return _mm_load_ps(source); }
+		inline void store(float* destination, FloatLanes value) { _mm_store_ps(destination, value); }
+		inline FloatLanes set1(float value) { return _mm_set1_ps(value); }
+		inline FloatLanes add(FloatLanes a, FloatLanes b) { return _mm_add_ps(a, b); }
+		inline FloatLanes sub(FloatLanes a, FloatLanes b) { return _mm_sub_ps(a, b); }
+		inline FloatLanes mul(FloatLanes a, FloatLanes b) { return _mm_mul_ps(a, b); }
+		inline FloatLanes div(FloatLanes a, FloatLanes b) { return _mm_div_ps(a, b); }
+		// Only valid within the int32 range
+		inline FloatLanes roundNearest(FloatLanes value) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(value)); }
+		inline FloatLanes equal(FloatLanes a, FloatLanes b) { return _mm_cmpeq_ps(a, b); }
+		inline FloatLanes greaterEqual(FloatLanes a, FloatLanes b) { return _mm_cmpge_ps(a, b); }
+		inline FloatLanes both(FloatLanes a, FloatLanes b) { return _mm_and_ps(a, b); }
+		inline FloatLanes either(FloatLanes a, FloatLanes b) { return _mm_or_ps(a, b); }
+		inline FloatLanes select(FloatLanes mask, FloatLanes a, FloatLanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+		// One bit per lane, set where the mask lane is true
+		inline uint32_t maskBits(FloatLanes mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+#endif
+	}
+}
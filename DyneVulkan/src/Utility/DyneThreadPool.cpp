@@ -0,0 +1,149 @@
+#include "DyneThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+
+namespace Dyne
+{
+	namespace
+	{
+		//Shared with the pool jobs, a job that starts after every chunk was taken only touches this
+		struct ParallelForState
+		{
+			const DyneThreadPool::RangeFn* fn = nullptr;
+			uint32_t count = 0;
+			uint32_t chunkSize = 0;
+			uint32_t chunkCount = 0;
+
+			std::atomic<uint32_t> nextChunk{ 0 };
+
+			std::mutex mutex;
+			std::condition_variable chunksFinished;
+			uint32_t finishedChunks = 0;
+		};
+
+		void runChunks(ParallelForState& state)
+		{
+			for (uint32_t chunk = state.nextChunk.fetch_add(1); chunk < state.chunkCount; chunk = state.nextChunk.fetch_add(1))
+			{
+				uint32_t begin = chunk * state.chunkSize;
+				(*state.fn)(begin, std::min(begin + state.chunkSize, state.count));
+
+				{
+					std::lock_guard<std::mutex> lock(state.mutex);
+					state.finishedChunks++;
+				}
+				state.chunksFinished.notify_one();
+			}
+		}
+	}
+
+	uint32_t DyneThreadPool::defaultThreadCount()
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		return std::max(hardwareThreads, 2u) - 1;
+	}
+
+	DyneThreadPool::DyneThreadPool(uint32_t threadCount)
+	{
+		assert(threadCount > 0 && "Thread pool needs at least one worker!");
+
+		workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back(&DyneThreadPool::workerLoop, this);
+		}
+	}
+
+	DyneThreadPool::~DyneThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			stopping = true;
+		}
+		jobAvailable.notify_all();
+
+		//Queued jobs still run, owners may be waiting on their results
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void DyneThreadPool::submit(Job job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			assert(!stopping && "Cannot submit jobs to a stopping thread pool!");
+			jobs.push_back(std::move(job));
+		}
+		jobAvailable.notify_one();
+	}
+
+	void DyneThreadPool::waitIdle()
+	{
+		std::unique_lock<std::mutex> lock(jobMutex);
+		jobsFinished.wait(lock, [this]() { return jobs.empty() && runningJobs == 0; });
+	}
+
+	void DyneThreadPool::parallelFor(uint32_t count, uint32_t minItemsPerChunk, const RangeFn& fn)
+	{
+		assert(minItemsPerChunk > 0 && "Chunks must hold at least one item!");
+
+		if (count == 0) return;
+
+		//The calling thread works alongside the workers
+		uint32_t chunkCount = std::min((count + minItemsPerChunk - 1) / minItemsPerChunk, getThreadCount() + 1);
+		if (chunkCount <= 1)
+		{
+			fn(0, count);
+			return;
+		}
+
+		auto state = std::make_shared<ParallelForState>();
+		state->fn = &fn;
+		state->count = count;
+		state->chunkSize = (count + chunkCount - 1) / chunkCount;
+		state->chunkCount = (count + state->chunkSize - 1) / state->chunkSize;
+
+		for (uint32_t i = 1; i < state->chunkCount; i++)
+		{
+			submit([state]() { runChunks(*state); });
+		}
+		runChunks(*state);
+
+		//Chunks still running on workers have to finish before fn goes out of scope
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->chunksFinished.wait(lock, [&]() { return state->finishedChunks == state->chunkCount; });
+	}
+
+	void DyneThreadPool::workerLoop()
+	{
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(jobMutex);
+				jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (jobs.empty()) return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+				runningJobs++;
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock(jobMutex);
+				runningJobs--;
+				if (jobs.empty() && runningJobs == 0)
+				{
+					jobsFinished.notify_all();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Dyne
+{
+	// Fixed set of worker threads pulling jobs from one FIFO queue.
+	// Jobs must not throw or touch Vulkan queues, results are handed back to the main thread by the caller.
+	class DyneThreadPool
+	{
+	public:
+		using Job = std::function<void()>;
+		using RangeFn = std::function<void(uint32_t begin, uint32_t end)>;
+
+		// One thread is left for the main loop
+		static uint32_t defaultThreadCount();
+
+		explicit DyneThreadPool(uint32_t threadCount = defaultThreadCount());
+		~DyneThreadPool();
+
+		DyneThreadPool(const DyneThreadPool&) = delete;
+		DyneThreadPool& operator=(const DyneThreadPool&) = delete;
+
+		void submit(Job job);
+
+		// Blocks until the queue is empty and no job is running
+		void waitIdle();
+
+		// Splits [0, count) into chunks of at least minItemsPerChunk and runs fn on them across the workers
+		// and the calling thread. Returns once every chunk is done, fn must not throw.
+		void parallelFor(uint32_t count, uint32_t minItemsPerChunk, const RangeFn& fn);
+
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+		std::deque<Job> jobs;
+		std::mutex jobMutex;
+		std::condition_variable jobAvailable;
+		std::condition_variable jobsFinished;
+		uint32_t runningJobs = 0;
+		bool stopping = false;
+	};
+}
@@ -0,0 +1,430 @@
+#include "DyneTlsf.hpp"
+
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Dyne
+{
+	static uint32_t bitScanForward(uint64_t mask)
+	{
+		assert(mask != 0 && "Bit scan on empty mask!");
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(mask));
+#endif
+	}
+
+	static uint32_t bitScanReverse(uint64_t mask)
+	{
+		assert(mask != 0 && "Bit scan on empty mask!");
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return 63u - static_cast<uint32_t>(__builtin_clzll(mask));
+#endif
+	}
+
+	static uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	DyneTlsf::DyneTlsf(uint64_t size) : size(size)
+	{
+		assert(size > 0 && "Cannot create an empty TLSF range!");
+
+		freeLists.fill(INVALID_INDEX);
+
+		//Block 0 always starts at offset 0, merges only ever remove the upper neighbour
+		uint32_t first = createBlock();
+		blocks[first].offset = 0;
+		blocks[first].size = size;
+		blocks[first].isFree = true;
+		insertFreeBlock(first);
+	}
+
+	void DyneTlsf::mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+	{
+		if (size < SMALL_BLOCK_SIZE)
+		{
+			//Small sizes are spread linearly over the first level
+			fl = 0;
+			sl = static_cast<uint32_t>(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+		}
+		else
+		{
+			uint32_t msb = bitScanReverse(size);
+			fl = msb - SMALL_BLOCK_SIZE_LOG2 + 1;
+			sl = static_cast<uint32_t>(size >> (msb - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+		}
+	}
+
+	uint32_t DyneTlsf::findFreeBlock(uint64_t size) const
+	{
+		//Round up to the next class so that any block found is guaranteed to fit
+		uint64_t round = size < SMALL_BLOCK_SIZE
+			? SMALL_BLOCK_SIZE / SL_INDEX_COUNT - 1
+			: (1ull << (bitScanReverse(size) - SL_INDEX_COUNT_LOG2)) - 1;
+		if (size > ~0ull - round) return INVALID_INDEX;
+		size += round;
+
+		uint32_t fl, sl;
+		mapping(size, fl, sl);
+
+		uint32_t slMap = slBitmap[fl] & (~0u << sl);
+		if (slMap == 0)
+		{
+			uint64_t flMap = fl + 1 < 64 ? flBitmap & (~0ull << (fl + 1)) : 0;
+			if (flMap == 0) return INVALID_INDEX;
+
+			fl = bitScanForward(flMap);
+			slMap = slBitmap[fl];
+		}
+
+		sl = bitScanForward(slMap);
+		return freeLists[fl * SL_INDEX_COUNT + sl];
+	}
+
+	uint32_t DyneTlsf::findAlignedFit(uint64_t size, uint64_t alignment) const
+	{
+		//Classes below the request's only hold smaller blocks, the ones from the padded class up are empty
+		//or findFreeBlock would have succeeded, so only the few classes in between are walked
+		uint32_t fl, sl;
+		mapping(size, fl, sl);
+		while (fl < FL_INDEX_COUNT)
+		{
+			uint32_t slMap = slBitmap[fl] & (~0u << sl);
+			if (slMap == 0)
+			{
+				uint64_t flMap = fl + 1 < FL_INDEX_COUNT ? flBitmap & (~0ull << (fl + 1)) : 0;
+				if (flMap == 0) return INVALID_INDEX;
+
+				fl = bitScanForward(flMap);
+				sl = 0;
+				continue;
+			}
+
+			sl = bitScanForward(slMap);
+			for (uint32_t i = freeLists[fl * SL_INDEX_COUNT + sl]; i != INVALID_INDEX; i = blocks[i].nextFree)
+			{
+				if (alignUp(blocks[i].offset, alignment) + size <= blocks[i].offset + blocks[i].size) return i;
+			}
+
+			if (++sl == SL_INDEX_COUNT)
+			{
+				fl++;
+				sl = 0;
+			}
+		}
+		return INVALID_INDEX;
+	}
+
+	void DyneTlsf::insertFreeBlock(uint32_t blockIndex)
+	{
+		uint32_t fl, sl;
+		mapping(blocks[blockIndex].size, fl, sl);
+
+		uint32_t& head = freeLists[fl * SL_INDEX_COUNT + sl];
+		blocks[blockIndex].prevFree = INVALID_INDEX;
+		blocks[blockIndex].nextFree = head;
+		if (head != INVALID_INDEX)
+		{
+			blocks[head].prevFree = blockIndex;
+		}
+		head = blockIndex;
+
+		flBitmap |= 1ull << fl;
+		slBitmap[fl] |= 1u << sl;
+		freeBlockCount++;
+	}
+
+	void DyneTlsf::removeFreeBlock(uint32_t blockIndex)
+	{
+		Block& block = blocks[blockIndex];
+
+		if (block.prevFree != INVALID_INDEX)
+		{
+			blocks[block.prevFree].nextFree = block.nextFree;
+		}
+		if (block.nextFree != INVALID_INDEX)
+		{
+			blocks[block.nextFree].prevFree = block.prevFree;
+		}
+
+		uint32_t fl, sl;
+		mapping(block.size, fl, sl);
+
+		uint32_t& head = freeLists[fl * SL_INDEX_COUNT + sl];
+		if (head == blockIndex)
+		{
+			head = block.nextFree;
+			if (head == INVALID_INDEX)
+			{
+				slBitmap[fl] &= ~(1u << sl);
+				if (slBitmap[fl] == 0)
+				{
+					flBitmap &= ~(1ull << fl);
+				}
+			}
+		}
+
+		block.prevFree = INVALID_INDEX;
+		block.nextFree = INVALID_INDEX;
+		freeBlockCount--;
+	}
+
+	uint32_t DyneTlsf::splitBlock(uint32_t blockIndex, uint64_t size)
+	{
+		assert(blocks[blockIndex].size > size && "Split would leave an empty block!");
+
+		//createBlock may reallocate, so no references into blocks before this
+		uint32_t remainderIndex = createBlock();
+		Block& block = blocks[blockIndex];
+		Block& remainder = blocks[remainderIndex];
+
+		remainder.offset = block.offset + size;
+		remainder.size = block.size - size;
+		remainder.isFree = true;
+		remainder.prevPhysical = blockIndex;
+		remainder.nextPhysical = block.nextPhysical;
+		if (block.nextPhysical != INVALID_INDEX)
+		{
+			blocks[block.nextPhysical].prevPhysical = remainderIndex;
+		}
+
+		block.size = size;
+		block.nextPhysical = remainderIndex;
+		return remainderIndex;
+	}
+
+	void DyneTlsf::mergeWithNext(uint32_t blockIndex)
+	{
+		Block& block = blocks[blockIndex];
+		uint32_t nextIndex = block.nextPhysical;
+		const Block& next = blocks[nextIndex];
+
+		block.size += next.size;
+		block.nextPhysical = next.nextPhysical;
+		if (next.nextPhysical != INVALID_INDEX)
+		{
+			blocks[next.nextPhysical].prevPhysical = blockIndex;
+		}
+
+		releaseBlock(nextIndex);
+	}
+
+	uint32_t DyneTlsf::createBlock()
+	{
+		if (!unusedBlocks.empty())
+		{
+			uint32_t index = unusedBlocks.back();
+			unusedBlocks.pop_back();
+			blocks[index] = Block{};
+			return index;
+		}
+
+		blocks.emplace_back();
+		return static_cast<uint32_t>(blocks.size() - 1);
+	}
+
+	void DyneTlsf::releaseBlock(uint32_t blockIndex)
+	{
+		blocks[blockIndex] = Block{};
+		unusedBlocks.push_back(blockIndex);
+	}
+
+	uint64_t DyneTlsf::allocate(uint64_t size, uint64_t alignment)
+	{
+		assert(size > 0 && "Cannot allocate zero bytes!");
+		assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two!");
+
+		if (size > this->size) return INVALID_OFFSET;
+
+		uint64_t required = size + alignment - 1;
+		uint32_t blockIndex = findFreeBlock(required);
+
+		if (blockIndex == INVALID_INDEX)
+		{
+			//Good fit failed, a block between the request's class and the padded one may still fit
+			blockIndex = findAlignedFit(size, alignment);
+			if (blockIndex == INVALID_INDEX) return INVALID_OFFSET;
+		}
+
+		removeFreeBlock(blockIndex);
+
+		//Leading padding goes back to the free lists as its own block
+		uint64_t padding = alignUp(blocks[blockIndex].offset, alignment) - blocks[blockIndex].offset;
+		if (padding > 0)
+		{
+			uint32_t alignedIndex = splitBlock(blockIndex, padding);
+			blocks[blockIndex].isFree = true;
+			insertFreeBlock(blockIndex);
+			blockIndex = alignedIndex;
+		}
+
+		if (blocks[blockIndex].size > size)
+		{
+			uint32_t remainderIndex = splitBlock(blockIndex, size);
+			insertFreeBlock(remainderIndex);
+		}
+
+		Block& block = blocks[blockIndex];
+		block.isFree = false;
+		usedSize += block.size;
+		allocatedBlocks.emplace(block.offset, blockIndex);
+
+		return block.offset;
+	}
+
+	void DyneTlsf::free(uint64_t offset)
+	{
+		auto it = allocatedBlocks.find(offset);
+		assert(it != allocatedBlocks.end() && "Freeing an offset that was never allocated!");
+		if (it == allocatedBlocks.end()) return;
+
+		uint32_t blockIndex = it->second;
+		allocatedBlocks.erase(it);
+
+		usedSize -= blocks[blockIndex].size;
+		blocks[blockIndex].isFree = true;
+
+		uint32_t nextIndex = blocks[blockIndex].nextPhysical;
+		if (nextIndex != INVALID_INDEX && blocks[nextIndex].isFree)
+		{
+			removeFreeBlock(nextIndex);
+			mergeWithNext(blockIndex);
+		}
+
+		uint32_t prevIndex = blocks[blockIndex].prevPhysical;
+		if (prevIndex != INVALID_INDEX && blocks[prevIndex].isFree)
+		{
+			removeFreeBlock(prevIndex);
+			mergeWithNext(prevIndex);
+			blockIndex = prevIndex;
+		}
+
+		insertFreeBlock(blockIndex);
+	}
+
+	void DyneTlsf::grow(uint64_t newSize)
+	{
+		assert(newSize >= size && "TLSF ranges can only grow!");
+		if (newSize == size) return;
+
+		uint32_t lastIndex = 0;
+		while (blocks[lastIndex].nextPhysical != INVALID_INDEX)
+		{
+			lastIndex = blocks[lastIndex].nextPhysical;
+		}
+
+		if (blocks[lastIndex].isFree)
+		{
+			removeFreeBlock(lastIndex);
+			blocks[lastIndex].size += newSize - size;
+		}
+		else
+		{
+			uint32_t tailIndex = createBlock();
+			blocks[tailIndex].offset = size;
+			blocks[tailIndex].size = newSize - size;
+			blocks[tailIndex].isFree = true;
+			blocks[tailIndex].prevPhysical = lastIndex;
+			blocks[lastIndex].nextPhysical = tailIndex;
+			lastIndex = tailIndex;
+		}
+
+		insertFreeBlock(lastIndex);
+		size = newSize;
+	}
+
+	uint64_t DyneTlsf::getAllocationSize(uint64_t offset) const
+	{
+		auto it = allocatedBlocks.find(offset);
+		return it == allocatedBlocks.end() ? 0 : blocks[it->second].size;
+	}
+
+	DyneTlsf::Stats DyneTlsf::getStats() const
+	{
+		Stats stats{};
+		stats.totalSize = size;
+		stats.usedSize = usedSize;
+		stats.freeSize = size - usedSize;
+		stats.allocationCount = static_cast<uint32_t>(allocatedBlocks.size());
+		stats.freeRegionCount = freeBlockCount;
+
+		//The largest free block lives in the highest non-empty class
+		if (flBitmap != 0)
+		{
+			uint32_t fl = bitScanReverse(flBitmap);
+			uint32_t sl = bitScanReverse(slBitmap[fl]);
+			for (uint32_t i = freeLists[fl * SL_INDEX_COUNT + sl]; i != INVALID_INDEX; i = blocks[i].nextFree)
+			{
+				if (blocks[i].size > stats.largestFreeRegion)
+				{
+					stats.largestFreeRegion = blocks[i].size;
+				}
+			}
+		}
+
+		return stats;
+	}
+
+	bool DyneTlsf::validate() const
+	{
+		uint64_t expectedOffset = 0;
+		uint64_t used = 0;
+		uint32_t freeCount = 0;
+		uint32_t allocatedCount = 0;
+		uint32_t prevIndex = INVALID_INDEX;
+
+		for (uint32_t i = 0; i != INVALID_INDEX; i = blocks[i].nextPhysical)
+		{
+			const Block& block = blocks[i];
+
+			if (block.offset != expectedOffset || block.size == 0) return false;
+			if (block.prevPhysical != prevIndex) return false;
+			if (block.isFree && prevIndex != INVALID_INDEX && blocks[prevIndex].isFree) return false;
+
+			if (block.isFree)
+			{
+				//Must be reachable from the list its size maps to
+				uint32_t fl, sl;
+				mapping(block.size, fl, sl);
+				bool found = false;
+				for (uint32_t j = freeLists[fl * SL_INDEX_COUNT + sl]; j != INVALID_INDEX; j = blocks[j].nextFree)
+				{
+					if (j == i)
+					{
+						found = true;
+						break;
+					}
+				}
+				if (!found) return false;
+				freeCount++;
+			}
+			else
+			{
+				auto it = allocatedBlocks.find(block.offset);
+				if (it == allocatedBlocks.end() || it->second != i) return false;
+				used += block.size;
+				allocatedCount++;
+			}
+
+			expectedOffset += block.size;
+			prevIndex = i;
+		}
+
+		return expectedOffset == size
+			&& used == usedSize
+			&& freeCount == freeBlockCount
+			&& allocatedCount == allocatedBlocks.size();
+	}
+}
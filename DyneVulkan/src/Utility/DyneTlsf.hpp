@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Dyne
+{
+	// Two-level segregated fit allocator over an abstract [0, size) range.
+	// Only does the bookkeeping (offsets & sizes), so it has no dependency on Vulkan
+	// and can be exercised on the CPU. O(1) allocate and free.
+	class DyneTlsf
+	{
+	public:
+		static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+		struct Stats
+		{
+			uint64_t totalSize = 0;
+			uint64_t usedSize = 0;
+			uint64_t freeSize = 0;
+			uint64_t largestFreeRegion = 0;
+			uint32_t allocationCount = 0;
+			uint32_t freeRegionCount = 0;
+
+			// 0 when all free space is one contiguous region, approaching 1 as it splinters
+			float fragmentation() const { return freeSize == 0 ? 0.0f : 1.0f - static_cast<float>(largestFreeRegion) / static_cast<float>(freeSize); }
+		};
+
+		explicit DyneTlsf(uint64_t size);
+
+		DyneTlsf(const DyneTlsf&) = delete;
+		DyneTlsf& operator=(const DyneTlsf&) = delete;
+		DyneTlsf(DyneTlsf&&) = default;
+		DyneTlsf& operator=(DyneTlsf&&) = default;
+
+		// Returns INVALID_OFFSET when no free region fits. alignment must be a power of two
+		uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+		void free(uint64_t offset);
+
+		// Extends the range to newSize, the added space becomes free at the end
+		void grow(uint64_t newSize);
+
+		uint64_t getSize() const { return size; }
+		uint64_t getAllocationSize(uint64_t offset) const;
+		bool isEmpty() const { return allocatedBlocks.empty(); }
+		Stats getStats() const;
+
+		// Walks every block and checks the internal invariants, for debugging & tests
+		bool validate() const;
+
+	private:
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+		static constexpr uint32_t SL_INDEX_COUNT_LOG2 = 5;
+		static constexpr uint32_t SL_INDEX_COUNT = 1u << SL_INDEX_COUNT_LOG2;
+		static constexpr uint32_t SMALL_BLOCK_SIZE_LOG2 = 8;
+		static constexpr uint64_t SMALL_BLOCK_SIZE = 1ull << SMALL_BLOCK_SIZE_LOG2;
+		static constexpr uint32_t FL_INDEX_COUNT = 64 - SMALL_BLOCK_SIZE_LOG2 + 1;
+
+		struct Block
+		{
+			uint64_t offset = 0;
+			uint64_t size = 0;
+			uint32_t prevPhysical = INVALID_INDEX;
+			uint32_t nextPhysical = INVALID_INDEX;
+			uint32_t prevFree = INVALID_INDEX;
+			uint32_t nextFree = INVALID_INDEX;
+			bool isFree = false;
+		};
+
+		static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+		uint32_t findFreeBlock(uint64_t size) const;
+		// Slower search that checks every candidate's real alignment padding, for when the padded size misses
+		uint32_t findAlignedFit(uint64_t size, uint64_t alignment) const;
+		void insertFreeBlock(uint32_t blockIndex);
+		void removeFreeBlock(uint32_t blockIndex);
+		uint32_t splitBlock(uint32_t blockIndex, uint64_t size);
+		void mergeWithNext(uint32_t blockIndex);
+		uint32_t createBlock();
+		void releaseBlock(uint32_t blockIndex);
+
+		uint64_t size;
+		uint64_t usedSize = 0;
+		uint32_t freeBlockCount = 0;
+
+		std::vector<Block> blocks;
+		std::vector<uint32_t> unusedBlocks;
+		std::unordered_map<uint64_t, uint32_t> allocatedBlocks;
+
+		uint64_t flBitmap = 0;
+		std::array<uint32_t, FL_INDEX_COUNT> slBitmap{};
+		std::array<uint32_t, FL_INDEX_COUNT * SL_INDEX_COUNT> freeLists;
+	};
+}
@@ -0,0 +1,364 @@
+#include "DyneAllocator.hpp"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+namespace Dyne
+{
+
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    DyneAllocator::DyneAllocator(VkDevice device, VkPhysicalDevice physicalDevice) : device{device}
+    {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        bufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+        nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+        maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+    }
+
+    DyneAllocator::~DyneAllocator()
+    {
+        for (uint32_t poolIndex = 0; poolIndex < pools.size(); poolIndex++)
+        {
+            for (auto &block : pools[poolIndex].blocks)
+            {
+                if (block.memory == VK_NULL_HANDLE) continue;
+
+                assert(block.tlsf.isEmpty() && "Allocator destroyed while allocations are still alive!");
+                freeMemory(poolIndex / 2, block.memory, block.tlsf.getSize(), block.mapped);
+            }
+        }
+
+        assert(allocationCount == 0 && "Dedicated allocations leaked!");
+    }
+
+    uint32_t DyneAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            if ((typeFilter & (1 << i)) &&
+                (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    bool DyneAllocator::isHostCoherent(uint32_t memoryTypeIndex) const
+    {
+        return (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    }
+
+    VkDeviceSize DyneAllocator::getPreferredBlockSize(uint32_t memoryTypeIndex) const
+    {
+        //Small heaps (integrated GPUs, the 256MB BAR window) get an eighth of the heap per block
+        uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+        return heapSize <= SMALL_HEAP_MAX_SIZE ? alignUp(heapSize / 8, 32) : LARGE_HEAP_BLOCK_SIZE;
+    }
+
+    VkDeviceMemory DyneAllocator::allocateMemory(uint32_t memoryTypeIndex, VkDeviceSize size, void **mapped)
+    {
+        uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        if (allocationCount >= maxAllocationCount ||
+            heapUsage[heapIndex] + size > memoryProperties.memoryHeaps[heapIndex].size)
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        //Host visible memory stays mapped for its whole lifetime, a VkDeviceMemory can only be mapped once
+        *mapped = nullptr;
+        if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+            {
+                vkFreeMemory(device, memory, nullptr);
+                throw std::runtime_error("failed to map device memory block!");
+            }
+        }
+
+        allocationCount++;
+        heapUsage[heapIndex] += size;
+        return memory;
+    }
+
+    void DyneAllocator::freeMemory(uint32_t memoryTypeIndex, VkDeviceMemory memory, VkDeviceSize size, void *mapped)
+    {
+        if (mapped)
+        {
+            vkUnmapMemory(device, memory);
+        }
+        vkFreeMemory(device, memory, nullptr);
+
+        allocationCount--;
+        heapUsage[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] -= size;
+    }
+
+    uint32_t DyneAllocator::createBlock(uint32_t poolIndex, VkDeviceSize minSize)
+    {
+        Pool &pool = pools[poolIndex];
+        uint32_t memoryTypeIndex = poolIndex / 2;
+        VkDeviceSize preferredSize = getPreferredBlockSize(memoryTypeIndex);
+
+        //The first few blocks start smaller so that light scenes don't reserve 256MB per memory type
+        uint32_t liveBlocks = static_cast<uint32_t>(pool.blocks.size() - pool.unusedBlocks.size());
+        VkDeviceSize blockSize = preferredSize >> (3 - std::min<uint32_t>(liveBlocks, 3));
+        while (blockSize < minSize)
+        {
+            blockSize *= 2;
+        }
+
+        //Back off towards the requested size when the heap is close to full
+        void *mapped = nullptr;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        while (memory == VK_NULL_HANDLE)
+        {
+            memory = allocateMemory(memoryTypeIndex, blockSize, &mapped);
+            if (memory != VK_NULL_HANDLE) break;
+
+            if (blockSize == minSize)
+            {
+                throw std::runtime_error("failed to allocate device memory block!");
+            }
+            blockSize = std::max(blockSize / 2, minSize);
+        }
+
+        Block block{memory, mapped, DyneTlsf(blockSize)};
+        if (!pool.unusedBlocks.empty())
+        {
+            uint32_t blockIndex = pool.unusedBlocks.back();
+            pool.unusedBlocks.pop_back();
+            pool.blocks[blockIndex] = std::move(block);
+            return blockIndex;
+        }
+
+        pool.blocks.push_back(std::move(block));
+        return static_cast<uint32_t>(pool.blocks.size() - 1);
+    }
+
+    DyneAllocation DyneAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        DyneAllocation allocation{};
+        allocation.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+
+        VkDeviceSize size = requirements.size;
+        VkDeviceSize alignment = requirements.alignment;
+        if (!isHostCoherent(allocation.memoryTypeIndex) &&
+            (memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+        {
+            //Keeps flush/invalidate ranges from spilling into neighbouring allocations
+            size = alignUp(size, nonCoherentAtomSize);
+            alignment = std::max(alignment, nonCoherentAtomSize);
+        }
+
+        //Linear and optimal resources only need separate blocks when the granularity exceeds their alignment
+        bool separateByTiling = bufferImageGranularity > 1;
+        allocation.poolIndex = allocation.memoryTypeIndex * 2 + (separateByTiling && !linear ? 1 : 0);
+        allocation.size = size;
+
+        if (size > getPreferredBlockSize(allocation.memoryTypeIndex) / 2)
+        {
+            allocation.memory = allocateMemory(allocation.memoryTypeIndex, size, &allocation.mapped);
+            if (allocation.memory == VK_NULL_HANDLE)
+            {
+                throw std::runtime_error("failed to allocate dedicated device memory!");
+            }
+
+            allocation.dedicated = true;
+            dedicatedCounts[allocation.memoryTypeIndex]++;
+            dedicatedBytes[allocation.memoryTypeIndex] += size;
+            return allocation;
+        }
+
+        Pool &pool = pools[allocation.poolIndex];
+        VkDeviceSize offset = DyneTlsf::INVALID_OFFSET;
+        uint32_t blockIndex = 0;
+        for (; blockIndex < pool.blocks.size(); blockIndex++)
+        {
+            if (pool.blocks[blockIndex].memory == VK_NULL_HANDLE) continue;
+
+            offset = pool.blocks[blockIndex].tlsf.allocate(size, alignment);
+            if (offset != DyneTlsf::INVALID_OFFSET) break;
+        }
+
+        if (offset == DyneTlsf::INVALID_OFFSET)
+        {
+            blockIndex = createBlock(allocation.poolIndex, size + alignment - 1);
+            offset = pool.blocks[blockIndex].tlsf.allocate(size, alignment);
+            assert(offset != DyneTlsf::INVALID_OFFSET && "Fresh block could not fit the allocation!");
+        }
+
+        Block &block = pool.blocks[blockIndex];
+        allocation.memory = block.memory;
+        allocation.offset = offset;
+        allocation.blockIndex = blockIndex;
+        allocation.mapped = block.mapped ? static_cast<char *>(block.mapped) + offset : nullptr;
+        return allocation;
+    }
+
+    void DyneAllocator::free(DyneAllocation &allocation)
+    {
+        if (!allocation.isValid()) return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (allocation.dedicated)
+        {
+            freeMemory(allocation.memoryTypeIndex, allocation.memory, allocation.size, allocation.mapped);
+            dedicatedCounts[allocation.memoryTypeIndex]--;
+            dedicatedBytes[allocation.memoryTypeIndex] -= allocation.size;
+            allocation = DyneAllocation{};
+            return;
+        }
+
+        Pool &pool = pools[allocation.poolIndex];
+        Block &block = pool.blocks[allocation.blockIndex];
+        assert(block.memory == allocation.memory && "Allocation does not belong to this block!");
+
+        block.tlsf.free(allocation.offset);
+
+        //Keep a single empty block around per pool so alternating load/unload doesn't thrash vkAllocateMemory
+        if (block.tlsf.isEmpty())
+        {
+            bool hasOtherEmptyBlock = false;
+            for (uint32_t i = 0; i < pool.blocks.size(); i++)
+            {
+                if (i != allocation.blockIndex && pool.blocks[i].memory != VK_NULL_HANDLE && pool.blocks[i].tlsf.isEmpty())
+                {
+                    hasOtherEmptyBlock = true;
+                    break;
+                }
+            }
+
+            if (hasOtherEmptyBlock)
+            {
+                freeMemory(allocation.poolIndex / 2, block.memory, block.tlsf.getSize(), block.mapped);
+                block.memory = VK_NULL_HANDLE;
+                block.mapped = nullptr;
+                pool.unusedBlocks.push_back(allocation.blockIndex);
+            }
+        }
+
+        allocation = DyneAllocation{};
+    }
+
+    VkMappedMemoryRange DyneAllocator::getMappedRange(const DyneAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const
+    {
+        //Allocations in non coherent memory are atom aligned in offset and size, so widening stays inside them
+        VkDeviceSize begin = allocation.offset + offset;
+        VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+        VkMappedMemoryRange mappedRange = {};
+        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        mappedRange.memory = allocation.memory;
+        mappedRange.offset = begin / nonCoherentAtomSize * nonCoherentAtomSize;
+        mappedRange.size = std::min(alignUp(end, nonCoherentAtomSize), allocation.offset + allocation.size) - mappedRange.offset;
+        return mappedRange;
+    }
+
+    VkResult DyneAllocator::flush(const DyneAllocation &allocation, VkDeviceSize size, VkDeviceSize offset)
+    {
+        if (isHostCoherent(allocation.memoryTypeIndex)) return VK_SUCCESS;
+
+        VkMappedMemoryRange mappedRange = getMappedRange(allocation, size, offset);
+        return vkFlushMappedMemoryRanges(device, 1, &mappedRange);
+    }
+
+    VkResult DyneAllocator::invalidate(const DyneAllocation &allocation, VkDeviceSize size, VkDeviceSize offset)
+    {
+        if (isHostCoherent(allocation.memoryTypeIndex)) return VK_SUCCESS;
+
+        VkMappedMemoryRange mappedRange = getMappedRange(allocation, size, offset);
+        return vkInvalidateMappedMemoryRanges(device, 1, &mappedRange);
+    }
+
+    void DyneAllocator::accumulateStats(uint32_t poolIndex, Stats &stats) const
+    {
+        for (const auto &block : pools[poolIndex].blocks)
+        {
+            if (block.memory == VK_NULL_HANDLE) continue;
+
+            DyneTlsf::Stats blockStats = block.tlsf.getStats();
+            stats.blockCount++;
+            stats.blockBytes += blockStats.totalSize;
+            stats.suballocations.totalSize += blockStats.totalSize;
+            stats.suballocations.usedSize += blockStats.usedSize;
+            stats.suballocations.freeSize += blockStats.freeSize;
+            stats.suballocations.allocationCount += blockStats.allocationCount;
+            stats.suballocations.freeRegionCount += blockStats.freeRegionCount;
+            stats.suballocations.largestFreeRegion = std::max(stats.suballocations.largestFreeRegion, blockStats.largestFreeRegion);
+        }
+    }
+
+    DyneAllocator::Stats DyneAllocator::getStats(uint32_t memoryTypeIndex)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        Stats stats{};
+        accumulateStats(memoryTypeIndex * 2, stats);
+        accumulateStats(memoryTypeIndex * 2 + 1, stats);
+        stats.dedicatedAllocationCount = dedicatedCounts[memoryTypeIndex];
+        stats.dedicatedBytes = dedicatedBytes[memoryTypeIndex];
+        return stats;
+    }
+
+    DyneAllocator::Stats DyneAllocator::getStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        Stats stats{};
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            accumulateStats(i * 2, stats);
+            accumulateStats(i * 2 + 1, stats);
+            stats.dedicatedAllocationCount += dedicatedCounts[i];
+            stats.dedicatedBytes += dedicatedBytes[i];
+        }
+        return stats;
+    }
+
+    void DyneAllocator::printStats()
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            Stats stats = getStats(i);
+            if (stats.blockCount == 0 && stats.dedicatedAllocationCount == 0) continue;
+
+            printf("Memory type %u: %u blocks (%.2f MB), %u suballocations (%.2f MB used), %u free regions, fragmentation %.1f%%, %u dedicated (%.2f MB)\n",
+                i,
+                stats.blockCount,
+                stats.blockBytes / (1024.0 * 1024.0),
+                stats.suballocations.allocationCount,
+                stats.suballocations.usedSize / (1024.0 * 1024.0),
+                stats.suballocations.freeRegionCount,
+                stats.suballocations.fragmentation() * 100.0f,
+                stats.dedicatedAllocationCount,
+                stats.dedicatedBytes / (1024.0 * 1024.0));
+        }
+    }
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../Utility/DyneTlsf.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace Dyne
+{
+
+    struct DyneAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void *mapped = nullptr; // points at offset, only set for host visible memory
+        uint32_t memoryTypeIndex = 0;
+
+        // allocator internals
+        uint32_t poolIndex = 0;
+        uint32_t blockIndex = 0;
+        bool dedicated = false;
+
+        bool isValid() const { return memory != VK_NULL_HANDLE; }
+    };
+
+    // Sub-allocates buffers and images out of large VkDeviceMemory blocks, one set of blocks
+    // per memory type. Placement inside a block is handled by DyneTlsf.
+    class DyneAllocator
+    {
+    public:
+        struct Stats
+        {
+            uint32_t blockCount = 0;
+            uint32_t dedicatedAllocationCount = 0;
+            VkDeviceSize blockBytes = 0;
+            VkDeviceSize dedicatedBytes = 0;
+            DyneTlsf::Stats suballocations{};
+        };
+
+        DyneAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+        ~DyneAllocator();
+
+        DyneAllocator(const DyneAllocator &) = delete;
+        DyneAllocator &operator=(const DyneAllocator &) = delete;
+
+        // linear: buffers & linear tiling images, kept apart from optimal images for bufferImageGranularity
+        DyneAllocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear);
+        void free(DyneAllocation &allocation);
+
+        // Offsets are relative to the allocation, the range is widened to nonCoherentAtomSize
+        VkResult flush(const DyneAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        VkResult invalidate(const DyneAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+        Stats getStats();
+        Stats getStats(uint32_t memoryTypeIndex);
+        void printStats();
+
+    private:
+        struct Block
+        {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            void *mapped = nullptr;
+            DyneTlsf tlsf;
+        };
+
+        struct Pool
+        {
+            std::vector<Block> blocks;
+            std::vector<uint32_t> unusedBlocks;
+        };
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        VkDeviceSize getPreferredBlockSize(uint32_t memoryTypeIndex) const;
+        VkDeviceMemory allocateMemory(uint32_t memoryTypeIndex, VkDeviceSize size, void **mapped);
+        void freeMemory(uint32_t memoryTypeIndex, VkDeviceMemory memory, VkDeviceSize size, void *mapped);
+        uint32_t createBlock(uint32_t poolIndex, VkDeviceSize minSize);
+        VkMappedMemoryRange getMappedRange(const DyneAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const;
+        bool isHostCoherent(uint32_t memoryTypeIndex) const;
+        void accumulateStats(uint32_t poolIndex, Stats &stats) const;
+
+        // Sizes and counts above this go straight to vkAllocateMemory
+        static constexpr VkDeviceSize LARGE_HEAP_BLOCK_SIZE = 256ull * 1024 * 1024;
+        static constexpr VkDeviceSize SMALL_HEAP_MAX_SIZE = 1024ull * 1024 * 1024;
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize bufferImageGranularity;
+        VkDeviceSize nonCoherentAtomSize;
+        uint32_t maxAllocationCount;
+
+        uint32_t allocationCount = 0;
+        std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapUsage{};
+        std::array<uint32_t, VK_MAX_MEMORY_TYPES> dedicatedCounts{};
+        std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> dedicatedBytes{};
+
+        // indexed by memoryTypeIndex * 2 + (linear ? 0 : 1)
+        std::array<Pool, VK_MAX_MEMORY_TYPES * 2> pools;
+        std::mutex mutex;
+    };
+
+}
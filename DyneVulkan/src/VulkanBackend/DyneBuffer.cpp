@@ -37,7 +37,8 @@ namespace Dyne
         uint32_t instanceCount,
         VkBufferUsageFlags usageFlags,
         VkMemoryPropertyFlags memoryPropertyFlags,
-        VkDeviceSize minOffsetAlignment)
+        VkDeviceSize minOffsetAlignment,
+        bool shareWithTransferQueue)
         : _deviceRef{ device },
         instanceSize{ instanceSize },
         instanceCount{ instanceCount },
@@ -46,19 +47,21 @@ namespace Dyne
     {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation, shareWithTransferQueue);
     }
 
     DyneBuffer::~DyneBuffer() 
     {
         unmap();
-        vkDestroyBuffer(_deviceRef.device(), buffer, nullptr);
-        vkFreeMemory(_deviceRef.device(), memory, nullptr);
+        _deviceRef.destroyBuffer(buffer, allocation);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
+     * @note Host visible blocks are persistently mapped by the allocator, so this only hands out
+     * a pointer into that mapping
+     *
      * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
      * buffer range.
      * @param offset (Optional) Byte offset from beginning
@@ -67,21 +70,24 @@ namespace Dyne
      */
     VkResult DyneBuffer::map(VkDeviceSize size, VkDeviceSize offset) 
     {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(_deviceRef.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && allocation.isValid() && "Called map on buffer before create");
+        if (!allocation.mapped) 
+        {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+
+        mapped = static_cast<char*>(allocation.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The underlying block stays mapped until the allocator releases it
      */
     void DyneBuffer::unmap() 
     {
-        if (mapped) {
-            vkUnmapMemory(_deviceRef.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     /**
@@ -122,12 +128,7 @@ namespace Dyne
      */
     VkResult DyneBuffer::flush(VkDeviceSize size, VkDeviceSize offset) 
     {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkFlushMappedMemoryRanges(_deviceRef.device(), 1, &mappedRange);
+        return _deviceRef.allocator().flush(allocation, size, offset);
     }
 
     /**
@@ -143,12 +144,7 @@ namespace Dyne
      */
     VkResult DyneBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) 
     {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(_deviceRef.device(), 1, &mappedRange);
+        return _deviceRef.allocator().invalidate(allocation, size, offset);
     }
 
     /**
@@ -14,7 +14,8 @@ namespace Dyne
             uint32_t instanceCount,
             VkBufferUsageFlags usageFlags,
             VkMemoryPropertyFlags memoryPropertyFlags,
-            VkDeviceSize minOffsetAlignment = 1);
+            VkDeviceSize minOffsetAlignment = 1,
+            bool shareWithTransferQueue = false);
         ~DyneBuffer();
 
         DyneBuffer(const DyneBuffer&) = delete;
@@ -48,7 +49,7 @@ namespace Dyne
         DyneDevice& _deviceRef;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        DyneAllocation allocation{};
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
@@ -0,0 +1,228 @@
+#include "DyneCommandRecorder.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace Dyne
+{
+	//Shared with the pool jobs, a job that starts after every chunk was taken only touches this
+	struct DyneCommandRecorder::RecordState
+	{
+		DyneCommandRecorder* recorder = nullptr;
+		const RecordFn* recordFn = nullptr;
+		uint32_t itemCount = 0;
+		uint32_t chunkSize = 0;
+		uint32_t chunkCount = 0;
+
+		std::atomic<uint32_t> nextChunk{ 0 };
+		std::atomic<uint32_t> nextSlot{ 0 };
+		std::vector<VkCommandBuffer> chunkBuffers;
+
+		std::mutex mutex;
+		std::condition_variable chunksFinished;
+		uint32_t finishedChunks = 0;
+		std::exception_ptr error;
+	};
+
+	DyneCommandRecorder::DyneCommandRecorder(DyneDevice& device, DyneThreadPool& threadPool, int framesInFlight) :
+		_deviceRef(device),
+		_threadPoolRef(threadPool)
+	{
+		//The calling thread records alongside the workers
+		uint32_t slotCount = threadPool.getThreadCount() + 1;
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = device.graphicsQueueFamily();
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		frameSlots.resize(framesInFlight);
+		for (auto& slots : frameSlots)
+		{
+			slots.resize(slotCount);
+			for (auto& slot : slots)
+			{
+				if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &slot.commandPool) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create secondary command pool!");
+				}
+			}
+		}
+	}
+
+	DyneCommandRecorder::~DyneCommandRecorder()
+	{
+		//Destroying a pool frees its command buffers
+		for (auto& slots : frameSlots)
+		{
+			for (auto& slot : slots)
+			{
+				vkDestroyCommandPool(_deviceRef.device(), slot.commandPool, nullptr);
+			}
+		}
+	}
+
+	void DyneCommandRecorder::beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent)
+	{
+		assert(frameIndex < frameSlots.size() && "Frame index out of range!");
+
+		currentFrameIndex = frameIndex;
+		this->renderPass = renderPass;
+		this->framebuffer = framebuffer;
+		this->extent = extent;
+
+		for (auto& slot : frameSlots[frameIndex])
+		{
+			if (slot.usedCount == 0) continue;
+
+			vkResetCommandPool(_deviceRef.device(), slot.commandPool, 0);
+			slot.usedCount = 0;
+		}
+	}
+
+	VkCommandBuffer DyneCommandRecorder::beginSecondary(Slot& slot)
+	{
+		if (slot.usedCount == slot.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = slot.commandPool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(_deviceRef.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate secondary command buffer!");
+			}
+			slot.commandBuffers.push_back(commandBuffer);
+		}
+		VkCommandBuffer commandBuffer = slot.commandBuffers[slot.usedCount++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin recording secondary command buffer!");
+		}
+
+		//Dynamic state is not inherited from the primary buffer
+		VkViewport viewport{};
+		viewport.x = 0;
+		viewport.y = 0;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, extent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		return commandBuffer;
+	}
+
+	void DyneCommandRecorder::recordChunks(RecordState& state)
+	{
+		uint32_t chunk = state.nextChunk.fetch_add(1);
+		if (chunk >= state.chunkCount) return;
+
+		//Only threads that got a chunk take a slot, so the slots never run out
+		DyneCommandRecorder& recorder = *state.recorder;
+		uint32_t slotIndex = state.nextSlot.fetch_add(1);
+		assert(slotIndex < recorder.getMaxChunkCount() && "More recording threads than command pools!");
+		Slot& slot = recorder.frameSlots[recorder.currentFrameIndex][slotIndex];
+
+		for (; chunk < state.chunkCount; chunk = state.nextChunk.fetch_add(1))
+		{
+			uint32_t begin = chunk * state.chunkSize;
+			uint32_t end = std::min(begin + state.chunkSize, state.itemCount);
+
+			try
+			{
+				VkCommandBuffer commandBuffer = recorder.beginSecondary(slot);
+				(*state.recordFn)(commandBuffer, begin, end);
+				if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to record secondary command buffer!");
+				}
+				state.chunkBuffers[chunk] = commandBuffer;
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state.mutex);
+				if (!state.error) state.error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(state.mutex);
+				state.finishedChunks++;
+			}
+			state.chunksFinished.notify_one();
+		}
+	}
+
+	void DyneCommandRecorder::record(
+		VkCommandBuffer primaryCommandBuffer,
+		uint32_t itemCount,
+		uint32_t minItemsPerChunk,
+		const RecordFn& recordFn)
+	{
+		assert(renderPass != VK_NULL_HANDLE && "Cannot record before beginFrame!");
+		assert(minItemsPerChunk > 0 && "Chunks must hold at least one item!");
+
+		if (itemCount == 0) return;
+
+		uint32_t chunkCount = std::min((itemCount + minItemsPerChunk - 1) / minItemsPerChunk, getMaxChunkCount());
+		uint32_t chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+
+		auto state = std::make_shared<RecordState>();
+		state->recorder = this;
+		state->recordFn = &recordFn;
+		state->itemCount = itemCount;
+		state->chunkSize = chunkSize;
+		state->chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+		state->chunkBuffers.resize(state->chunkCount, VK_NULL_HANDLE);
+
+		//The calling thread takes chunks too, so a pool busy with other work only slows recording down
+		for (uint32_t i = 1; i < state->chunkCount; i++)
+		{
+			_threadPoolRef.submit([state]() { recordChunks(*state); });
+		}
+		recordChunks(*state);
+
+		{
+			std::unique_lock<std::mutex> lock(state->mutex);
+			state->chunksFinished.wait(lock, [&state]() { return state->finishedChunks == state->chunkCount; });
+		}
+
+		if (state->error)
+		{
+			std::rethrow_exception(state->error);
+		}
+
+		vkCmdExecuteCommands(primaryCommandBuffer, state->chunkCount, state->chunkBuffers.data());
+	}
+
+	void DyneCommandRecorder::recordSingle(VkCommandBuffer primaryCommandBuffer, const std::function<void(VkCommandBuffer commandBuffer)>& recordFn)
+	{
+		record(primaryCommandBuffer, 1, 1, [&recordFn](VkCommandBuffer commandBuffer, uint32_t, uint32_t)
+		{
+			recordFn(commandBuffer);
+		});
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "DyneDevice.hpp"
+#include "../Utility/DyneThreadPool.hpp"
+
+// std lib headers
+#include <functional>
+#include <vector>
+
+namespace Dyne
+{
+    // Records the swap chain render pass on several threads at once. Work is split into chunks,
+    // each recorded into its own secondary command buffer, and the buffers are executed into the
+    // frame's primary buffer in chunk order. Every participating thread (the pool's workers and the
+    // calling thread) records from its own command pool, one set of pools per frame in flight.
+    class DyneCommandRecorder
+    {
+    public:
+        // Records items [begin, end) into a secondary buffer that already continues the render pass
+        // with viewport & scissor set, pipeline & descriptor state must be bound again
+        using RecordFn = std::function<void(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end)>;
+
+        DyneCommandRecorder(DyneDevice& device, DyneThreadPool& threadPool, int framesInFlight);
+        ~DyneCommandRecorder();
+
+        DyneCommandRecorder(const DyneCommandRecorder&) = delete;
+        DyneCommandRecorder& operator=(const DyneCommandRecorder&) = delete;
+
+        // Resets the frame's pools, the frame's previous submission must have completed
+        void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+        // Blocks until every chunk is recorded, then executes them into primaryCommandBuffer. The
+        // render pass must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+        void record(VkCommandBuffer primaryCommandBuffer, uint32_t itemCount, uint32_t minItemsPerChunk, const RecordFn& recordFn);
+        // Single secondary buffer recorded on the calling thread, for passes too small to split
+        void recordSingle(VkCommandBuffer primaryCommandBuffer, const std::function<void(VkCommandBuffer commandBuffer)>& recordFn);
+
+        uint32_t getMaxChunkCount() const { return static_cast<uint32_t>(frameSlots[0].size()); }
+
+    private:
+        struct Slot
+        {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> commandBuffers;
+            uint32_t usedCount = 0;
+        };
+
+        struct RecordState;
+
+        VkCommandBuffer beginSecondary(Slot& slot);
+        // Run by every participating thread until no chunks are left
+        static void recordChunks(RecordState& state);
+
+        DyneDevice& _deviceRef;
+        DyneThreadPool& _threadPoolRef;
+
+        // [frame][slot], one slot per thread that may take part in recording
+        std::vector<std::vector<Slot>> frameSlots;
+
+        int currentFrameIndex = 0;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+    };
+}
@@ -11,7 +11,8 @@ namespace Dyne {
         uint32_t binding,
         VkDescriptorType descriptorType,
         VkShaderStageFlags stageFlags,
-        uint32_t count) 
+        uint32_t count,
+        VkDescriptorBindingFlagsEXT flags) 
     {
         assert(bindings.count(binding) == 0 && "Binding already in use");
         VkDescriptorSetLayoutBinding layoutBinding{};
@@ -20,30 +21,59 @@ namespace Dyne {
         layoutBinding.descriptorCount = count;
         layoutBinding.stageFlags = stageFlags;
         bindings[binding] = layoutBinding;
+        if (flags != 0)
+        {
+            bindingFlags[binding] = flags;
+        }
+        return *this;
+    }
+
+    DyneDescriptorSetLayout::Builder& DyneDescriptorSetLayout::Builder::setLayoutFlags(
+        VkDescriptorSetLayoutCreateFlags flags) 
+    {
+        layoutFlags = flags;
         return *this;
     }
 
     std::unique_ptr<DyneDescriptorSetLayout> DyneDescriptorSetLayout::Builder::build() const 
     {
-        return std::make_unique<DyneDescriptorSetLayout>(_deviceRef, bindings);
+        return std::make_unique<DyneDescriptorSetLayout>(_deviceRef, bindings, bindingFlags, layoutFlags);
     }
 
     // *************** Descriptor Set Layout *********************
 
-    DyneDescriptorSetLayout::DyneDescriptorSetLayout(DyneDevice& device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+    DyneDescriptorSetLayout::DyneDescriptorSetLayout(
+        DyneDevice& device,
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        const std::unordered_map<uint32_t, VkDescriptorBindingFlagsEXT>& bindingFlags,
+        VkDescriptorSetLayoutCreateFlags layoutFlags)
         : _deviceRef{ device }, bindings{ bindings }
     {
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+        // Parallel to setLayoutBindings, only chained when any binding has flags
+        std::vector<VkDescriptorBindingFlagsEXT> setLayoutBindingFlags{};
         for (auto kv : bindings)
         {
             setLayoutBindings.push_back(kv.second);
+            auto flags = bindingFlags.find(kv.first);
+            setLayoutBindingFlags.push_back(flags != bindingFlags.end() ? flags->second : 0);
         }
 
         VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
         descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutInfo.flags = layoutFlags;
         descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
         descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
 
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+        if (!bindingFlags.empty())
+        {
+            bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+            bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+            bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+            descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+        }
+
         if (vkCreateDescriptorSetLayout(
             _deviceRef.device(),
             &descriptorSetLayoutInfo,
@@ -193,6 +223,27 @@ namespace Dyne {
         return *this;
     }
 
+    DyneDescriptorWriter& DyneDescriptorWriter::writeImage(
+        uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* imageInfo) 
+    {
+        assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
+
+        auto& bindingDescription = setLayout.bindings[binding];
+
+        assert(arrayElement < bindingDescription.descriptorCount && "Array element out of the binding's range");
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.descriptorType = bindingDescription.descriptorType;
+        write.dstBinding = binding;
+        write.dstArrayElement = arrayElement;
+        write.pImageInfo = imageInfo;
+        write.descriptorCount = 1;
+
+        writes.push_back(write);
+        return *this;
+    }
+
     bool DyneDescriptorWriter::build(VkDescriptorSet& set) 
     {
         bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
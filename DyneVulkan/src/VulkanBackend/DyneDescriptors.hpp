@@ -15,20 +15,29 @@ namespace Dyne {
         public:
             Builder(DyneDevice& device) : _deviceRef{ device } {}
 
+            // bindingFlags other than 0 require VK_EXT_descriptor_indexing
             Builder& addBinding(
                 uint32_t binding,
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
-                uint32_t count = 1);
+                uint32_t count = 1,
+                VkDescriptorBindingFlagsEXT bindingFlags = 0);
+            // Layouts with update after bind bindings must be created with VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT
+            Builder& setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags);
             std::unique_ptr<DyneDescriptorSetLayout> build() const;
 
         private:
             DyneDevice& _deviceRef;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlagsEXT> bindingFlags{};
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
         };
 
         DyneDescriptorSetLayout(
-            DyneDevice& device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+            DyneDevice& device,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlagsEXT>& bindingFlags = {},
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0);
         ~DyneDescriptorSetLayout();
         DyneDescriptorSetLayout(const DyneDescriptorSetLayout&) = delete;
         DyneDescriptorSetLayout& operator=(const DyneDescriptorSetLayout&) = delete;
@@ -90,6 +99,8 @@ namespace Dyne {
 
         DyneDescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
         DyneDescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo);
+        // Writes a single element of an array binding
+        DyneDescriptorWriter& writeImage(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* imageInfo);
 
         bool build(VkDescriptorSet& set);
         void overwrite(VkDescriptorSet& set);
@@ -1,7 +1,12 @@
 #include "DyneDevice.hpp"
+#include "DyneUploadContext.hpp"
 
 // std headers
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -65,10 +70,17 @@ namespace Dyne
         sayLimits();
         createLogicalDevice();
         createCommandPool();
+        createPipelineCache();
+        allocator_ = std::make_unique<DyneAllocator>(device_, physicalDevice);
+        uploadContext_ = std::make_unique<DyneUploadContext>(*this, graphicsQueue_, graphicsQueueFamily_);
     }
 
     DyneDevice::~DyneDevice() 
     {
+        uploadContext_.reset();
+        allocator_.reset();
+        savePipelineCache();
+        vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -123,6 +135,7 @@ namespace Dyne
             throw std::runtime_error("failed to create instance!");
         }
 
+        physicalDeviceProperties2Enabled = checkInstanceExtensionSupport(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
         hasGflwRequiredInstanceExtensions();
     }
 
@@ -162,6 +175,10 @@ namespace Dyne
     
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        if (indices.transferFamilyHasValue) 
+        {
+            uniqueQueueFamilies.insert(indices.transferFamily);
+        }
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) 
@@ -174,18 +191,46 @@ namespace Dyne
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+        // indirect draw & BC texture features are optional, GPU driven rendering and cooked textures are only used when present
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        multiDrawIndirectEnabled = supportedFeatures.multiDrawIndirect == VK_TRUE;
+        drawIndirectFirstInstanceEnabled = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+        textureCompressionBCEnabled = supportedFeatures.textureCompressionBC == VK_TRUE;
+
+        std::vector<const char *> enabledExtensions(deviceExtensions.begin(), deviceExtensions.end());
+        drawIndirectCountEnabled = checkOptionalExtensionSupport(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        if (drawIndirectCountEnabled) 
+        {
+            enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
+
+        // bindless textures are optional too, the texture registry falls back to a small fixed table without them
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        descriptorIndexingEnabled = queryDescriptorIndexingSupport(indexingFeatures);
+        if (descriptorIndexingEnabled) 
+        {
+            enabledExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        }
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = descriptorIndexingEnabled ? &indexingFeatures : nullptr;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -205,6 +250,75 @@ namespace Dyne
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        graphicsQueueFamily_ = indices.graphicsFamily;
+        transferQueueFamily_ = indices.transferFamilyHasValue ? indices.transferFamily : indices.graphicsFamily;
+        vkGetDeviceQueue(device_, transferQueueFamily_, 0, &transferQueue_);
+        #ifdef _DEBUG
+        std::cout << "transfer queue family: " << transferQueueFamily_ 
+            << (indices.transferFamilyHasValue ? " (dedicated)" : " (shared with graphics)") << std::endl;
+        #endif
+
+        if (drawIndirectCountEnabled) 
+        {
+            vkCmdDrawIndexedIndirectCountKHR_ = 
+                (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR");
+            drawIndirectCountEnabled = vkCmdDrawIndexedIndirectCountKHR_ != nullptr;
+        }
+    }
+
+    bool DyneDevice::queryDescriptorIndexingSupport(VkPhysicalDeviceDescriptorIndexingFeaturesEXT &enabledFeatures) 
+    {
+        // the extension depends on maintenance3, and the 1.0 instance needs properties2 to query its features
+        if (!physicalDeviceProperties2Enabled ||
+            !checkOptionalExtensionSupport(physicalDevice, VK_KHR_MAINTENANCE3_EXTENSION_NAME) ||
+            !checkOptionalExtensionSupport(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) 
+        {
+            return false;
+        }
+
+        auto getFeatures2 = 
+            (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
+        auto getProperties2 = 
+            (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR");
+        if (getFeatures2 == nullptr || getProperties2 == nullptr) return false;
+
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT supportedFeatures = {};
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2KHR features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+        features2.pNext = &supportedFeatures;
+        getFeatures2(physicalDevice, &features2);
+
+        // a runtime sized array, sparsely filled, rewritten while bound and indexed per instance
+        if (!supportedFeatures.runtimeDescriptorArray ||
+            !supportedFeatures.descriptorBindingPartiallyBound ||
+            !supportedFeatures.descriptorBindingSampledImageUpdateAfterBind ||
+            !supportedFeatures.shaderSampledImageArrayNonUniformIndexing) 
+        {
+            return false;
+        }
+
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+        indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2KHR properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+        properties2.pNext = &indexingProperties;
+        getProperties2(physicalDevice, &properties2);
+
+        // combined image samplers count against the sampler and the sampled image limits alike
+        maxBindlessTextures_ = std::min({
+            indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+            indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+            indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+            indexingProperties.maxPerStageUpdateAfterBindResources});
+
+        enabledFeatures.runtimeDescriptorArray = VK_TRUE;
+        enabledFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+        enabledFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabledFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        return true;
     }
 
     void DyneDevice::createCommandPool() 
@@ -223,6 +337,83 @@ namespace Dyne
         }
     }
 
+    void DyneDevice::createPipelineCache() 
+    {
+        std::vector<char> cacheData;
+        std::ifstream file(PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary);
+        if (file.is_open()) 
+        {
+            cacheData.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(cacheData.data(), cacheData.size());
+            if (!file || !isPipelineCacheCompatible(cacheData)) 
+            {
+                std::cout << "discarding stale pipeline cache " << PIPELINE_CACHE_PATH << std::endl;
+                cacheData.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo = {};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = cacheData.size();
+        cacheInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) 
+        {
+            // the driver may still reject data that passed the header check, start empty then
+            cacheInfo.initialDataSize = 0;
+            cacheInfo.pInitialData = nullptr;
+            if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) 
+            {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+        }
+    }
+
+    bool DyneDevice::isPipelineCacheCompatible(const std::vector<char> &cacheData) 
+    {
+        // VkPipelineCacheHeaderVersionOne: header size, version, vendor ID, device ID, cache UUID
+        constexpr size_t HEADER_SIZE = 16 + VK_UUID_SIZE;
+        if (cacheData.size() < HEADER_SIZE) return false;
+
+        uint32_t headerSize, headerVersion, vendorID, deviceID;
+        std::memcpy(&headerSize, cacheData.data() + 0, sizeof(uint32_t));
+        std::memcpy(&headerVersion, cacheData.data() + 4, sizeof(uint32_t));
+        std::memcpy(&vendorID, cacheData.data() + 8, sizeof(uint32_t));
+        std::memcpy(&deviceID, cacheData.data() + 12, sizeof(uint32_t));
+
+        return headerSize >= HEADER_SIZE && headerSize <= cacheData.size() &&
+            headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            vendorID == properties.vendorID &&
+            deviceID == properties.deviceID &&
+            std::memcmp(cacheData.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void DyneDevice::savePipelineCache() 
+    {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) return;
+
+        std::vector<char> cacheData(dataSize);
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, cacheData.data()) != VK_SUCCESS) return;
+
+        // written to a temporary first so a crash mid-write can't leave a truncated cache behind
+        std::string tempPath = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) 
+            {
+                std::cerr << "failed to write pipeline cache " << tempPath << std::endl;
+                return;
+            }
+            file.write(cacheData.data(), dataSize);
+            if (!file) return;
+        }
+
+        std::remove(PIPELINE_CACHE_PATH);
+        std::rename(tempPath.c_str(), PIPELINE_CACHE_PATH);
+    }
+
     void DyneDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
 
     bool DyneDevice::isDeviceSuitable(VkPhysicalDevice device) 
@@ -318,6 +509,12 @@ namespace Dyne
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         }
 
+        // optional, only needed to negotiate descriptor indexing on a 1.0 instance
+        if (checkInstanceExtensionSupport(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) 
+        {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        }
+
         return extensions;
     }
 
@@ -375,6 +572,59 @@ namespace Dyne
         return requiredExtensions.empty();
     }
 
+    bool DyneDevice::checkInstanceExtensionSupport(const char *extensionName) 
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto &extension : availableExtensions) 
+        {
+            if (strcmp(extensionName, extension.extensionName) == 0) 
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool DyneDevice::checkOptionalExtensionSupport(VkPhysicalDevice device, const char *extensionName) 
+    {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(
+            device,
+            nullptr,
+            &extensionCount,
+            availableExtensions.data());
+
+        for (const auto &extension : availableExtensions) 
+        {
+            if (strcmp(extensionName, extension.extensionName) == 0) 
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    VkQueueFlags DyneDevice::getQueueFamilyFlags(uint32_t queueFamilyIndex) 
+    {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        return queueFamilyIndex < queueFamilyCount ? queueFamilies[queueFamilyIndex].queueFlags : 0;
+    }
+
     QueueFamilyIndices DyneDevice::findQueueFamilies(VkPhysicalDevice device) 
     {
         QueueFamilyIndices indices;
@@ -385,22 +635,44 @@ namespace Dyne
         std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
         vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+        // a transfer only family (DMA engine) beats one that can also run compute
+        bool transferIsDedicated = false;
+
         int i = 0;
         for (const auto &queueFamily : queueFamilies) 
         {
-            if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) 
+            if (!indices.isComplete()) 
             {
-                indices.graphicsFamily = i;
-                indices.graphicsFamilyHasValue = true;
+                // compute passes are recorded into the frame command buffer, so the graphics queue must support them
+                if (queueFamily.queueCount > 0 && 
+                    (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && 
+                    (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) 
+                {
+                    indices.graphicsFamily = i;
+                    indices.graphicsFamilyHasValue = true;
+                }
+                VkBool32 presentSupport = false;
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+                if (queueFamily.queueCount > 0 && presentSupport) 
+                {
+                    indices.presentFamily = i;
+                    indices.presentFamilyHasValue = true;
+                }
             }
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-            if (queueFamily.queueCount > 0 && presentSupport) 
+
+            // compute capable families implicitly support transfers too
+            bool canTransfer = (queueFamily.queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) != 0;
+            bool dedicated = (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) == 0;
+            if (queueFamily.queueCount > 0 && canTransfer && 
+                (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0 &&
+                (!indices.transferFamilyHasValue || (dedicated && !transferIsDedicated))) 
             {
-                indices.presentFamily = i;
-                indices.presentFamilyHasValue = true;
+                indices.transferFamily = i;
+                indices.transferFamilyHasValue = true;
+                transferIsDedicated = dedicated;
             }
-            if (indices.isComplete()) 
+
+            if (indices.isComplete() && transferIsDedicated) 
             {
                 break;
             }
@@ -459,6 +731,13 @@ namespace Dyne
         throw std::runtime_error("failed to find supported format!");
     }
 
+    VkFormatProperties DyneDevice::getFormatProperties(VkFormat format)
+    {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+        return props;
+    }
+
     uint32_t DyneDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) 
     {
         VkPhysicalDeviceMemoryProperties memProperties;
@@ -475,12 +754,26 @@ namespace Dyne
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
-    void DyneDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer,VkDeviceMemory &bufferMemory) {
+    void DyneDevice::createBuffer(
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        VkBuffer &buffer,
+        DyneAllocation &bufferAllocation,
+        bool shareWithTransferQueue) {
+        uint32_t sharedFamilies[] = {graphicsQueueFamily_, transferQueueFamily_};
+
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (shareWithTransferQueue && hasDedicatedTransferQueue()) 
+        {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = 2;
+            bufferInfo.pQueueFamilyIndices = sharedFamilies;
+        }
 
         if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) 
         {
@@ -490,16 +783,31 @@ namespace Dyne
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        bufferAllocation = allocator_->allocate(memRequirements, properties, true);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+        if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS) {
+            throw std::runtime_error("failed to bind buffer memory!");
         }
+    }
+
+    void DyneDevice::destroyBuffer(VkBuffer buffer, DyneAllocation &bufferAllocation) 
+    {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        allocator_->free(bufferAllocation);
+    }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    void DyneDevice::cmdDrawIndexedIndirectCount(
+        VkCommandBuffer commandBuffer,
+        VkBuffer buffer,
+        VkDeviceSize offset,
+        VkBuffer countBuffer,
+        VkDeviceSize countBufferOffset,
+        uint32_t maxDrawCount,
+        uint32_t stride) 
+    {
+        assert(drawIndirectCountEnabled && "VK_KHR_draw_indirect_count is not enabled on this device");
+        vkCmdDrawIndexedIndirectCountKHR_(
+            commandBuffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
     }
 
     VkCommandBuffer DyneDevice::beginSingleTimeCommands() 
@@ -530,53 +838,36 @@ namespace Dyne
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // wait on a fence rather than the whole queue, frames in flight keep running
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VkFence fence;
+        if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS) 
+        {
+            throw std::runtime_error("failed to create fence!");
+        }
+
+        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+        vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+        vkDestroyFence(device_, fence, nullptr);
 
         vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
 
     void DyneDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) 
     {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkBufferCopy copyRegion{};
-        copyRegion.srcOffset = 0;  // Optional
-        copyRegion.dstOffset = 0;  // Optional
-        copyRegion.size = size;
-        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-        endSingleTimeCommands(commandBuffer);
+        uploadContext_->copyBuffer(srcBuffer, dstBuffer, size);
+        uploadContext_->submitAndWait();
     }
 
     void DyneDevice::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) 
     {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = layerCount;
-
-        region.imageOffset = {0, 0, 0};
-        region.imageExtent = {width, height, 1};
-
-        vkCmdCopyBufferToImage(
-            commandBuffer,
-            buffer,
-            image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            1,
-            &region);
-        endSingleTimeCommands(commandBuffer);
+        uploadContext_->copyBufferToImage(buffer, 0, image, {width, height, 1}, 0, 0, layerCount);
+        uploadContext_->submitAndWait();
     }
 
-    void DyneDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory) 
+    void DyneDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, DyneAllocation &imageAllocation) 
     {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) 
         {
@@ -586,19 +877,17 @@ namespace Dyne
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) 
-        {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
+        imageAllocation = allocator_->allocate(memRequirements, properties, imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
 
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) 
+        if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS) 
         {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
+
+    void DyneDevice::destroyImage(VkImage image, DyneAllocation &imageAllocation) 
+    {
+        vkDestroyImage(device_, image, nullptr);
+        allocator_->free(imageAllocation);
+    }
 }
\ No newline at end of file
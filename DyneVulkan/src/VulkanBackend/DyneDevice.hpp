@@ -1,14 +1,18 @@
 #pragma once
 
 #include "../Window/WindowHandler.hpp"
+#include "DyneAllocator.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace Dyne 
 {
 
+    class DyneUploadContext;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -18,8 +22,11 @@ namespace Dyne
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        // optional, only set for a family without graphics support (a dedicated DMA engine)
+        bool transferFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
@@ -31,6 +38,9 @@ namespace Dyne
         const bool enableValidationLayers = true;
         #endif
 
+        // Loaded at startup and written back at shutdown, next to the executable's working directory
+        static constexpr const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
         DyneDevice(WindowHandler &window);
         ~DyneDevice();
 
@@ -45,20 +55,54 @@ namespace Dyne
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // Falls back to the graphics queue when the device has no dedicated transfer family
+        VkQueue transferQueue() { return transferQueue_; }
+        uint32_t graphicsQueueFamily() const { return graphicsQueueFamily_; }
+        uint32_t transferQueueFamily() const { return transferQueueFamily_; }
+        bool hasDedicatedTransferQueue() const { return graphicsQueueFamily_ != transferQueueFamily_; }
+        DyneAllocator &allocator() { return *allocator_; }
+        DyneUploadContext &uploadContext() { return *uploadContext_; }
+        // Shared by every pipeline, so variants compiled by one render system are reused by all
+        VkPipelineCache pipelineCache() { return pipelineCache_; }
+        void savePipelineCache();
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+        VkQueueFlags getQueueFamilyFlags(uint32_t queueFamilyIndex);
         VkFormat findSupportedFormat(
             const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+        VkFormatProperties getFormatProperties(VkFormat format);
+
+        // Indirect drawing support
+        bool supportsGpuDrivenRendering() const { return multiDrawIndirectEnabled && drawIndirectFirstInstanceEnabled; }
+        bool supportsDrawIndirectCount() const { return drawIndirectCountEnabled; }
+        // BC1-BC7 images may only be created when the feature was enabled
+        bool supportsBcTextures() const { return textureCompressionBCEnabled; }
+        // Partially bound, update after bind sampler arrays indexed non-uniformly (VK_EXT_descriptor_indexing)
+        bool supportsBindlessTextures() const { return descriptorIndexingEnabled; }
+        // Largest such array a stage may use, 0 without support
+        uint32_t maxBindlessTextures() const { return maxBindlessTextures_; }
+        void cmdDrawIndexedIndirectCount(
+            VkCommandBuffer commandBuffer,
+            VkBuffer buffer,
+            VkDeviceSize offset,
+            VkBuffer countBuffer,
+            VkDeviceSize countBufferOffset,
+            uint32_t maxDrawCount,
+            uint32_t stride);
 
         // Buffer Helper Functions
+        // The one-shot helpers below block until the GPU is done, batch through uploadContext() instead
+        // shareWithTransferQueue creates the buffer concurrent between the graphics and transfer families
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &bufferMemory);
+            DyneAllocation &bufferAllocation,
+            bool shareWithTransferQueue = false);
+        void destroyBuffer(VkBuffer buffer, DyneAllocation &bufferAllocation);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -69,7 +113,8 @@ namespace Dyne
             const VkImageCreateInfo &imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage &image,
-            VkDeviceMemory &imageMemory);
+            DyneAllocation &imageAllocation);
+        void destroyImage(VkImage image, DyneAllocation &imageAllocation);
 
         VkPhysicalDeviceProperties properties;
 
@@ -81,6 +126,7 @@ namespace Dyne
         void pickPhysicalDevice();
         void createLogicalDevice();
         void createCommandPool();
+        void createPipelineCache();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -90,6 +136,11 @@ namespace Dyne
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool checkOptionalExtensionSupport(VkPhysicalDevice device, const char *extensionName);
+        bool checkInstanceExtensionSupport(const char *extensionName);
+        // Fills enabledFeatures with the features bindless textures need, false when any of them is missing
+        bool queryDescriptorIndexingSupport(VkPhysicalDeviceDescriptorIndexingFeaturesEXT &enabledFeatures);
+        bool isPipelineCacheCompatible(const std::vector<char> &cacheData);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
@@ -102,6 +153,21 @@ namespace Dyne
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        uint32_t graphicsQueueFamily_ = 0;
+        uint32_t transferQueueFamily_ = 0;
+        std::unique_ptr<DyneAllocator> allocator_;
+        std::unique_ptr<DyneUploadContext> uploadContext_;
+        VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+
+        bool multiDrawIndirectEnabled = false;
+        bool drawIndirectFirstInstanceEnabled = false;
+        bool drawIndirectCountEnabled = false;
+        bool textureCompressionBCEnabled = false;
+        bool physicalDeviceProperties2Enabled = false;
+        bool descriptorIndexingEnabled = false;
+        uint32_t maxBindlessTextures_ = 0;
+        PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCountKHR_ = nullptr;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -1,18 +1,23 @@
 #pragma once
 
 #include "..//Engine/Camera.hpp"
-#include "..//Engine/GameObject.hpp"
+#include "..//Engine/Components.hpp"
+#include "..//Engine/EntityRegistry.hpp"
+#include "DyneGeometryPool.hpp"
+#include "DyneCommandRecorder.hpp"
 
 #include <vulkan/vulkan.h>
 
 namespace Dyne
 {
-#define MAX_LIGHTS 10
+//Capacity of the light storage buffer, shading cost is bounded per cluster instead
+#define MAX_LIGHTS 16384
 
+	//Matches PointLight in the shaders (std430)
 	struct PointLight
 	{
-		glm::vec4 position{};
-		glm::vec4 color{};
+		glm::vec4 position{}; //w = range
+		glm::vec4 color{}; //rgb premultiplied by intensity, w = billboard radius
 	};
 
 	struct GlobalUbo
@@ -21,8 +26,16 @@ namespace Dyne
 		glm::mat4 projection{ 1.0f };
 		glm::mat4 view{ 1.0f };
 		glm::vec4 ambientLightColor{ 1.0f, 1.0f, 1.0f, 0.002f };
-		PointLight pointLights[MAX_LIGHTS];
-		int numLights;
+		glm::vec4 clusterParams{ 0.0f }; //xy = tile size in pixels, z = depth slice scale, w = depth slice bias
+		glm::uvec4 clusterGrid{ 0u }; //xyz = cluster counts, w = light count
+	};
+
+	//Matches InstanceData in shader.vert, shader_packed.vert and the cull shaders (std430)
+	struct InstanceData
+	{
+		glm::mat4 modelMatrix{ 1.0f };
+		glm::mat4 normalMatrix{ 1.0f };
+		glm::uvec4 material{ 0u }; //x = texture registry slot
 	};
 
 	struct FrameInfo
@@ -32,6 +45,10 @@ namespace Dyne
 		VkCommandBuffer commandBuffer;
 		Camera& camera;
 		VkDescriptorSet globalDescriptorSet;
-		GameObject::Map& gameObjects;
+		//The texture registry's table, set 2 of the lit pipelines
+		VkDescriptorSet textureDescriptorSet;
+		EntityRegistry& registry;
+		DyneGeometryPool& geometryPool;
+		DyneCommandRecorder& commandRecorder;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "DyneGeometryPool.hpp"
+#include "DyneUploadContext.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Dyne
+{
+	static constexpr VkBufferUsageFlags VERTEX_POOL_USAGE =
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	static constexpr VkBufferUsageFlags INDEX_POOL_USAGE =
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	DyneGeometryPool::DyneGeometryPool(
+		DyneDevice& device,
+		VertexFormat vertexFormat,
+		uint32_t vertexCapacity,
+		uint32_t indexCapacity) :
+		_deviceRef(device),
+		vertexFormat(vertexFormat),
+		vertexStride(getVertexFormatInfo(vertexFormat).binding.stride),
+		vertexRanges(vertexCapacity),
+		indices16{ nullptr, DyneTlsf(indexCapacity), sizeof(uint16_t) },
+		indices32{ nullptr, DyneTlsf(indexCapacity), sizeof(uint32_t) }
+	{
+		vertexBuffer = createBuffer(device, vertexStride, vertexCapacity, VERTEX_POOL_USAGE);
+		indices16.buffer = createBuffer(device, indices16.indexSize, indexCapacity, INDEX_POOL_USAGE);
+		indices32.buffer = createBuffer(device, indices32.indexSize, indexCapacity, INDEX_POOL_USAGE);
+	}
+
+	DyneGeometryPool::~DyneGeometryPool()
+	{
+		assert(vertexRanges.isEmpty() && indices16.ranges.isEmpty() && indices32.ranges.isEmpty() && "Geometry pool destroyed while models still use it!");
+	}
+
+	std::unique_ptr<DyneBuffer> DyneGeometryPool::createBuffer(DyneDevice& device, VkDeviceSize elementSize, uint32_t capacity, VkBufferUsageFlags usage)
+	{
+		return std::make_unique<DyneBuffer>
+		(
+			device,
+			elementSize,
+			capacity,
+			usage,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			true
+		);
+	}
+
+	void DyneGeometryPool::growVertices(uint32_t minCapacity, DyneUploadContext& pendingContext)
+	{
+		uint32_t oldCapacity = static_cast<uint32_t>(vertexRanges.getSize());
+		uint32_t newCapacity = std::max(oldCapacity * 2, minCapacity);
+
+		//Copies still recording in either context target the old buffer and must land before it is copied,
+		//draws recorded for frames in flight still reference it
+		pendingContext.submit();
+		_deviceRef.uploadContext().submit();
+		vkDeviceWaitIdle(_deviceRef.device());
+
+		auto newBuffer = createBuffer(_deviceRef, vertexStride, newCapacity, VERTEX_POOL_USAGE);
+		_deviceRef.uploadContext().copyBuffer(vertexBuffer->getBuffer(), newBuffer->getBuffer(), vertexStride * oldCapacity);
+		_deviceRef.uploadContext().submitAndWait();
+		vertexBuffer = std::move(newBuffer);
+		vertexRanges.grow(newCapacity);
+	}
+
+	void DyneGeometryPool::growIndices(IndexStorage& storage, uint32_t minCapacity, DyneUploadContext& pendingContext)
+	{
+		uint32_t oldCapacity = static_cast<uint32_t>(storage.ranges.getSize());
+		uint32_t newCapacity = std::max(oldCapacity * 2, minCapacity);
+
+		pendingContext.submit();
+		_deviceRef.uploadContext().submit();
+		vkDeviceWaitIdle(_deviceRef.device());
+
+		auto newBuffer = createBuffer(_deviceRef, storage.indexSize, newCapacity, INDEX_POOL_USAGE);
+		_deviceRef.uploadContext().copyBuffer(storage.buffer->getBuffer(), newBuffer->getBuffer(), storage.indexSize * oldCapacity);
+		_deviceRef.uploadContext().submitAndWait();
+		storage.buffer = std::move(newBuffer);
+		storage.ranges.grow(newCapacity);
+	}
+
+	DyneMeshRange DyneGeometryPool::upload(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount, VkIndexType indexType)
+	{
+		return upload(_deviceRef.uploadContext(), vertexData, vertexCount, indexData, indexCount, indexType);
+	}
+
+	DyneMeshRange DyneGeometryPool::upload(
+		DyneUploadContext& uploadContext,
+		const void* vertexData,
+		uint32_t vertexCount,
+		const void* indexData,
+		uint32_t indexCount,
+		VkIndexType indexType)
+	{
+		assert(vertexCount > 0 && "Cannot upload a mesh without vertices!");
+		assert((indexType == VK_INDEX_TYPE_UINT16 || indexType == VK_INDEX_TYPE_UINT32) && "Unsupported index type!");
+
+		DyneMeshRange range{};
+		range.vertexCount = vertexCount;
+		range.indexCount = indexCount;
+		range.indexType = indexType;
+		IndexStorage& storage = indexStorage(indexType);
+
+		uint64_t vertexOffset = vertexRanges.allocate(vertexCount);
+		while (vertexOffset == DyneTlsf::INVALID_OFFSET)
+		{
+			growVertices(static_cast<uint32_t>(vertexRanges.getSize()) + vertexCount, uploadContext);
+			vertexOffset = vertexRanges.allocate(vertexCount);
+		}
+		if (vertexOffset > static_cast<uint64_t>(INT32_MAX))
+		{
+			throw std::runtime_error("geometry pool vertex offset out of range!");
+		}
+		range.vertexOffset = static_cast<int32_t>(vertexOffset);
+
+		if (indexCount > 0)
+		{
+			uint64_t firstIndex = storage.ranges.allocate(indexCount);
+			while (firstIndex == DyneTlsf::INVALID_OFFSET)
+			{
+				growIndices(storage, static_cast<uint32_t>(storage.ranges.getSize()) + indexCount, uploadContext);
+				firstIndex = storage.ranges.allocate(indexCount);
+			}
+			range.firstIndex = static_cast<uint32_t>(firstIndex);
+		}
+
+		//Recorded into the caller's upload batch, the caller decides when to submit
+		uploadContext.uploadBuffer(vertexBuffer->getBuffer(), vertexData, vertexStride * vertexCount, vertexStride * range.vertexOffset);
+		if (indexCount > 0)
+		{
+			uploadContext.uploadBuffer(storage.buffer->getBuffer(), indexData, storage.indexSize * indexCount, storage.indexSize * range.firstIndex);
+		}
+
+		return range;
+	}
+
+	void DyneGeometryPool::free(const DyneMeshRange& range)
+	{
+		vertexRanges.free(static_cast<uint64_t>(range.vertexOffset));
+		if (range.indexCount > 0)
+		{
+			indexStorage(range.indexType).ranges.free(range.firstIndex);
+		}
+	}
+
+	void DyneGeometryPool::bind(VkCommandBuffer commandBuffer, VkIndexType indexType)
+	{
+		VkBuffer buffers[] = { vertexBuffer->getBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, indexStorage(indexType).buffer->getBuffer(), 0, indexType);
+	}
+}
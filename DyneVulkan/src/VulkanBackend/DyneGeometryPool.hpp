@@ -0,0 +1,87 @@
+#pragma once
+
+#include "DyneDevice.hpp"
+#include "DyneBuffer.hpp"
+#include "DyneUploadContext.hpp"
+#include "DyneVertexFormat.hpp"
+#include "../Utility/DyneTlsf.hpp"
+
+#include <array>
+#include <memory>
+
+namespace Dyne
+{
+	// Where a mesh lives inside the shared vertex & index buffers
+	struct DyneMeshRange
+	{
+		uint32_t firstIndex = 0;
+		int32_t vertexOffset = 0;
+		uint32_t indexCount = 0;
+		uint32_t vertexCount = 0;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	};
+
+	// One device local vertex buffer and one index buffer per index type shared by every model, so a frame
+	// binds geometry once per index type and only issues draws. All vertices share one VertexFormat.
+	// Ranges are handed out by DyneTlsf, in units of vertices / indices, and the buffers grow when they
+	// run out of space. The buffers are shared with the transfer queue so meshes can be streamed in on it.
+	class DyneGeometryPool
+	{
+	public:
+		static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1 << 18;
+		static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 1 << 20;
+
+		DyneGeometryPool(
+			DyneDevice& device,
+			VertexFormat vertexFormat,
+			uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+			uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+		~DyneGeometryPool();
+
+		DyneGeometryPool(const DyneGeometryPool&) = delete;
+		DyneGeometryPool& operator=(const DyneGeometryPool&) = delete;
+
+		// vertexData must be in the pool's format and indexData of indexType. indices may be empty for
+		// non indexed meshes, the copies are recorded into uploadContext
+		DyneMeshRange upload(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount, VkIndexType indexType);
+		DyneMeshRange upload(
+			DyneUploadContext& uploadContext,
+			const void* vertexData,
+			uint32_t vertexCount,
+			const void* indexData,
+			uint32_t indexCount,
+			VkIndexType indexType);
+		void free(const DyneMeshRange& range);
+
+		// Binds the vertices and the index buffer of indexType
+		void bind(VkCommandBuffer commandBuffer, VkIndexType indexType);
+
+		VkBuffer getVertexBuffer() const { return vertexBuffer->getBuffer(); }
+		VkBuffer getIndexBuffer(VkIndexType indexType) const { return indexStorage(indexType).buffer->getBuffer(); }
+		VkDeviceSize getVertexStride() const { return vertexStride; }
+		VertexFormat getVertexFormat() const { return vertexFormat; }
+
+	private:
+		struct IndexStorage
+		{
+			std::unique_ptr<DyneBuffer> buffer;
+			DyneTlsf ranges;
+			VkDeviceSize indexSize;
+		};
+
+		static std::unique_ptr<DyneBuffer> createBuffer(DyneDevice& device, VkDeviceSize elementSize, uint32_t capacity, VkBufferUsageFlags usage);
+		void growVertices(uint32_t minCapacity, DyneUploadContext& pendingContext);
+		void growIndices(IndexStorage& storage, uint32_t minCapacity, DyneUploadContext& pendingContext);
+		IndexStorage& indexStorage(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT16 ? indices16 : indices32; }
+		const IndexStorage& indexStorage(VkIndexType indexType) const { return indexType == VK_INDEX_TYPE_UINT16 ? indices16 : indices32; }
+
+		DyneDevice& _deviceRef;
+		VertexFormat vertexFormat;
+		VkDeviceSize vertexStride;
+
+		std::unique_ptr<DyneBuffer> vertexBuffer;
+		DyneTlsf vertexRanges;
+		IndexStorage indices16;
+		IndexStorage indices32;
+	};
+}
@@ -0,0 +1,306 @@
+#include "DyneKtx2.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace Dyne
+{
+	namespace
+	{
+		const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+		constexpr size_t HEADER_SIZE = 80;
+		constexpr size_t LEVEL_INDEX_ENTRY_SIZE = 24;
+
+		//Data format descriptor values, from the Khronos data format specification
+		constexpr uint32_t DFD_MODEL_RGBSDA = 1;
+		constexpr uint32_t DFD_MODEL_BC1A = 128;
+		constexpr uint32_t DFD_MODEL_BC3 = 130;
+		constexpr uint32_t DFD_MODEL_BC5 = 132;
+		constexpr uint32_t DFD_MODEL_BC7 = 134;
+		constexpr uint32_t DFD_PRIMARIES_BT709 = 1;
+		constexpr uint32_t DFD_TRANSFER_LINEAR = 1;
+		constexpr uint32_t DFD_TRANSFER_SRGB = 2;
+		constexpr uint32_t DFD_CHANNEL_ALPHA = 15;
+		constexpr uint32_t DFD_QUALIFIER_LINEAR = 1u << 28;
+
+		struct DfdSample
+		{
+			uint32_t bitOffset;
+			uint32_t bitLength;
+			uint32_t channel;
+			uint32_t upper;
+		};
+
+		struct FormatDescription
+		{
+			uint32_t colorModel = 0;
+			bool srgb = false;
+			uint32_t blockBytes = 0;	//Per 4x4 block, or per texel when not block compressed
+			std::vector<DfdSample> samples;
+		};
+
+		bool describeFormat(VkFormat format, FormatDescription& description)
+		{
+			constexpr uint32_t FULL = 0xFFFFFFFF;
+			switch (format)
+			{
+			case VK_FORMAT_R8G8B8A8_UNORM:
+			case VK_FORMAT_R8G8B8A8_SRGB:
+				description = { DFD_MODEL_RGBSDA, format == VK_FORMAT_R8G8B8A8_SRGB, 4,
+					{ { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, DFD_CHANNEL_ALPHA, 255 } } };
+				return true;
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+				description = { DFD_MODEL_BC1A, format == VK_FORMAT_BC1_RGB_SRGB_BLOCK, 8, { { 0, 64, 0, FULL } } };
+				return true;
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+				//Channel 1 marks the 3 color mode as punching through alpha
+				description = { DFD_MODEL_BC1A, format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 8, { { 0, 64, 1, FULL } } };
+				return true;
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+				description = { DFD_MODEL_BC3, format == VK_FORMAT_BC3_SRGB_BLOCK, 16, { { 0, 64, DFD_CHANNEL_ALPHA, FULL }, { 64, 64, 0, FULL } } };
+				return true;
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+				description = { DFD_MODEL_BC5, false, 16, { { 0, 64, 0, FULL }, { 64, 64, 1, FULL } } };
+				return true;
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+				description = { DFD_MODEL_BC7, format == VK_FORMAT_BC7_SRGB_BLOCK, 16, { { 0, 128, 0, FULL } } };
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		uint32_t readU32(const std::vector<uint8_t>& data, size_t offset)
+		{
+			uint32_t value;
+			std::memcpy(&value, &data[offset], sizeof(value));
+			return value;
+		}
+
+		uint64_t readU64(const std::vector<uint8_t>& data, size_t offset)
+		{
+			uint64_t value;
+			std::memcpy(&value, &data[offset], sizeof(value));
+			return value;
+		}
+
+		void writeU32(std::vector<uint8_t>& data, size_t offset, uint32_t value)
+		{
+			std::memcpy(&data[offset], &value, sizeof(value));
+		}
+
+		void writeU64(std::vector<uint8_t>& data, size_t offset, uint64_t value)
+		{
+			std::memcpy(&data[offset], &value, sizeof(value));
+		}
+
+		size_t alignUp(size_t value, size_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	bool isBlockCompressedFormat(VkFormat format)
+	{
+		return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+	}
+
+	VkDeviceSize getImageLevelSize(VkFormat format, uint32_t width, uint32_t height)
+	{
+		FormatDescription description;
+		if (!describeFormat(format, description)) return 0;
+
+		if (isBlockCompressedFormat(format))
+		{
+			return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * description.blockBytes;
+		}
+		return static_cast<VkDeviceSize>(width) * height * description.blockBytes;
+	}
+
+	Ktx2Header readKtx2Header(const std::string& filepath)
+	{
+		std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+		std::vector<uint8_t> data(HEADER_SIZE);
+		file.seekg(0);
+		if (!file.read(reinterpret_cast<char*>(data.data()), data.size()) || std::memcmp(data.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		{
+			throw std::runtime_error("failed to read KTX2 file, bad identifier: " + filepath);
+		}
+
+		Ktx2Header header{};
+		header.format = static_cast<VkFormat>(readU32(data, 12));
+		header.width = readU32(data, 20);
+		header.height = readU32(data, 24);
+		uint32_t depth = readU32(data, 28);
+		uint32_t layerCount = readU32(data, 32);
+		uint32_t faceCount = readU32(data, 36);
+		uint32_t levelCount = std::max(readU32(data, 40), 1u);
+		uint32_t supercompression = readU32(data, 44);
+
+		if (getImageLevelSize(header.format, 1, 1) == 0 || header.width == 0 || header.height == 0 ||
+			depth != 0 || layerCount > 1 || faceCount != 1 || supercompression != 0)
+		{
+			throw std::runtime_error("failed to read KTX2 file, only plain 2D BC or RGBA8 images are supported: " + filepath);
+		}
+
+		data.resize(HEADER_SIZE + levelCount * LEVEL_INDEX_ENTRY_SIZE);
+		if (levelCount > 32 || !file.read(reinterpret_cast<char*>(data.data() + HEADER_SIZE), data.size() - HEADER_SIZE))
+		{
+			throw std::runtime_error("failed to read KTX2 file, truncated level index: " + filepath);
+		}
+
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			size_t entry = HEADER_SIZE + level * LEVEL_INDEX_ENTRY_SIZE;
+			uint64_t offset = readU64(data, entry);
+			uint64_t length = readU64(data, entry + 8);
+
+			uint32_t levelWidth = std::max(header.width >> level, 1u);
+			uint32_t levelHeight = std::max(header.height >> level, 1u);
+			if (length != getImageLevelSize(header.format, levelWidth, levelHeight) || offset > fileSize || length > fileSize - offset)
+			{
+				throw std::runtime_error("failed to read KTX2 file, bad level " + std::to_string(level) + ": " + filepath);
+			}
+			header.levelOffsets.push_back(offset);
+		}
+		return header;
+	}
+
+	void readKtx2Levels(const std::string& filepath, const Ktx2Header& header, void* const* destinations)
+	{
+		std::ifstream file{ filepath, std::ios::binary };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		for (uint32_t level = 0; level < header.levelOffsets.size(); level++)
+		{
+			if (destinations[level] == nullptr) continue;
+
+			uint32_t levelWidth = std::max(header.width >> level, 1u);
+			uint32_t levelHeight = std::max(header.height >> level, 1u);
+			file.seekg(static_cast<std::streamoff>(header.levelOffsets[level]));
+			if (!file.read(static_cast<char*>(destinations[level]), static_cast<std::streamsize>(getImageLevelSize(header.format, levelWidth, levelHeight))))
+			{
+				throw std::runtime_error("failed to read KTX2 file, truncated level " + std::to_string(level) + ": " + filepath);
+			}
+		}
+	}
+
+	Ktx2Image readKtx2(const std::string& filepath)
+	{
+		Ktx2Header header = readKtx2Header(filepath);
+
+		Ktx2Image image{};
+		image.format = header.format;
+		image.width = header.width;
+		image.height = header.height;
+		image.levels.resize(header.levelOffsets.size());
+
+		std::vector<void*> destinations;
+		for (uint32_t level = 0; level < image.levels.size(); level++)
+		{
+			image.levels[level].resize(getImageLevelSize(header.format, std::max(header.width >> level, 1u), std::max(header.height >> level, 1u)));
+			destinations.push_back(image.levels[level].data());
+		}
+		readKtx2Levels(filepath, header, destinations.data());
+		return image;
+	}
+
+	void writeKtx2(const std::string& filepath, const Ktx2Image& image)
+	{
+		FormatDescription description;
+		if (!describeFormat(image.format, description) || image.levels.empty())
+		{
+			throw std::runtime_error("failed to write KTX2 file, unsupported image: " + filepath);
+		}
+
+		//Basic descriptor block: 6 words of header then 4 per sample, after the total size word
+		uint32_t dfdBlockSize = 24 + 16 * static_cast<uint32_t>(description.samples.size());
+		uint32_t dfdSize = 4 + dfdBlockSize;
+		uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+		size_t dfdOffset = HEADER_SIZE + levelCount * LEVEL_INDEX_ENTRY_SIZE;
+
+		//Levels go smallest first so the coarse ones can be read without the rest, each aligned to a block
+		size_t levelAlignment = std::max<size_t>(description.blockBytes, 4);
+		std::vector<size_t> levelOffsets(levelCount);
+		size_t fileSize = dfdOffset + dfdSize;
+		for (uint32_t level = levelCount; level-- > 0;)
+		{
+			uint32_t levelWidth = std::max(image.width >> level, 1u);
+			uint32_t levelHeight = std::max(image.height >> level, 1u);
+			if (image.levels[level].size() != getImageLevelSize(image.format, levelWidth, levelHeight))
+			{
+				throw std::runtime_error("failed to write KTX2 file, level " + std::to_string(level) + " doesn't match its extent: " + filepath);
+			}
+
+			levelOffsets[level] = alignUp(fileSize, levelAlignment);
+			fileSize = levelOffsets[level] + image.levels[level].size();
+		}
+
+		std::vector<uint8_t> data(fileSize, 0);
+		std::memcpy(data.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+		writeU32(data, 12, image.format);
+		writeU32(data, 16, 1);	//typeSize, 1 for block compressed and 8 bit formats
+		writeU32(data, 20, image.width);
+		writeU32(data, 24, image.height);
+		writeU32(data, 28, 0);
+		writeU32(data, 32, 0);
+		writeU32(data, 36, 1);
+		writeU32(data, 40, levelCount);
+		writeU32(data, 44, 0);
+		writeU32(data, 48, static_cast<uint32_t>(dfdOffset));
+		writeU32(data, 52, dfdSize);
+
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			size_t entry = HEADER_SIZE + level * LEVEL_INDEX_ENTRY_SIZE;
+			writeU64(data, entry, levelOffsets[level]);
+			writeU64(data, entry + 8, image.levels[level].size());
+			writeU64(data, entry + 16, image.levels[level].size());
+			std::memcpy(&data[levelOffsets[level]], image.levels[level].data(), image.levels[level].size());
+		}
+
+		bool compressed = isBlockCompressedFormat(image.format);
+		size_t dfd = dfdOffset;
+		writeU32(data, dfd, dfdSize);
+		writeU32(data, dfd + 4, 0);
+		writeU32(data, dfd + 8, 2 | (dfdBlockSize << 16));
+		writeU32(data, dfd + 12, description.colorModel | (DFD_PRIMARIES_BT709 << 8) |
+			((description.srgb ? DFD_TRANSFER_SRGB : DFD_TRANSFER_LINEAR) << 16));
+		writeU32(data, dfd + 16, compressed ? 3 | (3 << 8) : 0);
+		writeU32(data, dfd + 20, description.blockBytes);
+		writeU32(data, dfd + 24, 0);
+
+		size_t sampleOffset = dfd + 28;
+		for (const DfdSample& sample : description.samples)
+		{
+			//Alpha is never sRGB encoded
+			uint32_t qualifiers = description.srgb && sample.channel == DFD_CHANNEL_ALPHA ? DFD_QUALIFIER_LINEAR : 0;
+			writeU32(data, sampleOffset, sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24) | qualifiers);
+			writeU32(data, sampleOffset + 4, 0);
+			writeU32(data, sampleOffset + 8, 0);
+			writeU32(data, sampleOffset + 12, sample.upper);
+			sampleOffset += 16;
+		}
+
+		std::ofstream file{ filepath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open() || !file.write(reinterpret_cast<const char*>(data.data()), data.size()))
+		{
+			throw std::runtime_error("failed to write file: " + filepath);
+		}
+	}
+}
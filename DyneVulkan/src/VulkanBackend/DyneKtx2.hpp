@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Dyne
+{
+	// A 2D texture as stored in a KTX2 container, without supercompression
+	struct Ktx2Image
+	{
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<std::vector<uint8_t>> levels;	//Level 0 first, each half the size of the one above rounded down
+	};
+
+	bool isBlockCompressedFormat(VkFormat format);
+	// Bytes of one level of a 2D image, BC formats in whole 4x4 blocks. 0 for formats KTX2 files may not hold here
+	VkDeviceSize getImageLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+	// Validated header and level index of a KTX2 file
+	struct Ktx2Header
+	{
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint64_t> levelOffsets;	//File offset of every level, level 0 first
+	};
+
+	// All of these throw when the file can't be read or written or holds anything but a 2D BC or RGBA8 image
+	Ktx2Header readKtx2Header(const std::string& filepath);
+	// Reads every level of header straight into destinations[level], which hold getImageLevelSize bytes each.
+	// Levels with a null destination are skipped without being read
+	void readKtx2Levels(const std::string& filepath, const Ktx2Header& header, void* const* destinations);
+	Ktx2Image readKtx2(const std::string& filepath);
+	void writeKtx2(const std::string& filepath, const Ktx2Image& image);
+}
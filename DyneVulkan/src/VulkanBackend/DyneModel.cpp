@@ -1,14 +1,19 @@
 #include "DyneModel.hpp"
 
 #include "../Utility/DyneUtils.hpp"
+#include "../Utility/DyneMeshSimplifier.hpp"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tinyobjloader/tiny_obj_loader.h>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
+#include <iostream>
 #include <unordered_map>
 
 namespace std
@@ -27,135 +32,216 @@ namespace std
 
 namespace Dyne
 {
-	DyneModel::DyneModel(DyneDevice& device, const DyneModel::Builder& builder) : _deviceRef(device)
+	namespace
 	{
-		createVertexBuffers(builder.vertices);
-		createIndexBuffers(builder.indices);
-	}
+		int16_t toSnorm16(float value)
+		{
+			return static_cast<int16_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+		}
 
-	DyneModel::~DyneModel()
-	{
-		
-	}
+		uint16_t toHalf(float value)
+		{
+			return static_cast<uint16_t>(glm::packHalf1x16(value));
+		}
 
-	std::unique_ptr<DyneModel> DyneModel::createModelFromFile(DyneDevice& device, const std::string& filepath)
-	{
-		Builder builder{};
-		builder.loadModel(filepath);
-		return std::make_unique<DyneModel>(device, builder);
-	}
+		//Folds the unit sphere onto an octahedron and that into [-1, 1]^2, decoded in shader_packed.vert
+		glm::vec2 encodeOctahedral(glm::vec3 normal)
+		{
+			float manhattanLength = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			if (manhattanLength == 0.0f) return glm::vec2(0.0f);
 
-	void DyneModel::bind(VkCommandBuffer commandBuffer)
-	{
-		VkBuffer buffers[] = { vertexBuffer->getBuffer()};
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+			normal /= manhattanLength;
+			glm::vec2 encoded{ normal.x, normal.y };
+			if (normal.z < 0.0f)
+			{
+				glm::vec2 signs{ encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f };
+				encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signs;
+			}
+			return encoded;
+		}
 
-		if (hasIndexBuffer)
+		//Position, normal & uv are shared by both packed layouts
+		template<typename PackedType>
+		void packCommon(const DyneModel::Vertex& vertex, PackedType& packed)
 		{
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			packed.position[0] = toHalf(vertex.position.x);
+			packed.position[1] = toHalf(vertex.position.y);
+			packed.position[2] = toHalf(vertex.position.z);
+			packed.position[3] = toHalf(1.0f);
+
+			glm::vec2 normal = encodeOctahedral(vertex.normal);
+			packed.normal[0] = toSnorm16(normal.x);
+			packed.normal[1] = toSnorm16(normal.y);
+
+			packed.uv[0] = toHalf(vertex.uv.x);
+			packed.uv[1] = toHalf(vertex.uv.y);
 		}
-	}
 
-	void DyneModel::draw(VkCommandBuffer commandBuffer)
-	{
-		if (hasIndexBuffer) 
+		void packVertex(const DyneModel::Vertex& vertex, PackedVertex& packed)
 		{
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+			packCommon(vertex, packed);
 		}
-		else
+
+		void packVertex(const DyneModel::Vertex& vertex, PackedColorVertex& packed)
 		{
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+			packCommon(vertex, packed);
+			glm::vec3 color = glm::clamp(vertex.color, 0.0f, 1.0f) * 255.0f + 0.5f;
+			packed.color[0] = static_cast<uint8_t>(color.r);
+			packed.color[1] = static_cast<uint8_t>(color.g);
+			packed.color[2] = static_cast<uint8_t>(color.b);
+			packed.color[3] = 255;
 		}
-	}
-
-	void DyneModel::createVertexBuffers(const std::vector<Vertex>& vertices)
-	{
-		vertexCount = static_cast<uint32_t>(vertices.size());
-		assert(vertexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-
-		uint32_t vertexSize = sizeof(vertices[0]);
 
-		DyneBuffer stagingBuffer
+		//Converts the vertices to Format's layout into bytes. With mergeDuplicates vertices that pack to the same bytes
+		//are merged, remap receives the new index of every old vertex. Returns the packed vertex count.
+		template<VertexFormat Format>
+		uint32_t packVertices(const std::vector<DyneModel::Vertex>& vertices, bool mergeDuplicates, std::vector<uint32_t>& remap, std::vector<uint8_t>& bytes)
 		{
-			_deviceRef,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
+			using Type = typename VertexLayout<Format>::Type;
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*) vertices.data());
+			std::vector<Type> packed;
+			packed.reserve(vertices.size());
+			remap.resize(vertices.size());
 
-		vertexBuffer = std::make_unique<DyneBuffer>
-		(
-			_deviceRef,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
+			if constexpr (Format == VertexFormat::Full)
+			{
+				//Already deduplicated by the loader
+				for (size_t i = 0; i < vertices.size(); i++)
+				{
+					packed.push_back(vertices[i]);
+					remap[i] = static_cast<uint32_t>(i);
+				}
+			}
+			else
+			{
+				std::unordered_map<Type, uint32_t, PackedVertexHash<Type>, PackedVertexEqual<Type>> uniqueVertices{};
+				uniqueVertices.reserve(vertices.size());
+				for (size_t i = 0; i < vertices.size(); i++)
+				{
+					Type vertex{};
+					packVertex(vertices[i], vertex);
 
-		_deviceRef.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
-	}
+					if (!mergeDuplicates)
+					{
+						remap[i] = static_cast<uint32_t>(packed.size());
+						packed.push_back(vertex);
+						continue;
+					}
+
+					auto inserted = uniqueVertices.emplace(vertex, static_cast<uint32_t>(packed.size()));
+					if (inserted.second) packed.push_back(vertex);
+					remap[i] = inserted.first->second;
+				}
+			}
 
-	void DyneModel::createIndexBuffers(const std::vector<uint32_t>& indices)
-	{
-		indexCount = static_cast<uint32_t>(indices.size());
-		hasIndexBuffer = indexCount > 0;
+			bytes.resize(packed.size() * sizeof(Type));
+			std::memcpy(bytes.data(), packed.data(), bytes.size());
+			return static_cast<uint32_t>(packed.size());
+		}
+	}
 
-		if (!hasIndexBuffer) return;
+	std::atomic<uint32_t> DyneModel::nextId{ 0 };
 
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
+	DyneModel::DyneModel(DyneDevice& device, DyneGeometryPool& geometryPool, const DyneModel::Builder& builder) : 
+		DyneModel(device, geometryPool, device.uploadContext(), builder)
+	{
+	}
 
-		DyneBuffer stagingBuffer
+	DyneModel::DyneModel(DyneDevice& device, DyneGeometryPool& geometryPool, DyneUploadContext& uploadContext, const DyneModel::Builder& builder) : 
+		_deviceRef(device), _geometryPoolRef(geometryPool), id(nextId++)
+	{
+		assert(builder.vertices.size() >= 3 && "Vertex count must be at least 3");
+
+		//Non indexed meshes draw every vertex in order, so they can't merge any
+		bool mergeDuplicates = !builder.indices.empty();
+		std::vector<uint32_t> remap;
+		std::vector<uint8_t> vertexBytes;
+		uint32_t vertexCount = 0;
+		switch (geometryPool.getVertexFormat())
 		{
-			_deviceRef,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
+		case VertexFormat::Full:
+			vertexCount = packVertices<VertexFormat::Full>(builder.vertices, mergeDuplicates, remap, vertexBytes);
+			break;
+		case VertexFormat::Packed:
+			vertexCount = packVertices<VertexFormat::Packed>(builder.vertices, mergeDuplicates, remap, vertexBytes);
+			break;
+		case VertexFormat::PackedColor:
+			vertexCount = packVertices<VertexFormat::PackedColor>(builder.vertices, mergeDuplicates, remap, vertexBytes);
+			break;
+		}
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*) indices.data());
+		//Indices are relative to the vertex offset, so 16 bits cover any model below 65536 vertices
+		uint32_t indexCount = static_cast<uint32_t>(builder.indices.size());
+		if (vertexCount < 65536)
+		{
+			std::vector<uint16_t> indices16(indexCount);
+			for (uint32_t i = 0; i < indexCount; i++)
+			{
+				indices16[i] = static_cast<uint16_t>(remap[builder.indices[i]]);
+			}
+			meshRange = geometryPool.upload(uploadContext, vertexBytes.data(), vertexCount, indices16.data(), indexCount, VK_INDEX_TYPE_UINT16);
+		}
+		else
+		{
+			std::vector<uint32_t> indices32(indexCount);
+			for (uint32_t i = 0; i < indexCount; i++)
+			{
+				indices32[i] = remap[builder.indices[i]];
+			}
+			meshRange = geometryPool.upload(uploadContext, vertexBytes.data(), vertexCount, indices32.data(), indexCount, VK_INDEX_TYPE_UINT32);
+		}
+		boundingSphere = glm::vec4(builder.boundsCenter, builder.boundsRadius);
 
-		indexBuffer = std::make_unique<DyneBuffer>
-		(
-			_deviceRef,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
+		lods = builder.lods;
+		if (lods.empty())
+		{
+			lods.push_back(Lod{ 0, meshRange.indexCount, 0.0f });
+		}
+		assert(lods.size() <= MAX_LODS && "Too many levels of detail!");
 
-		_deviceRef.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+		meshlets = builder.meshlets;
 	}
 
-	std::vector<VkVertexInputBindingDescription> DyneModel::Vertex::getBindingDescription()
+	DyneModel::~DyneModel()
 	{
-		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
-
-		bindingDescriptions[0].binding = 0;
-		bindingDescriptions[0].stride = sizeof(Vertex);
-		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		_geometryPoolRef.free(meshRange);
+	}
 
-		return bindingDescriptions;
+	std::unique_ptr<DyneModel> DyneModel::createModelFromFile(DyneDevice& device, DyneGeometryPool& geometryPool, const std::string& filepath)
+	{
+		Builder builder{};
+		builder.loadModel(filepath);
+		return std::make_unique<DyneModel>(device, geometryPool, builder);
 	}
 
-	std::vector<VkVertexInputAttributeDescription> DyneModel::Vertex::getAttributeDescription()
+	void DyneModel::bind(VkCommandBuffer commandBuffer)
 	{
-		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+		_geometryPoolRef.bind(commandBuffer, meshRange.indexType);
+	}
 
-		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) });
-		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) });
-		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) });
-		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) });
+	void DyneModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod)
+	{
+		if (hasIndices()) 
+		{
+			const Lod& level = lods[lod];
+			vkCmdDrawIndexed(commandBuffer, level.indexCount, instanceCount, meshRange.firstIndex + level.firstIndex, meshRange.vertexOffset, firstInstance);
+		}
+		else
+		{
+			vkCmdDraw(commandBuffer, meshRange.vertexCount, instanceCount, static_cast<uint32_t>(meshRange.vertexOffset), firstInstance);
+		}
+	}
 
-		return attributeDescriptions;
+	uint32_t DyneModel::selectLod(float projectedRadius, float maxPixelError, uint32_t currentLod) const
+	{
+		uint32_t level = 0;
+		for (uint32_t i = 1; i < lods.size(); i++)
+		{
+			float allowedError = i > currentLod ? maxPixelError * (1.0f - LOD_HYSTERESIS) : maxPixelError;
+			if (lods[i].error * projectedRadius > allowedError) break;
+			level = i;
+		}
+		return level;
 	}
 
 	void DyneModel::Builder::loadModel(const std::string& filepath)
@@ -224,5 +310,192 @@ namespace Dyne
 				indices.push_back(uniqueVertices[vertex]);
 			}
 		}
+
+		computeBounds();
+		generateLods();
+		generateMeshlets();
+		optimize();
+
+		std::cout << filepath << ": ACMR " << cacheStatsBefore.acmr << " -> " << cacheStatsAfter.acmr
+			<< ", ATVR " << cacheStatsBefore.atvr << " -> " << cacheStatsAfter.atvr
+			<< ", " << meshlets.size() << " meshlets\n";
+	}
+
+	void DyneModel::Builder::optimize()
+	{
+		if (indices.empty()) return;
+
+		uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+		std::vector<glm::vec3> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			positions[i] = vertices[i].position;
+		}
+
+		std::vector<Lod> levels = lods;
+		if (levels.empty())
+		{
+			levels.push_back(Lod{ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+		}
+
+		cacheStatsBefore = analyzeVertexCache(&indices[levels[0].firstIndex], levels[0].indexCount, vertexCount);
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			const Lod& level = levels[i];
+			if (i == 0 && !meshlets.empty())
+			{
+				//Meshlets are already ordered for overdraw and have to stay consecutive, only their triangles move.
+				//Each is optimized on its own few vertices, numbered locally
+				std::vector<uint32_t> localIndices;
+				std::vector<uint32_t> meshletVertices;
+				for (const Meshlet& meshlet : meshlets)
+				{
+					localIndices.resize(meshlet.indexCount);
+					meshletVertices.clear();
+					for (uint32_t j = 0; j < meshlet.indexCount; j++)
+					{
+						uint32_t vertex = indices[meshlet.firstIndex + j];
+						auto it = std::find(meshletVertices.begin(), meshletVertices.end(), vertex);
+						localIndices[j] = static_cast<uint32_t>(it - meshletVertices.begin());
+						if (it == meshletVertices.end()) meshletVertices.push_back(vertex);
+					}
+
+					optimizeVertexCache(localIndices.data(), localIndices.size(), static_cast<uint32_t>(meshletVertices.size()));
+					for (uint32_t j = 0; j < meshlet.indexCount; j++)
+					{
+						indices[meshlet.firstIndex + j] = meshletVertices[localIndices[j]];
+					}
+				}
+				continue;
+			}
+
+			//Overdraw ordering runs the cache optimization itself
+			optimizeOverdraw(&indices[level.firstIndex], level.indexCount, positions);
+		}
+
+		//Full detail comes first in the index list, so its vertices end up first in memory
+		uint32_t usedVertexCount = 0;
+		std::vector<uint32_t> remap = optimizeVertexFetch(indices, vertexCount, usedVertexCount);
+		std::vector<Vertex> reordered(usedVertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if (remap[v] != NOT_REFERENCED) reordered[remap[v]] = vertices[v];
+		}
+		vertices = std::move(reordered);
+
+		cacheStatsAfter = analyzeVertexCache(&indices[levels[0].firstIndex], levels[0].indexCount, usedVertexCount);
+	}
+
+	void DyneModel::Builder::generateMeshlets()
+	{
+		meshlets.clear();
+		if (indices.empty()) return;
+
+		std::vector<glm::vec3> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			positions[i] = vertices[i].position;
+		}
+
+		size_t fullIndexCount = lods.empty() ? indices.size() : lods[0].indexCount;
+		meshlets = buildMeshlets(indices.data(), fullIndexCount, positions);
+
+		//Outward facing meshlets first, they likely cover the rest of the mesh
+		auto outwardness = [this](const Meshlet& meshlet)
+		{
+			return meshlet.coneCutoff < 1.0f ? glm::dot(meshlet.center - boundsCenter, meshlet.coneAxis) : 0.0f;
+		};
+		std::stable_sort(meshlets.begin(), meshlets.end(), [&](const Meshlet& a, const Meshlet& b) { return outwardness(a) > outwardness(b); });
+
+		std::vector<uint32_t> meshletIndices;
+		meshletIndices.reserve(fullIndexCount);
+		for (Meshlet& meshlet : meshlets)
+		{
+			uint32_t firstIndex = static_cast<uint32_t>(meshletIndices.size());
+			meshletIndices.insert(meshletIndices.end(), indices.begin() + meshlet.firstIndex, indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+			meshlet.firstIndex = firstIndex;
+		}
+		std::copy(meshletIndices.begin(), meshletIndices.end(), indices.begin());
+
+		bool backfaceCullable = isClosedMesh(indices.data(), fullIndexCount, positions);
+		if (backfaceCullable)
+		{
+			//Meshes without normals count as agreeing
+			float agreement = 0.0f;
+			for (size_t i = 0; i < fullIndexCount; i += 3)
+			{
+				const Vertex& v0 = vertices[indices[i]];
+				const Vertex& v1 = vertices[indices[i + 1]];
+				const Vertex& v2 = vertices[indices[i + 2]];
+				glm::vec3 faceNormal = glm::cross(v1.position - v0.position, v2.position - v0.position);
+				agreement += glm::dot(faceNormal, v0.normal + v1.normal + v2.normal);
+			}
+			backfaceCullable = agreement >= 0.0f;
+		}
+
+		if (!backfaceCullable)
+		{
+			for (Meshlet& meshlet : meshlets)
+			{
+				meshlet.coneCutoff = 1.0f;
+			}
+		}
+	}
+
+	void DyneModel::Builder::generateLods()
+	{
+		//A level has to drop at least this share of the triangles of the one before
+		constexpr float MIN_REDUCTION = 0.2f;
+
+		lods.clear();
+		if (indices.empty()) return;
+
+		uint32_t fullIndexCount = static_cast<uint32_t>(indices.size());
+		lods.push_back(Lod{ 0, fullIndexCount, 0.0f });
+		if (boundsRadius <= 0.0f) return;
+
+		std::vector<glm::vec3> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			positions[i] = vertices[i].position;
+		}
+
+		//Every level is simplified from the full mesh, so its error is measured against the original surface
+		std::vector<uint32_t> fullIndices(indices.begin(), indices.end());
+		for (float lodError : lodErrors)
+		{
+			if (lods.size() == MAX_LODS) break;
+
+			const Lod& previous = lods.back();
+			size_t targetIndexCount = (previous.indexCount / 6) * 3;
+			float resultError = 0.0f;
+			std::vector<uint32_t> lodIndices = simplifyMesh(positions, fullIndices, targetIndexCount, lodError * boundsRadius, &resultError);
+
+			if (lodIndices.empty() || lodIndices.size() > previous.indexCount * (1.0f - MIN_REDUCTION)) break;
+
+			float relativeError = std::max(previous.error, resultError / boundsRadius);
+			lods.push_back(Lod{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size()), relativeError });
+			indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+		}
+	}
+
+	void DyneModel::Builder::computeBounds()
+	{
+		if (vertices.empty()) return;
+
+		glm::vec3 minPos = vertices[0].position;
+		glm::vec3 maxPos = vertices[0].position;
+		for (const auto& vertex : vertices)
+		{
+			minPos = glm::min(minPos, vertex.position);
+			maxPos = glm::max(maxPos, vertex.position);
+		}
+
+		boundsCenter = (minPos + maxPos) * 0.5f;
+		boundsRadius = 0.0f;
+		for (const auto& vertex : vertices)
+		{
+			boundsRadius = glm::max(boundsRadius, glm::length(vertex.position - boundsCenter));
+		}
 	}
 }	
\ No newline at end of file
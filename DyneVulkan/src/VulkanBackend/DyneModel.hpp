@@ -2,11 +2,16 @@
 
 #include "DyneDevice.hpp"
 #include "DyneBuffer.hpp"
+#include "DyneGeometryPool.hpp"
+#include "DyneVertexFormat.hpp"
+#include "../Utility/DyneMeshOptimizer.hpp"
+#include "../Utility/DyneMeshlets.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -15,57 +20,106 @@ namespace Dyne
 	class DyneModel
 	{
 	public:
+		//Levels fit in the draw sort key, see DefaultRenderSystem
+		static constexpr uint32_t MAX_LODS = 8;
+		//Share of the pixel error a coarser level has to stay below before it's switched to
+		static constexpr float LOD_HYSTERESIS = 0.25f;
 
-		struct Vertex
+		//One level of detail, an index range over the shared vertices
+		struct Lod
 		{
-			glm::vec3 position{};
-			glm::vec3 color{};
-			glm::vec3 normal{};
-			glm::vec2 uv{};
-
-			static std::vector<VkVertexInputBindingDescription> getBindingDescription();
-			static std::vector<VkVertexInputAttributeDescription> getAttributeDescription();
-
-			bool operator==(const Vertex& other) const
-			{
-				return 
-					position == other.position && 
-					color == other.color && 
-					normal == other.normal && 
-					uv == other.uv;
-			}
+			//Relative to the model's first index
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			//Largest deviation from the full mesh, relative to the bounding radius
+			float error = 0.0f;
 		};
 
+		//Loaded & processed as full floats, packed into the geometry pool's format on upload
+		using Vertex = FullVertex;
+
 		struct Builder
 		{
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
 
+			//Local space bounding sphere, filled by computeBounds()
+			glm::vec3 boundsCenter{ 0.0f };
+			float boundsRadius = 0.0f;
+
+			//Error allowed for each level below the full mesh, relative to the bounding radius
+			std::vector<float> lodErrors{ 0.002f, 0.008f, 0.03f, 0.1f };
+			//Filled by generateLods(), level 0 is the full mesh. Empty means indices is the only level
+			std::vector<Lod> lods{};
+
+			//Post transform cache behaviour of the full detail level, filled by optimize()
+			VertexCacheStats cacheStatsBefore{};
+			VertexCacheStats cacheStatsAfter{};
+
+			//Filled by generateMeshlets(), clusters of the full detail level for culling on the GPU
+			std::vector<Meshlet> meshlets{};
+
 			void loadModel(const std::string& filepath);
+			void computeBounds();
+			//Appends a simplified index list per entry of lodErrors, each aiming for half the triangles of the one before.
+			//Stops early once a level no longer pays for itself. Needs the bounds.
+			void generateLods();
+			//Regroups the full detail level into meshlets ordered for overdraw. Run after generateLods(), before optimize().
+			//Their cones are only kept for closed meshes wound like their normals, elsewhere back faces may be seen.
+			void generateMeshlets();
+			//Reorders the triangles of every level for the vertex cache & overdraw, then the vertices into first use order.
+			//Run after generateLods(), the levels share the vertices. Meshlets keep their ranges.
+			void optimize();
 		};
 
-		DyneModel(DyneDevice& device, const DyneModel::Builder& builder);
+		DyneModel(DyneDevice& device, DyneGeometryPool& geometryPool, const DyneModel::Builder& builder);
+		//Records the geometry copies into uploadContext instead of the device's
+		DyneModel(DyneDevice& device, DyneGeometryPool& geometryPool, DyneUploadContext& uploadContext, const DyneModel::Builder& builder);
 		~DyneModel();
 
 		DyneModel(const DyneModel&) = delete;
 		DyneModel& operator=(const DyneModel&) = delete;
 
-		static std::unique_ptr<DyneModel> createModelFromFile(DyneDevice& device, const std::string& filepath);
+		static std::unique_ptr<DyneModel> createModelFromFile(DyneDevice& device, DyneGeometryPool& geometryPool, const std::string& filepath);
 
+		//Binds the whole geometry pool with this model's index type, models sharing both only need this once
 		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0);
+
+		//Coarsest level whose error covers at most maxPixelError pixels, when the bounding sphere's radius projects to
+		//projectedRadius pixels. Levels coarser than currentLod need a LOD_HYSTERESIS margin, so objects don't pop back and forth.
+		uint32_t selectLod(float projectedRadius, float maxPixelError, uint32_t currentLod) const;
+
+		bool hasIndices() const { return meshRange.indexCount > 0; }
+		//Of the full detail level
+		uint32_t getIndexCount() const { return lods[0].indexCount; }
+		uint32_t getVertexCount() const { return meshRange.vertexCount; }
+		uint32_t getFirstIndex() const { return meshRange.firstIndex; }
+		int32_t getVertexOffset() const { return meshRange.vertexOffset; }
+		//16 bit whenever the model has fewer than 65536 vertices
+		VkIndexType getIndexType() const { return meshRange.indexType; }
+		const DyneMeshRange& getMeshRange() const { return meshRange; }
+		DyneGeometryPool& getGeometryPool() { return _geometryPoolRef; }
+		glm::vec4 getBoundingSphere() const { return boundingSphere; }
+		uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+		const Lod& getLod(uint32_t level) const { return lods[level]; }
+		//Of the full detail level, index ranges relative to the model's first index
+		const std::vector<Meshlet>& getMeshlets() const { return meshlets; }
+		//Unique per model, used to group draws
+		uint32_t getId() const { return id; }
 
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
-		void createIndexBuffers(const std::vector<uint32_t>& indices);
+		static std::atomic<uint32_t> nextId;
 
 		DyneDevice& _deviceRef;
+		DyneGeometryPool& _geometryPoolRef;
 
-		std::unique_ptr<DyneBuffer> vertexBuffer;
-		uint32_t vertexCount;
+		DyneMeshRange meshRange{};
+		std::vector<Lod> lods{};
+		std::vector<Meshlet> meshlets{};
+		uint32_t id;
 
-		bool hasIndexBuffer = false;
-		std::unique_ptr<DyneBuffer> indexBuffer;
-		uint32_t indexCount;
+		//xyz = local center, w = radius
+		glm::vec4 boundingSphere{ 0.0f };
 	};
 }
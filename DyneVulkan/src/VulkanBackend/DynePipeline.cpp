@@ -1,5 +1,4 @@
 #include "DynePipeline.hpp"
-#include "DyneModel.hpp"
 
 #include <cassert>
 #include <fstream>
@@ -14,7 +13,17 @@ namespace Dyne {
 		const PipelineConfigInfo& configInfo) 
 		: _deviceRef(device)
 	{
-		createGraphicsPipeline(vertPath, fragPath, configInfo);
+		createGraphicsPipeline(readFile(vertPath), readFile(fragPath), configInfo);
+	}
+
+	DynePipeline::DynePipeline(
+		DyneDevice& device,
+		const std::vector<char>& vertCode,
+		const std::vector<char>& fragCode,
+		const PipelineConfigInfo& configInfo)
+		: _deviceRef(device)
+	{
+		createGraphicsPipeline(vertCode, fragCode, configInfo);
 	}
 
 	DynePipeline::~DynePipeline()
@@ -44,8 +53,8 @@ namespace Dyne {
 	}
 
 	void DynePipeline::createGraphicsPipeline(
-		const std::string& vertFilepath, 
-		const std::string& fragFilepath,
+		const std::vector<char>& vertCode,
+		const std::vector<char>& fragCode,
 		const PipelineConfigInfo& configInfo)
 	{
 		assert(
@@ -55,9 +64,6 @@ namespace Dyne {
 			configInfo.renderPass != VK_NULL_HANDLE &&
 			"Cannot create graphics pipeline: no renderPass provided in configInfo");
 
-		auto vertCode = readFile(vertFilepath);
-		auto fragCode = readFile(fragFilepath);
-
 		//std::cout << "Vertex shader code size: " << vertCode.size() << "\n";
 		//std::cout << "Fragment shader code size: " << fragCode.size() << "\n";
 
@@ -92,6 +98,17 @@ namespace Dyne {
 		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 
+		//The config may be a copy of the one defaultPipelineConfigInfo filled in, so its
+		//internal pointers are re-aimed at this instance
+		VkPipelineColorBlendStateCreateInfo colorBlendInfo = configInfo.colorBlendInfo;
+		if (colorBlendInfo.attachmentCount == 1)
+		{
+			colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+		}
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo = configInfo.dynamicStateInfo;
+		dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+		dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		pipelineInfo.stageCount = 2;
@@ -101,9 +118,9 @@ namespace Dyne {
 		pipelineInfo.pViewportState = &configInfo.viewportInfo;
 		pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
 		pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
-		pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
+		pipelineInfo.pColorBlendState = &colorBlendInfo;
 		pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
-		pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+		pipelineInfo.pDynamicState = &dynamicStateInfo;
 
 		pipelineInfo.layout = configInfo.pipelineLayout;
 		pipelineInfo.renderPass = configInfo.renderPass;
@@ -114,7 +131,7 @@ namespace Dyne {
 
 		if (vkCreateGraphicsPipelines(
 			_deviceRef.device(),
-			VK_NULL_HANDLE,
+			_deviceRef.pipelineCache(),
 			1,
 			&pipelineInfo,
 			nullptr,
@@ -141,7 +158,7 @@ namespace Dyne {
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 	}
 
-	void DynePipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
+	void DynePipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo, VertexFormat vertexFormat)
 	{
 		configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 		configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -211,7 +228,80 @@ namespace Dyne {
 		configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 		configInfo.dynamicStateInfo.flags = 0;
 
-		configInfo.bindingDescriptions = DyneModel::Vertex::getBindingDescription();
-		configInfo.attributeDescriptions = DyneModel::Vertex::getAttributeDescription();
+		const VertexFormatInfo& vertexInfo = getVertexFormatInfo(vertexFormat);
+		configInfo.bindingDescriptions.assign(1, vertexInfo.binding);
+		configInfo.attributeDescriptions.assign(vertexInfo.attributes, vertexInfo.attributes + vertexInfo.attributeCount);
+	}
+
+	DyneComputePipeline::DyneComputePipeline(
+		DyneDevice& device,
+		const std::string& compPath,
+		VkPipelineLayout pipelineLayout)
+		: _deviceRef(device)
+	{
+		createComputePipeline(DynePipeline::readFile(compPath), pipelineLayout);
+	}
+
+	DyneComputePipeline::DyneComputePipeline(
+		DyneDevice& device,
+		const std::vector<char>& compCode,
+		VkPipelineLayout pipelineLayout)
+		: _deviceRef(device)
+	{
+		createComputePipeline(compCode, pipelineLayout);
+	}
+
+	DyneComputePipeline::~DyneComputePipeline()
+	{
+		vkDestroyShaderModule(_deviceRef.device(), compShaderModule, nullptr);
+		vkDestroyPipeline(_deviceRef.device(), computePipeline, nullptr);
+	}
+
+	void DyneComputePipeline::createComputePipeline(const std::vector<char>& compCode, VkPipelineLayout pipelineLayout)
+	{
+		assert(
+			pipelineLayout != VK_NULL_HANDLE &&
+			"Cannot create compute pipeline: no pipelineLayout provided");
+
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = compCode.size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(compCode.data());
+
+		if (vkCreateShaderModule(_deviceRef.device(), &createInfo, nullptr, &compShaderModule) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create shader module!");
+		}
+
+		VkPipelineShaderStageCreateInfo shaderStage{};
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.module = compShaderModule;
+		shaderStage.pName = "main";
+		shaderStage.flags = 0;
+		shaderStage.pNext = nullptr;
+		shaderStage.pSpecializationInfo = nullptr;
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = shaderStage;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		if (vkCreateComputePipelines(
+			_deviceRef.device(),
+			_deviceRef.pipelineCache(),
+			1,
+			&pipelineInfo,
+			nullptr,
+			&computePipeline) != VK_SUCCESS) {
+
+			throw std::runtime_error("failed to create compute pipeline");
+		}
+	}
+
+	void DyneComputePipeline::bind(VkCommandBuffer commandBuffer) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
 	}
 }
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "DyneDevice.hpp"
+#include "DyneVertexFormat.hpp"
 
 namespace Dyne 
 {
@@ -33,6 +34,12 @@ namespace Dyne
 			const std::string& vertPath, 
 			const std::string& fragPath,
 			const PipelineConfigInfo& configInfo);
+		//From SPIR-V already in memory, used by DynePipelineCompiler
+		DynePipeline(
+			DyneDevice& device,
+			const std::vector<char>& vertCode,
+			const std::vector<char>& fragCode,
+			const PipelineConfigInfo& configInfo);
 		~DynePipeline();
 
 		DynePipeline(const DynePipeline&) = delete;
@@ -40,14 +47,14 @@ namespace Dyne
 
 		void bind(VkCommandBuffer commandBuffer);
 
-		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
-
-	private:
+		//Vertex input is taken from vertexFormat's layout, the vertex shader has to match getVertexFormatInfo(vertexFormat).vertexShader
+		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo, VertexFormat vertexFormat = VertexFormat::Full);
 		static std::vector<char> readFile(const std::string& filepath);
 
+	private:
 		void createGraphicsPipeline(
-			const std::string& vertPath, 
-			const std::string& fragPath,
+			const std::vector<char>& vertCode,
+			const std::vector<char>& fragCode,
 			const PipelineConfigInfo& configInfo);
 
 		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
@@ -57,4 +64,30 @@ namespace Dyne
 		VkShaderModule vertShaderModule;
 		VkShaderModule fragShaderModule;
 	};
+
+	class DyneComputePipeline
+	{
+	public:
+		DyneComputePipeline(
+			DyneDevice& device,
+			const std::string& compPath,
+			VkPipelineLayout pipelineLayout);
+		DyneComputePipeline(
+			DyneDevice& device,
+			const std::vector<char>& compCode,
+			VkPipelineLayout pipelineLayout);
+		~DyneComputePipeline();
+
+		DyneComputePipeline(const DyneComputePipeline&) = delete;
+		DyneComputePipeline& operator=(const DyneComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+
+	private:
+		void createComputePipeline(const std::vector<char>& compCode, VkPipelineLayout pipelineLayout);
+
+		DyneDevice& _deviceRef;
+		VkPipeline computePipeline;
+		VkShaderModule compShaderModule;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "DynePipelineCompiler.hpp"
+
+#include <exception>
+
+namespace Dyne
+{
+	DynePipelineCompiler::DynePipelineCompiler(DyneDevice& device, DyneThreadPool& threadPool) :
+		_deviceRef(device),
+		_threadPoolRef(threadPool)
+	{
+	}
+
+	DynePipelineCompiler::~DynePipelineCompiler()
+	{
+		//Jobs still reference the shader code map
+		_threadPoolRef.waitIdle();
+	}
+
+	std::shared_ptr<const std::vector<char>> DynePipelineCompiler::loadShaderCode(const std::string& filepath)
+	{
+		{
+			std::lock_guard<std::mutex> lock(shaderCodeMutex);
+			auto it = shaderCode.find(filepath);
+			if (it != shaderCode.end()) return it->second;
+		}
+
+		//Read outside the lock, two threads racing on the same file both read it once
+		auto code = std::make_shared<const std::vector<char>>(DynePipeline::readFile(filepath));
+
+		std::lock_guard<std::mutex> lock(shaderCodeMutex);
+		return shaderCode.emplace(filepath, std::move(code)).first->second;
+	}
+
+	DynePipelineFuture<DynePipeline> DynePipelineCompiler::compileGraphics(
+		const std::string& vertPath,
+		const std::string& fragPath,
+		const PipelineConfigInfo& configInfo)
+	{
+		auto promise = std::make_shared<std::promise<std::shared_ptr<DynePipeline>>>();
+		DynePipelineFuture<DynePipeline> future = promise->get_future().share();
+
+		_threadPoolRef.submit([this, promise, vertPath, fragPath, configInfo]()
+		{
+			try
+			{
+				auto vertCode = loadShaderCode(vertPath);
+				auto fragCode = loadShaderCode(fragPath);
+				promise->set_value(std::make_shared<DynePipeline>(_deviceRef, *vertCode, *fragCode, configInfo));
+			}
+			catch (...)
+			{
+				promise->set_exception(std::current_exception());
+			}
+		});
+
+		return future;
+	}
+
+	DynePipelineFuture<DyneComputePipeline> DynePipelineCompiler::compileCompute(
+		const std::string& compPath,
+		VkPipelineLayout pipelineLayout)
+	{
+		auto promise = std::make_shared<std::promise<std::shared_ptr<DyneComputePipeline>>>();
+		DynePipelineFuture<DyneComputePipeline> future = promise->get_future().share();
+
+		_threadPoolRef.submit([this, promise, compPath, pipelineLayout]()
+		{
+			try
+			{
+				auto compCode = loadShaderCode(compPath);
+				promise->set_value(std::make_shared<DyneComputePipeline>(_deviceRef, *compCode, pipelineLayout));
+			}
+			catch (...)
+			{
+				promise->set_exception(std::current_exception());
+			}
+		});
+
+		return future;
+	}
+}
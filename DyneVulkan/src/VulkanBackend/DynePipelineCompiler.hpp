@@ -0,0 +1,82 @@
+#pragma once
+
+#include "DyneDevice.hpp"
+#include "DynePipeline.hpp"
+#include "../Utility/DyneThreadPool.hpp"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Dyne
+{
+	template<typename PipelineT>
+	using DynePipelineFuture = std::shared_future<std::shared_ptr<PipelineT>>;
+
+	// Builds pipelines on the thread pool, all through the device's pipeline cache.
+	// SPIR-V is read from disk once per path and shared by every pipeline that uses it.
+	class DynePipelineCompiler
+	{
+	public:
+		DynePipelineCompiler(DyneDevice& device, DyneThreadPool& threadPool);
+		~DynePipelineCompiler();
+
+		DynePipelineCompiler(const DynePipelineCompiler&) = delete;
+		DynePipelineCompiler& operator=(const DynePipelineCompiler&) = delete;
+
+		// configInfo is copied, the layout & render pass must outlive the compile
+		DynePipelineFuture<DynePipeline> compileGraphics(
+			const std::string& vertPath,
+			const std::string& fragPath,
+			const PipelineConfigInfo& configInfo);
+		DynePipelineFuture<DyneComputePipeline> compileCompute(
+			const std::string& compPath,
+			VkPipelineLayout pipelineLayout);
+
+	private:
+		std::shared_ptr<const std::vector<char>> loadShaderCode(const std::string& filepath);
+
+		DyneDevice& _deviceRef;
+		DyneThreadPool& _threadPoolRef;
+
+		std::mutex shaderCodeMutex;
+		std::unordered_map<std::string, std::shared_ptr<const std::vector<char>>> shaderCode;
+	};
+
+	// Wraps a compile future for use while recording: get() never blocks and returns nullptr
+	// until the pipeline is ready, so callers can fall back or skip the draw
+	template<typename PipelineT>
+	class DynePendingPipeline
+	{
+	public:
+		DynePendingPipeline() = default;
+		explicit DynePendingPipeline(DynePipelineFuture<PipelineT> future) : future{ std::move(future) } {}
+
+		// Rethrows the compile error, if there was one
+		PipelineT* get()
+		{
+			if (pipeline == nullptr && future.valid() &&
+				future.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			{
+				pipeline = future.get();
+			}
+			return pipeline.get();
+		}
+
+		bool isReady() { return get() != nullptr; }
+
+		// Blocks until the compile finished either way, owners call this before destroying the layout
+		void wait() const
+		{
+			if (future.valid()) future.wait();
+		}
+
+	private:
+		DynePipelineFuture<PipelineT> future;
+		std::shared_ptr<PipelineT> pipeline;
+	};
+}
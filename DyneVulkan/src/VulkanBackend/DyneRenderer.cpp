@@ -7,10 +7,11 @@
 namespace Dyne
 {
 
-	DyneRenderer::DyneRenderer(WindowHandler& window, DyneDevice& device) : _windowRef(window), _deviceRef(device)
+	DyneRenderer::DyneRenderer(WindowHandler& window, DyneDevice& device, DyneThreadPool& threadPool) : _windowRef(window), _deviceRef(device)
 	{
 		recreateSwapchain();
 		createCommandBuffers();
+		commandRecorder = std::make_unique<DyneCommandRecorder>(device, threadPool, DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
 	}
 
 	DyneRenderer::~DyneRenderer()
@@ -91,6 +92,13 @@ namespace Dyne
 
 		isFrameStarted = true;
 
+		//acquireNextImage waited for this frame's previous submission, its secondary buffers can be reset
+		commandRecorder->beginFrame(
+			currentFrameIndex,
+			swapChain->getRenderPass(),
+			swapChain->getFrameBuffer(currentImageIndex),
+			swapChain->getSwapChainExtent());
+
 		auto commandBuffer = getCurrentCommandBuffer();
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -127,7 +135,7 @@ namespace Dyne
 		currentFrameIndex = (currentFrameIndex + 1) % DyneSwapchain::MAX_FRAMES_IN_FLIGHT;
 	}
 
-	void DyneRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+	void DyneRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
 	{
 		assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress!");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
@@ -148,7 +156,10 @@ namespace Dyne
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+		//Secondary buffers set their own viewport & scissor, the primary may only execute them
+		if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) return;
 
 		VkViewport viewport{};
 		viewport.x = 0;
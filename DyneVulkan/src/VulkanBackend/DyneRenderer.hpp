@@ -3,6 +3,8 @@
 #include "../Window/WindowHandler.hpp"
 #include "DyneSwapchain.hpp"
 #include "DyneModel.hpp"
+#include "DyneCommandRecorder.hpp"
+#include "../Utility/DyneThreadPool.hpp"
 
 #include <cassert>
 #include <memory>
@@ -13,7 +15,7 @@ namespace Dyne
     class DyneRenderer
     {
     public:
-        DyneRenderer(WindowHandler& window, DyneDevice& device);
+        DyneRenderer(WindowHandler& window, DyneDevice& device, DyneThreadPool& threadPool);
         ~DyneRenderer();
 
         DyneRenderer(const DyneRenderer&) = delete;
@@ -21,6 +23,7 @@ namespace Dyne
 
         VkRenderPass getSwapChainRenderPass() const { return swapChain->getRenderPass(); };
         float getAspectRatio() const { return swapChain->extentAspectRatio(); };
+        VkExtent2D getSwapChainExtent() const { return swapChain->getSwapChainExtent(); };
         bool isFrameInProgress() const { return isFrameStarted; };
 
         VkCommandBuffer getCurrentCommandBuffer() const 
@@ -29,6 +32,9 @@ namespace Dyne
             return commandBuffers[currentFrameIndex]; 
         };
 
+        //Secondary command buffers recorded on worker threads, reset by beginFrame
+        DyneCommandRecorder& getCommandRecorder() { return *commandRecorder; }
+
         int getFrameIndex() const
         {
             assert(isFrameStarted && "Cannot get frame index when frame not in progress");
@@ -37,7 +43,8 @@ namespace Dyne
 
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        //With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS everything in the pass goes through the command recorder
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
     private:
@@ -50,6 +57,7 @@ namespace Dyne
         DyneDevice& _deviceRef;
         std::unique_ptr<DyneSwapchain> swapChain;
         std::vector<VkCommandBuffer> commandBuffers;
+        std::unique_ptr<DyneCommandRecorder> commandRecorder;
 
         uint32_t currentImageIndex;
         int currentFrameIndex = 0;
@@ -47,8 +47,7 @@ namespace Dyne {
 
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(_deviceRef.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(_deviceRef.device(), depthImages[i], nullptr);
-            vkFreeMemory(_deviceRef.device(), depthImageMemorys[i], nullptr);
+            _deviceRef.destroyImage(depthImages[i], depthImageAllocations[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers) {
@@ -307,7 +306,7 @@ namespace Dyne {
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
         depthImages.resize(imageCount());
-        depthImageMemorys.resize(imageCount());
+        depthImageAllocations.resize(imageCount());
         depthImageViews.resize(imageCount());
 
         for (int i = 0; i < depthImages.size(); i++) {
@@ -331,7 +330,7 @@ namespace Dyne {
                 imageInfo,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 depthImages[i],
-                depthImageMemorys[i]);
+                depthImageAllocations[i]);
 
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -3,22 +3,135 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 
 namespace Dyne
 {
+	namespace
+	{
+		//Levels are staged back to back, each starting on a texel block boundary
+		constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+		VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		float srgbToLinear(unsigned char value)
+		{
+			static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> result{};
+				for (int i = 0; i < 256; i++)
+				{
+					float c = i / 255.0f;
+					result[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				}
+				return result;
+			}();
+			return table[value];
+		}
+
+		unsigned char linearToSrgb(float value)
+		{
+			float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+			return static_cast<unsigned char>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+
+		//2x2 box filter of RGBA8 pixels. sRGB color is averaged in linear space like a blit of an sRGB image
+		void downsample(const unsigned char* src, uint32_t srcWidth, uint32_t srcHeight, unsigned char* dst, uint32_t dstWidth, uint32_t dstHeight, bool srgb)
+		{
+			for (uint32_t y = 0; y < dstHeight; y++)
+			{
+				uint32_t y0 = std::min(y * 2, srcHeight - 1);
+				uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+				for (uint32_t x = 0; x < dstWidth; x++)
+				{
+					uint32_t x0 = std::min(x * 2, srcWidth - 1);
+					uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+					const unsigned char* p00 = &src[(y0 * srcWidth + x0) * 4];
+					const unsigned char* p01 = &src[(y0 * srcWidth + x1) * 4];
+					const unsigned char* p10 = &src[(y1 * srcWidth + x0) * 4];
+					const unsigned char* p11 = &src[(y1 * srcWidth + x1) * 4];
+					unsigned char* out = &dst[(y * dstWidth + x) * 4];
+
+					for (int c = 0; c < 4; c++)
+					{
+						if (srgb && c < 3)
+						{
+							out[c] = linearToSrgb((srgbToLinear(p00[c]) + srgbToLinear(p01[c]) + srgbToLinear(p10[c]) + srgbToLinear(p11[c])) * 0.25f);
+						}
+						else
+						{
+							out[c] = static_cast<unsigned char>((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+						}
+					}
+				}
+			}
+		}
+	}
+
 	DyneTexture::DyneTexture(DyneDevice& device, const DyneTexture::Builder& builder) : _deviceRef(device)
 	{
 		textureImage = builder.bTextureImage;
-		textureImageMemory = builder.bTextureImageMemory;
-		textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB);
+		textureImageAllocation = builder.bTextureImageAllocation;
+		textureUploadTicket = builder.bUploadTicket;
+		VkExtent3D baseExtent = builder.levelExtent(builder.bMinLod);
+		textureWidth = baseExtent.width;
+		textureHeight = baseExtent.height;
+		textureMipLevels = builder.imageLevelCount();
+		textureMinLod = builder.bMinLod;
+		sourceTextureWidth = builder.bWidth;
+		sourceTextureHeight = builder.bHeight;
+		pendingMips = builder.bPendingMips;
+		textureFormat = builder.bFormat;
+		textureImageView = createImageView(textureImage, textureFormat, textureMipLevels);
 	}
 
 	DyneTexture::~DyneTexture()
 	{
 		vkDestroyImageView(_deviceRef.device(), textureImageView, nullptr);
-		vkDestroyImage(_deviceRef.device(), textureImage, nullptr);
-		vkFreeMemory(_deviceRef.device(), textureImageMemory, nullptr);
+		_deviceRef.destroyImage(textureImage, textureImageAllocation);
+	}
+
+	uint32_t DyneTexture::fullMipLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+		{
+			levels++;
+		}
+		return levels;
+	}
+
+	bool DyneTexture::supportsLinearBlit(DyneDevice& device, VkFormat format)
+	{
+		VkFormatFeatureFlags required = 
+			VK_FORMAT_FEATURE_BLIT_SRC_BIT | 
+			VK_FORMAT_FEATURE_BLIT_DST_BIT | 
+			VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		return (device.getFormatProperties(format).optimalTilingFeatures & required) == required;
+	}
+
+	bool DyneTexture::supportsSampling(DyneDevice& device, VkFormat format)
+	{
+		if (isBlockCompressedFormat(format) && !device.supportsBcTextures()) return false;
+
+		VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		return (device.getFormatProperties(format).optimalTilingFeatures & required) == required;
+	}
+
+	void DyneTexture::generatePendingMips(DyneUploadContext& uploadContext)
+	{
+		assert(pendingMips && "Texture has no pending mips!");
+		uploadContext.generateMipmaps(textureImage, { textureWidth, textureHeight }, textureMipLevels);
+		pendingMips = false;
 	}
 
 	std::unique_ptr<DyneTexture> DyneTexture::createTextureFromFile(
@@ -30,111 +143,325 @@ namespace Dyne
 		return std::make_unique<DyneTexture>(device, builder);
 	}
 
-	void DyneTexture::Builder::createTextureImage(
+	std::unique_ptr<DyneTexture> DyneTexture::createTextureFromPixels(
 		DyneDevice& device,
-		const std::string& filepath)
+		const void* rgbaPixels,
+		uint32_t width,
+		uint32_t height)
+	{
+		size_t size = static_cast<size_t>(width) * height * 4;
+
+		Builder builder{};
+		builder.bPixels = std::shared_ptr<unsigned char>(new unsigned char[size], std::default_delete<unsigned char[]>());
+		std::memcpy(builder.bPixels.get(), rgbaPixels, size);
+		builder.bWidth = width;
+		builder.bHeight = height;
+		builder.createTextureImage(device, device.uploadContext(), device.graphicsQueueFamily());
+		builder.bUploadTicket = device.uploadContext().submit();
+		return std::make_unique<DyneTexture>(device, builder);
+	}
+
+	void DyneTexture::Builder::probe(DyneDevice& device, const std::string& filepath)
+	{
+		bPixels.reset();
+		bMipPixels.clear();
+		bMinLod = 0;
+
+		std::filesystem::path sourcePath{ filepath };
+		std::filesystem::path cookedPath = std::filesystem::path{ filepath }.replace_extension(".ktx2");
+
+		std::error_code error;
+		if (std::filesystem::exists(cookedPath, error))
+		{
+			//A source edited after cooking wins over the stale cooked file
+			bool cookedIsCurrent = sourcePath == cookedPath || !std::filesystem::exists(sourcePath, error) ||
+				std::filesystem::last_write_time(cookedPath, error) >= std::filesystem::last_write_time(sourcePath, error);
+			if (cookedIsCurrent)
+			{
+				Ktx2Header header = readKtx2Header(cookedPath.string());
+				if (supportsSampling(device, header.format))
+				{
+					bFilepath = cookedPath.string();
+					bWidth = header.width;
+					bHeight = header.height;
+					bFormat = header.format;
+					bMipLevels = static_cast<uint32_t>(header.levelOffsets.size());
+					bBlitMips = false;
+					return;
+				}
+				if (sourcePath == cookedPath)
+				{
+					throw std::runtime_error("failed to load texture, its format isn't supported by the device!");
+				}
+			}
+		}
+
+		//Fall back to decoding the source
+		int texWidth, texHeight, texChannels;
+		if (!stbi_info(filepath.c_str(), &texWidth, &texHeight, &texChannels))
+		{
+			throw std::runtime_error("failed to load texture image!");
+		}
+
+		bFilepath = filepath;
+		bWidth = static_cast<uint32_t>(texWidth);
+		bHeight = static_cast<uint32_t>(texHeight);
+		bFormat = FORMAT;
+		bMipLevels = fullMipLevelCount(bWidth, bHeight);
+		bBlitMips = supportsLinearBlit(device, FORMAT);
+	}
+
+	void DyneTexture::Builder::decodeInto(void* staging) const
+	{
+		assert(!bFilepath.empty() && "Texture must be probed before decoding!");
+
+		//Levels of the whole chain, null above bMinLod and below the staged ones
+		std::vector<unsigned char*> levels(bMipLevels, nullptr);
+		uint32_t endLevel = bMinLod + stagedLevelCount();
+		VkDeviceSize offset = 0;
+		for (uint32_t level = bMinLod; level < endLevel; level++)
+		{
+			levels[level] = static_cast<unsigned char*>(staging) + offset;
+			VkExtent3D extent = levelExtent(level);
+			offset += alignUp(getImageLevelSize(bFormat, extent.width, extent.height), STAGING_ALIGNMENT);
+		}
+
+		if (std::filesystem::path{ bFilepath }.extension() == ".ktx2")
+		{
+			Ktx2Header header = readKtx2Header(bFilepath);
+			if (header.format != bFormat || header.width != bWidth || header.height != bHeight || header.levelOffsets.size() != bMipLevels)
+			{
+				throw std::runtime_error("failed to load texture, the file changed since it was probed!");
+			}
+			std::vector<void*> destinations(levels.begin(), levels.end());
+			readKtx2Levels(bFilepath, header, destinations.data());
+			return;
+		}
+
+		//stb_image always decodes into its own buffer, from there it is the only copy into staging
+		int texWidth, texHeight, texChannels;
+		std::unique_ptr<stbi_uc, void (*)(void*)> pixels{ stbi_load(bFilepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha), stbi_image_free };
+		if (!pixels)
+		{
+			throw std::runtime_error("failed to load texture image!");
+		}
+		if (static_cast<uint32_t>(texWidth) != bWidth || static_cast<uint32_t>(texHeight) != bHeight)
+		{
+			throw std::runtime_error("failed to load texture, the file changed since it was probed!");
+		}
+		if (levels[0] != nullptr)
+		{
+			std::memcpy(levels[0], pixels.get(), static_cast<size_t>(bWidth) * bHeight * 4);
+		}
+
+		//Staging memory may be write combined and slow to read, so the chain is filtered from scratch copies.
+		//Levels above bMinLod are still filtered, a source image holds no smaller ones
+		std::vector<unsigned char> previous;
+		std::vector<unsigned char> current;
+		const unsigned char* src = pixels.get();
+		for (uint32_t level = 1; level < endLevel; level++)
+		{
+			VkExtent3D srcExtent = levelExtent(level - 1);
+			VkExtent3D extent = levelExtent(level);
+			current.resize(static_cast<size_t>(extent.width) * extent.height * 4);
+			downsample(src, srcExtent.width, srcExtent.height, current.data(), extent.width, extent.height, true);
+			if (levels[level] != nullptr)
+			{
+				std::memcpy(levels[level], current.data(), current.size());
+			}
+
+			std::swap(previous, current);
+			src = previous.data();
+		}
+	}
+
+	void DyneTexture::Builder::loadPixels(const std::string& filepath)
 	{
 		int texWidth, texHeight, texChannels;
 		stbi_uc* pixels = stbi_load(filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-		uint32_t imageSize = texWidth * texHeight;
 
 		if (!pixels) {
 			throw std::runtime_error("failed to load texture image!");
 		}
 
-		DyneBuffer stagingBuffer
+		bPixels = std::shared_ptr<unsigned char>(pixels, stbi_image_free);
+		bWidth = static_cast<uint32_t>(texWidth);
+		bHeight = static_cast<uint32_t>(texHeight);
+		bFormat = FORMAT;
+		bMipPixels.clear();
+	}
+
+	void DyneTexture::Builder::generateMips(bool srgb)
+	{
+		assert(bPixels != nullptr && "Texture pixels must be loaded before generating mips!");
+		assert(!isBlockCompressedFormat(bFormat) && "Block compressed textures can't be filtered!");
+
+		bMipPixels.clear();
+		uint32_t levels = fullMipLevelCount(bWidth, bHeight);
+		const unsigned char* src = bPixels.get();
+		uint32_t width = bWidth;
+		uint32_t height = bHeight;
+		for (uint32_t level = 1; level < levels; level++)
+		{
+			uint32_t levelWidth = std::max(width / 2, 1u);
+			uint32_t levelHeight = std::max(height / 2, 1u);
+
+			bMipPixels.emplace_back(static_cast<size_t>(levelWidth) * levelHeight * 4);
+			downsample(src, width, height, bMipPixels.back().data(), levelWidth, levelHeight, srgb);
+
+			src = bMipPixels.back().data();
+			width = levelWidth;
+			height = levelHeight;
+		}
+	}
+
+	VkExtent3D DyneTexture::Builder::levelExtent(uint32_t level) const
+	{
+		return { std::max(bWidth >> level, 1u), std::max(bHeight >> level, 1u), 1 };
+	}
+
+	void DyneTexture::Builder::limitExtent(uint32_t maxExtent)
+	{
+		assert(!bFilepath.empty() && "Texture must be probed before limiting its extent!");
+
+		bMinLod = 0;
+		if (maxExtent == 0) return;
+
+		while (bMinLod + 1 < bMipLevels)
+		{
+			VkExtent3D extent = levelExtent(bMinLod);
+			if (std::max(extent.width, extent.height) <= maxExtent) break;
+			bMinLod++;
+		}
+	}
+
+	VkDeviceSize DyneTexture::Builder::uploadSize() const
+	{
+		VkDeviceSize size = 0;
+		for (uint32_t level = bMinLod; level < bMinLod + stagedLevelCount(); level++)
 		{
-			device,
-			4,
-			imageSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
+			VkExtent3D extent = levelExtent(level);
+			size += alignUp(getImageLevelSize(bFormat, extent.width, extent.height), STAGING_ALIGNMENT);
+		}
+		return size;
+	}
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer(pixels);
+	void DyneTexture::Builder::createTextureImage(
+		DyneDevice& device,
+		const std::string& filepath)
+	{
+		probe(device, filepath);
 
-		stbi_image_free(pixels);
+		DyneUploadContext& uploadContext = device.uploadContext();
+		DyneUploadContext::StagingRegion staging = uploadContext.allocateStaging(uploadSize(), STAGING_ALIGNMENT);
+		decodeInto(staging.data);
+		createTextureImage(device, uploadContext, device.graphicsQueueFamily(), staging);
+		this->bUploadTicket = uploadContext.submit();
+	}
+
+	void DyneTexture::Builder::createTextureImage(
+		DyneDevice& device,
+		DyneUploadContext& uploadContext,
+		uint32_t ownerQueueFamily)
+	{
+		assert(bPixels != nullptr && "Texture pixels must be loaded before creating the image!");
+		assert(bMinLod == 0 && "Only probed textures can start below their first level!");
+
+		//Formats the GPU can't filter get their chain from the CPU, block compressed ones ship with theirs
+		bool compressed = isBlockCompressedFormat(bFormat);
+		bBlitMips = !compressed && bMipPixels.empty() && supportsLinearBlit(device, bFormat);
+		if (!compressed && bMipPixels.empty() && !bBlitMips)
+		{
+			generateMips(bFormat == FORMAT);
+		}
+		bMipLevels = bBlitMips ? fullMipLevelCount(bWidth, bHeight) : 1 + static_cast<uint32_t>(bMipPixels.size());
+
+		DyneUploadContext::StagingRegion staging = uploadContext.allocateStaging(uploadSize(), STAGING_ALIGNMENT);
+		unsigned char* dst = static_cast<unsigned char*>(staging.data);
+		for (uint32_t level = 0; level < stagedLevelCount(); level++)
+		{
+			VkExtent3D extent = levelExtent(level);
+			VkDeviceSize size = getImageLevelSize(bFormat, extent.width, extent.height);
+			const unsigned char* src = level == 0 ? bPixels.get() : bMipPixels[level - 1].data();
+			assert((level == 0 || bMipPixels[level - 1].size() == size) && "Mip level size doesn't match its extent!");
+
+			std::memcpy(dst, src, static_cast<size_t>(size));
+			dst += alignUp(size, STAGING_ALIGNMENT);
+		}
+		createTextureImage(device, uploadContext, ownerQueueFamily, staging);
+
+		//The pixels were copied into staging
+		bPixels.reset();
+		bMipPixels.clear();
+	}
+
+	void DyneTexture::Builder::createTextureImage(
+		DyneDevice& device,
+		DyneUploadContext& uploadContext,
+		uint32_t ownerQueueFamily,
+		const DyneUploadContext::StagingRegion& staging)
+	{
+		assert(bMipLevels <= fullMipLevelCount(bWidth, bHeight) && "More mip levels than the texture size allows!");
+		assert(bMinLod < bMipLevels && "Texture starts below its last level!");
+
+		//The image's level 0 is level bMinLod of the file
+		VkExtent3D baseExtent = levelExtent(bMinLod);
+		uint32_t imageLevels = imageLevelCount();
 
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		imageInfo.imageType = VK_IMAGE_TYPE_2D;
-		imageInfo.extent.width = static_cast<uint32_t>(texWidth);
-		imageInfo.extent.height = static_cast<uint32_t>(texHeight);
-		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
+		imageInfo.extent = baseExtent;
+		imageInfo.mipLevels = imageLevels;
 		imageInfo.arrayLayers = 1;
-		imageInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+		imageInfo.format = bFormat;
 		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		if (bBlitMips)
+		{
+			imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		}
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.flags = 0; // Optional
 
-		device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, this->bTextureImage, this->bTextureImageMemory);
-
-		transitionImageLayout(device, this->bTextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		device.copyBufferToImage(stagingBuffer.getBuffer(), this->bTextureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), static_cast<uint32_t>(1));
-		transitionImageLayout(device, this->bTextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, this->bTextureImage, this->bTextureImageAllocation);
 
 		if (!this->bTextureImage)
 		{
 			throw std::runtime_error("failed to create texture!");
 		}
-	}
-
-	void DyneTexture::transitionImageLayout(DyneDevice& device, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
-	{
-		VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
 
-		VkPipelineStageFlags sourceStage;
-		VkPipelineStageFlags destinationStage;
+		//Transitions and the copies go out as one batch, the GPU orders it before any later frame
+		uploadContext.transitionImageLayout(this->bTextureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, imageLevels);
 
-		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		VkDeviceSize offset = staging.offset;
+		for (uint32_t level = 0; level < stagedLevelCount(); level++)
+		{
+			VkExtent3D extent = levelExtent(bMinLod + level);
+			uploadContext.copyBufferToImage(staging.buffer, offset, this->bTextureImage, extent, level);
+			offset += alignUp(getImageLevelSize(bFormat, extent.width, extent.height), STAGING_ALIGNMENT);
 		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		//Blits need a graphics queue, a transfer queue leaves them to the owner
+		bPendingMips = false;
+		if (bBlitMips && uploadContext.isGraphicsCapable() && ownerQueueFamily == uploadContext.getQueueFamilyIndex())
+		{
+			uploadContext.generateMipmaps(this->bTextureImage, { baseExtent.width, baseExtent.height }, imageLevels);
+		}
+		else if (bBlitMips)
+		{
+			uploadContext.releaseImageOwnership(this->bTextureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, ownerQueueFamily, imageLevels);
+			bPendingMips = true;
 		}
-		else {
-			throw std::invalid_argument("unsupported layout transition!");
+		else
+		{
+			uploadContext.releaseImageOwnership(this->bTextureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, ownerQueueFamily, imageLevels);
 		}
-
-		vkCmdPipelineBarrier(
-			commandBuffer,
-			sourceStage, destinationStage,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier
-		);
-
-		device.endSingleTimeCommands(commandBuffer);
 	}
 
-	VkImageView DyneTexture::createImageView(VkImage image, VkFormat format) {
+	VkImageView DyneTexture::createImageView(VkImage image, VkFormat format, uint32_t levelCount) {
 		VkImageViewCreateInfo viewInfo{};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		viewInfo.image = image;
@@ -142,7 +469,7 @@ namespace Dyne
 		viewInfo.format = format;
 		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = levelCount;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 
@@ -169,6 +496,9 @@ namespace Dyne
 		samplerInfo.compareEnable = VK_FALSE;
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 
 		if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create texture sampler!");
@@ -2,6 +2,8 @@
 
 #include "DyneDevice.hpp"
 #include "DyneBuffer.hpp"
+#include "DyneUploadContext.hpp"
+#include "DyneKtx2.hpp"
 
 #include <memory>
 #include <vector>
@@ -11,22 +13,106 @@ namespace Dyne
 	class DyneTexture
 	{
 	public:
+		static constexpr VkFormat FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+		//Levels of a full chain down to 1x1
+		static uint32_t fullMipLevelCount(uint32_t width, uint32_t height);
+		//Whether mips of format can be generated by linearly filtered blits, otherwise they are filtered on the CPU
+		static bool supportsLinearBlit(DyneDevice& device, VkFormat format);
+		//Whether images of format can be created and sampled with linear filtering
+		static bool supportsSampling(DyneDevice& device, VkFormat format);
+
 		static std::unique_ptr<DyneTexture> createTextureFromFile
 		(
 			DyneDevice& device,
 			const std::string& filepath
 		);
 
+		//Tightly packed RGBA8 pixels, copied into staging
+		static std::unique_ptr<DyneTexture> createTextureFromPixels
+		(
+			DyneDevice& device,
+			const void* rgbaPixels,
+			uint32_t width,
+			uint32_t height
+		);
+
 		struct Builder
 		{
+			//Picks the cooked <name>.ktx2 next to filepath when the device can sample it and it is up to date,
+			//otherwise filepath itself. Only the header is read, so staging can be reserved before decoding.
+			//Safe to call from worker threads
+			void probe(DyneDevice& device, const std::string& filepath);
+			//Decodes the probed file straight into uploadSize() bytes of staging memory, levels laid out as
+			//createTextureImage expects them. Filters the mips here if the GPU can't. Safe on worker threads
+			void decodeInto(void* staging) const;
+
+			//Decodes the file into bPixels on the CPU only, safe to call from worker threads
+			void loadPixels(const std::string& filepath);
+			//Fills bMipPixels with the full chain on the CPU, for formats the GPU can't blit. Safe on worker threads.
+			//Data that isn't color, like normal maps, is averaged as is rather than in linear space
+			void generateMips(bool srgb = true);
+			//Staging bytes of every level that is uploaded, known once the file is probed or pixels are planned
+			VkDeviceSize uploadSize() const;
+			//Starts the image at the first level no larger than maxExtent on either side, the levels above stay on
+			//disk. 0 keeps the full chain. Call after probe(), before reserving staging
+			void limitExtent(uint32_t maxExtent);
+
+			//Probes, decodes and uploads filepath on the device's own context and submits it
 			void createTextureImage
 			(
 				DyneDevice& device,
 				const std::string& filepath
 			);
 
+			//Records the upload of bPixels & bMipPixels into uploadContext and hands the image over to
+			//ownerQueueFamily, which has to acquire it once the batch completes. Submitting is left to the caller.
+			//Missing mips are blitted right away on a graphics capable context that keeps the image, otherwise the
+			//image is handed over in TRANSFER_DST_OPTIMAL and the owner has to run generatePendingMips()
+			void createTextureImage
+			(
+				DyneDevice& device,
+				DyneUploadContext& uploadContext,
+				uint32_t ownerQueueFamily
+			);
+
+			//Same for a probed file, copying from staging that decodeInto() fills. The copies may be recorded
+			//before the staging is written, the batch just must not be submitted until then
+			void createTextureImage
+			(
+				DyneDevice& device,
+				DyneUploadContext& uploadContext,
+				uint32_t ownerQueueFamily,
+				const DyneUploadContext::StagingRegion& staging
+			);
+
+			std::shared_ptr<unsigned char> bPixels;
+			uint32_t bWidth = 0;
+			uint32_t bHeight = 0;
+			//FORMAT for decoded images, block compressed ones come with their whole chain
+			VkFormat bFormat = FORMAT;
+			//Optional levels below the base, as cooked assets ship them. Tightly packed in bFormat, each level half
+			//the size of the one above rounded down. Without them the full chain is generated
+			std::vector<std::vector<unsigned char>> bMipPixels;
+			//The file probe() picked
+			std::string bFilepath;
+
+			//Levels of the whole chain, including the ones above bMinLod
+			uint32_t bMipLevels = 1;
+			//Level of the file the image starts at, only probed files can skip levels
+			uint32_t bMinLod = 0;
+			//Levels below the base are blitted from it on the GPU instead of being uploaded
+			bool bBlitMips = false;
+			bool bPendingMips = false;
+
 			VkImage bTextureImage;
-			VkDeviceMemory bTextureImageMemory;
+			DyneAllocation bTextureImageAllocation;
+			DyneUploadTicket bUploadTicket = 0;
+
+			uint32_t imageLevelCount() const { return bMipLevels - bMinLod; }
+			uint32_t stagedLevelCount() const { return bBlitMips ? 1 : imageLevelCount(); }
+			//Extent of a level of the whole chain, level 0 being the file's largest
+			VkExtent3D levelExtent(uint32_t level) const;
 		};
 
 		DyneTexture(DyneDevice& device, const DyneTexture::Builder& builder);
@@ -37,18 +123,41 @@ namespace Dyne
 
 		VkImage image() { return textureImage; }
 		VkImageView imageView() { return textureImageView; }
+		DyneUploadTicket uploadTicket() const { return textureUploadTicket; }
+		//Size and levels of the image itself, which starts at minLod() of its file
+		uint32_t width() const { return textureWidth; }
+		uint32_t height() const { return textureHeight; }
+		uint32_t mipLevels() const { return textureMipLevels; }
+		//Level of the file the image's base level holds, the ones above it aren't resident
+		uint32_t minLod() const { return textureMinLod; }
+		uint32_t sourceWidth() const { return sourceTextureWidth; }
+		uint32_t sourceHeight() const { return sourceTextureHeight; }
+		uint32_t sourceMipLevels() const { return textureMinLod + textureMipLevels; }
+		VkFormat format() const { return textureFormat; }
+
+		//Levels below the base still have to be blitted by the queue family that acquires the image
+		bool hasPendingMips() const { return pendingMips; }
+		//Records the blits into a graphics capable context owning the image in TRANSFER_DST_OPTIMAL
+		void generatePendingMips(DyneUploadContext& uploadContext);
 
 		static void createTextureSampler(DyneDevice& device, VkSampler& sampler);
 
 	private:
-		static void transitionImageLayout(DyneDevice& device, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-
-		VkImageView createImageView(VkImage image, VkFormat format);
+		VkImageView createImageView(VkImage image, VkFormat format, uint32_t levelCount);
 
 		DyneDevice& _deviceRef;
 		VkImage textureImage;
-		VkDeviceMemory textureImageMemory;
+		DyneAllocation textureImageAllocation;
+		DyneUploadTicket textureUploadTicket = 0;
 		VkImageView textureImageView;
+		uint32_t textureWidth;
+		uint32_t textureHeight;
+		uint32_t textureMipLevels;
+		uint32_t textureMinLod;
+		uint32_t sourceTextureWidth;
+		uint32_t sourceTextureHeight;
+		VkFormat textureFormat;
+		bool pendingMips;
 	};
 }
 
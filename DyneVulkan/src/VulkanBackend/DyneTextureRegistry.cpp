@@ -0,0 +1,145 @@
+#include "DyneTextureRegistry.hpp"
+#include "DyneSwapchain.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Dyne
+{
+	DyneTextureRegistry::DyneTextureRegistry(DyneDevice& device, VkSampler sampler, std::shared_ptr<DyneTexture> defaultTexture)
+		: _deviceRef(device), textureSampler(sampler), defaultTexture(std::move(defaultTexture))
+	{
+		assert(this->defaultTexture != nullptr && "Texture registry needs a default texture!");
+
+		bindless = device.supportsBindlessTextures();
+		capacity = bindless ? std::min(MAX_BINDLESS_TEXTURES, device.maxBindlessTextures()) : FIXED_TEXTURE_CAPACITY;
+
+		//Slots are only written once used and may change while a frame that doesn't sample them is recorded
+		pool = DyneDescriptorPool::Builder(_deviceRef)
+			.setMaxSets(DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity * DyneSwapchain::MAX_FRAMES_IN_FLIGHT)
+			.setPoolFlags(bindless ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT : 0)
+			.build();
+
+		setLayout = DyneDescriptorSetLayout::Builder(_deviceRef)
+			.addBinding(
+				0,
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				VK_SHADER_STAGE_FRAGMENT_BIT,
+				capacity,
+				bindless ? VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT : 0)
+			.setLayoutFlags(bindless ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT : 0)
+			.build();
+
+		frameTables.resize(DyneSwapchain::MAX_FRAMES_IN_FLIGHT);
+		for (FrameTable& table : frameTables)
+		{
+			if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), table.descriptorSet))
+			{
+				throw std::runtime_error("failed to allocate texture table!");
+			}
+			table.written.resize(capacity);
+		}
+
+		textures.push_back(this->defaultTexture);
+
+		//Without partial binding every slot must hold a valid descriptor, free ones show the default texture
+		uint32_t initialSlots = bindless ? 1 : capacity;
+		for (uint32_t slot = 0; slot < initialSlots; slot++)
+		{
+			markDirty(slot);
+		}
+		for (int frameIndex = 0; frameIndex < frameTables.size(); frameIndex++)
+		{
+			flush(frameIndex);
+		}
+	}
+
+	uint32_t DyneTextureRegistry::add(std::shared_ptr<DyneTexture> texture)
+	{
+		assert(texture != nullptr && "Cannot add an empty texture!");
+
+		uint32_t index;
+		if (!freeSlots.empty())
+		{
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else if (textures.size() < capacity)
+		{
+			index = static_cast<uint32_t>(textures.size());
+			textures.emplace_back();
+		}
+		else
+		{
+			throw std::runtime_error("failed to add texture, the texture table is full!");
+		}
+
+		textures[index] = std::move(texture);
+		markDirty(index);
+		return index;
+	}
+
+	void DyneTextureRegistry::replace(uint32_t index, std::shared_ptr<DyneTexture> texture)
+	{
+		assert(index < textures.size() && textures[index] != nullptr && "Replacing a free texture slot!");
+		assert(texture != nullptr && "Cannot replace with an empty texture, remove the slot instead!");
+
+		textures[index] = std::move(texture);
+		markDirty(index);
+	}
+
+	void DyneTextureRegistry::remove(uint32_t index)
+	{
+		assert(index != DEFAULT_TEXTURE && "The default texture cannot be removed!");
+		assert(index < textures.size() && textures[index] != nullptr && "Removing a free texture slot!");
+
+		textures[index].reset();
+		freeSlots.push_back(index);
+		markDirty(index);
+	}
+
+	void DyneTextureRegistry::markDirty(uint32_t index)
+	{
+		for (FrameTable& table : frameTables)
+		{
+			table.dirtySlots.push_back(index);
+		}
+	}
+
+	VkDescriptorSet DyneTextureRegistry::flush(int frameIndex)
+	{
+		FrameTable& table = frameTables[frameIndex];
+		if (table.dirtySlots.empty()) return table.descriptorSet;
+
+		//Stable until the writer is done with them
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		imageInfos.reserve(table.dirtySlots.size());
+
+		DyneDescriptorWriter writer(*setLayout, *pool);
+		for (uint32_t slot : table.dirtySlots)
+		{
+			//Freed slots are pointed back at the default texture, which releases the old one once no copy holds it
+			const std::shared_ptr<DyneTexture>& texture =
+				slot < textures.size() && textures[slot] != nullptr ? textures[slot] : defaultTexture;
+			if (table.written[slot] == texture) continue;
+
+			VkDescriptorImageInfo imageInfo{};
+			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageInfo.imageView = texture->imageView();
+			imageInfo.sampler = textureSampler;
+			imageInfos.push_back(imageInfo);
+			writer.writeImage(0, slot, &imageInfos.back());
+
+			table.written[slot] = texture;
+		}
+		table.dirtySlots.clear();
+
+		if (!imageInfos.empty())
+		{
+			writer.overwrite(table.descriptorSet);
+		}
+		return table.descriptorSet;
+	}
+}
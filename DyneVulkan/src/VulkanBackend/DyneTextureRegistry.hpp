@@ -0,0 +1,81 @@
+#pragma once
+
+#include "DyneDevice.hpp"
+#include "DyneDescriptors.hpp"
+#include "DyneTexture.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace Dyne
+{
+	//Table of every texture the scene samples, bound once per frame as set 2. Objects pick theirs by the index in
+	//their instance data, so changing an object's texture changes no descriptor set and objects with different
+	//textures still draw in one instanced call.
+	//With descriptor indexing the table is a large, partially bound, update after bind array. Without it the table
+	//shrinks to FIXED_TEXTURE_CAPACITY slots and the index must stay the same across a draw.
+	//Every frame in flight has its own copy of the table, changes reach it in flush() once that frame's fence passed,
+	//so slots can be reassigned at any time without touching descriptors the GPU may still read.
+	class DyneTextureRegistry
+	{
+	public:
+		//Slot of the default texture, sampled by objects that have none of their own
+		static constexpr uint32_t DEFAULT_TEXTURE = 0;
+		//Table size with descriptor indexing, lowered to the device limit if needed
+		static constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+		//Table size without it, the array size in shader.frag compiled with -DFIXED_TEXTURE_ARRAY
+		static constexpr uint32_t FIXED_TEXTURE_CAPACITY = 16;
+
+		//Every slot samples through sampler, defaultTexture fills DEFAULT_TEXTURE and every cleared slot
+		DyneTextureRegistry(DyneDevice& device, VkSampler sampler, std::shared_ptr<DyneTexture> defaultTexture);
+
+		DyneTextureRegistry(const DyneTextureRegistry&) = delete;
+		DyneTextureRegistry& operator=(const DyneTextureRegistry&) = delete;
+
+		//Slot for texture, throws when the table is full
+		uint32_t add(std::shared_ptr<DyneTexture> texture);
+		//Points a slot at another texture, the objects using it pick it up without any change of their own
+		void replace(uint32_t index, std::shared_ptr<DyneTexture> texture);
+		//Frees a slot for reuse, frames in flight keep sampling the old texture until their copy is rewritten
+		void remove(uint32_t index);
+
+		//Writes the changes since this frame's copy was last flushed and returns it for binding.
+		//Call after beginFrame waited for the frame, before any draw that samples a changed slot is submitted
+		VkDescriptorSet flush(int frameIndex);
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+		uint32_t getCapacity() const { return capacity; }
+		const std::shared_ptr<DyneTexture>& getDefaultTexture() const { return defaultTexture; }
+		//Whether objects drawn together may sample different slots
+		bool isBindless() const { return bindless; }
+		//Variant of shader.frag declaring the table the way this device takes it
+		const char* getFragmentShader() const { return bindless ? "shaders/shader.frag.spv" : "shaders/shader_fixed_textures.frag.spv"; }
+
+	private:
+		//One copy of the table per frame in flight
+		struct FrameTable
+		{
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			//What each slot of this copy holds, kept alive until the slot is rewritten
+			std::vector<std::shared_ptr<DyneTexture>> written;
+			//Slots changed since the last flush, may repeat
+			std::vector<uint32_t> dirtySlots;
+		};
+
+		void markDirty(uint32_t index);
+
+		DyneDevice& _deviceRef;
+		VkSampler textureSampler;
+		bool bindless;
+		uint32_t capacity;
+
+		std::unique_ptr<DyneDescriptorPool> pool{};
+		std::unique_ptr<DyneDescriptorSetLayout> setLayout{};
+		std::vector<FrameTable> frameTables;
+
+		std::shared_ptr<DyneTexture> defaultTexture;
+		//Latest texture of every slot, null when free
+		std::vector<std::shared_ptr<DyneTexture>> textures;
+		std::vector<uint32_t> freeSlots;
+	};
+}
@@ -0,0 +1,611 @@
+#include "DyneUploadContext.hpp"
+
+// std headers
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace Dyne
+{
+
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    DyneUploadContext::DyneUploadContext(
+        DyneDevice &device,
+        VkQueue queue,
+        uint32_t queueFamilyIndex,
+        VkDeviceSize stagingCapacity)
+        : _deviceRef{device},
+        queue{queue},
+        queueFamilyIndex{queueFamilyIndex},
+        stagingCapacity{stagingCapacity}
+    {
+        graphicsCapable = (device.getQueueFamilyFlags(queueFamilyIndex) & VK_QUEUE_GRAPHICS_BIT) != 0;
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndex;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+
+        stagingBuffer = std::make_unique<DyneBuffer>(
+            device,
+            stagingCapacity,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        stagingBuffer->map();
+    }
+
+    DyneUploadContext::~DyneUploadContext()
+    {
+        //Whatever is still recording is submitted so nothing queued by callers is lost
+        wait(submit());
+
+        for (auto &batch : freeBatches)
+        {
+            vkDestroyFence(_deviceRef.device(), batch.fence, nullptr);
+        }
+        vkDestroyCommandPool(_deviceRef.device(), commandPool, nullptr);
+    }
+
+    void DyneUploadContext::beginBatch()
+    {
+        if (current.recording) return;
+
+        if (freeBatches.empty())
+        {
+            Batch batch{};
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(_deviceRef.device(), &allocInfo, &batch.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+
+            VkFenceCreateInfo fenceInfo = {};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+            if (vkCreateFence(_deviceRef.device(), &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create upload fence!");
+            }
+
+            freeBatches.push_back(std::move(batch));
+        }
+
+        current = std::move(freeBatches.back());
+        freeBatches.pop_back();
+        current.recording = true;
+
+        vkResetFences(_deviceRef.device(), 1, &current.fence);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(current.commandBuffer, &beginInfo);
+
+        //Writes into resources that earlier submissions may still be using must wait for them
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            current.commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+
+    VkCommandBuffer DyneUploadContext::getCommandBuffer()
+    {
+        beginBatch();
+        return current.commandBuffer;
+    }
+
+    bool DyneUploadContext::findRingTail(VkDeviceSize &tail) const
+    {
+        for (const auto &batch : inFlight)
+        {
+            if (batch.stagingBegin != INVALID_STAGING_OFFSET)
+            {
+                tail = batch.stagingBegin;
+                return true;
+            }
+        }
+
+        if (current.stagingBegin != INVALID_STAGING_OFFSET)
+        {
+            tail = current.stagingBegin;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool DyneUploadContext::tryAllocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset)
+    {
+        VkDeviceSize tail;
+        if (!findRingTail(tail))
+        {
+            //Nothing alive in the ring, start over at the front
+            ringHead = 0;
+            tail = 0;
+            if (size > stagingCapacity) return false;
+            offset = 0;
+        }
+        else if (ringHead > tail)
+        {
+            //Live data in [tail, head), free space at the end and before tail
+            VkDeviceSize aligned = alignUp(ringHead, alignment);
+            if (aligned + size <= stagingCapacity)
+            {
+                offset = aligned;
+            }
+            else if (size <= tail)
+            {
+                offset = 0;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (ringHead < tail)
+        {
+            //Wrapped, free space is [head, tail)
+            VkDeviceSize aligned = alignUp(ringHead, alignment);
+            if (aligned + size > tail) return false;
+            offset = aligned;
+        }
+        else
+        {
+            //head == tail with live data means the ring is full
+            return false;
+        }
+
+        if (current.stagingBegin == INVALID_STAGING_OFFSET)
+        {
+            current.stagingBegin = offset;
+        }
+        ringHead = offset + size;
+        return true;
+    }
+
+    DyneUploadContext::StagingRegion DyneUploadContext::allocateOverflow(VkDeviceSize size)
+    {
+        auto overflowBuffer = std::make_unique<DyneBuffer>(
+            _deviceRef,
+            size,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        overflowBuffer->map();
+
+        StagingRegion region{};
+        region.data = overflowBuffer->getMappedMemory();
+        region.buffer = overflowBuffer->getBuffer();
+        region.offset = 0;
+        current.overflowBuffers.push_back(std::move(overflowBuffer));
+        return region;
+    }
+
+    DyneUploadContext::StagingRegion DyneUploadContext::allocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+    {
+        assert(size > 0 && "Cannot stage zero bytes!");
+        beginBatch();
+
+        if (size > stagingCapacity)
+        {
+            return allocateOverflow(size);
+        }
+
+        //Out of ring space: push the current batch out and recycle the oldest ones.
+        //Regions returned earlier must already have their copies recorded at this point
+        VkDeviceSize offset;
+        while (!tryAllocateRing(size, alignment, offset))
+        {
+            if (current.stagingBegin != INVALID_STAGING_OFFSET)
+            {
+                submit();
+                beginBatch();
+            }
+            else
+            {
+                assert(!inFlight.empty() && "Staging ring exhausted with nothing in flight!");
+                waitForOldest();
+            }
+        }
+
+        StagingRegion region{};
+        region.data = static_cast<char *>(stagingBuffer->getMappedMemory()) + offset;
+        region.buffer = stagingBuffer->getBuffer();
+        region.offset = offset;
+        return region;
+    }
+
+    bool DyneUploadContext::tryAllocateStaging(VkDeviceSize size, VkDeviceSize alignment, StagingRegion &region)
+    {
+        assert(size > 0 && "Cannot stage zero bytes!");
+        beginBatch();
+
+        if (size > stagingCapacity)
+        {
+            region = allocateOverflow(size);
+            return true;
+        }
+
+        //Only batches the GPU already finished give their space back
+        retireCompleted();
+        VkDeviceSize offset;
+        if (!tryAllocateRing(size, alignment, offset)) return false;
+
+        region.data = static_cast<char *>(stagingBuffer->getMappedMemory()) + offset;
+        region.buffer = stagingBuffer->getBuffer();
+        region.offset = offset;
+        return true;
+    }
+
+    void DyneUploadContext::uploadBuffer(VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset)
+    {
+        StagingRegion region = allocateStaging(size);
+        memcpy(region.data, data, static_cast<size_t>(size));
+        copyBuffer(region.buffer, dstBuffer, size, region.offset, dstOffset);
+    }
+
+    void DyneUploadContext::uploadImage(
+        VkImage image,
+        const void *data,
+        VkDeviceSize size,
+        VkExtent3D extent,
+        uint32_t mipLevel,
+        uint32_t baseArrayLayer,
+        uint32_t layerCount)
+    {
+        //bufferOffset must be a multiple of the texel block size, 16 covers every format we use
+        StagingRegion region = allocateStaging(size, 16);
+        memcpy(region.data, data, static_cast<size_t>(size));
+        copyBufferToImage(region.buffer, region.offset, image, extent, mipLevel, baseArrayLayer, layerCount);
+    }
+
+    void DyneUploadContext::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
+    {
+        beginBatch();
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(current.commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+    }
+
+    void DyneUploadContext::copyBufferToImage(
+        VkBuffer buffer,
+        VkDeviceSize bufferOffset,
+        VkImage image,
+        VkExtent3D extent,
+        uint32_t mipLevel,
+        uint32_t baseArrayLayer,
+        uint32_t layerCount)
+    {
+        beginBatch();
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = bufferOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = mipLevel;
+        region.imageSubresource.baseArrayLayer = baseArrayLayer;
+        region.imageSubresource.layerCount = layerCount;
+
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = extent;
+
+        vkCmdCopyBufferToImage(
+            current.commandBuffer,
+            buffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region);
+    }
+
+    void DyneUploadContext::transitionImageLayout(
+        VkImage image,
+        VkImageLayout oldLayout,
+        VkImageLayout newLayout,
+        uint32_t baseMipLevel,
+        uint32_t levelCount,
+        VkImageAspectFlags aspectMask)
+    {
+        beginBatch();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = aspectMask;
+        barrier.subresourceRange.baseMipLevel = baseMipLevel;
+        barrier.subresourceRange.levelCount = levelCount;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        //Transfer queues can't name shader stages, the trailing batch barrier covers them instead
+        VkPipelineStageFlags shaderStage = graphicsCapable ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+        VkPipelineStageFlags sourceStage;
+        VkPipelineStageFlags destinationStage;
+
+        if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+        else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = graphicsCapable ? VK_ACCESS_SHADER_READ_BIT : 0;
+
+            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            destinationStage = shaderStage;
+        }
+        else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+        else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = graphicsCapable ? VK_ACCESS_SHADER_READ_BIT : 0;
+
+            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            destinationStage = shaderStage;
+        }
+        else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            barrier.srcAccessMask = graphicsCapable ? VK_ACCESS_SHADER_READ_BIT : 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            sourceStage = graphicsCapable ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+        else {
+            throw std::invalid_argument("unsupported layout transition!");
+        }
+
+        vkCmdPipelineBarrier(
+            current.commandBuffer,
+            sourceStage, destinationStage,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier
+        );
+    }
+
+    void DyneUploadContext::generateMipmaps(VkImage image, VkExtent2D extent, uint32_t mipLevels)
+    {
+        assert(graphicsCapable && "Blits need a graphics capable queue!");
+        beginBatch();
+
+        int32_t width = static_cast<int32_t>(extent.width);
+        int32_t height = static_cast<int32_t>(extent.height);
+        for (uint32_t level = 1; level < mipLevels; level++)
+        {
+            int32_t levelWidth = width > 1 ? width / 2 : 1;
+            int32_t levelHeight = height > 1 ? height / 2 : 1;
+
+            transitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, level - 1, 1);
+
+            VkImageBlit blit{};
+            blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+            blit.srcOffsets[1] = { width, height, 1 };
+            blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+            blit.dstOffsets[1] = { levelWidth, levelHeight, 1 };
+            vkCmdBlitImage(
+                current.commandBuffer,
+                image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &blit,
+                VK_FILTER_LINEAR);
+
+            //The source level is final once the blit has read it
+            transitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, level - 1, 1);
+
+            width = levelWidth;
+            height = levelHeight;
+        }
+
+        transitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels - 1, 1);
+    }
+
+    void DyneUploadContext::releaseImageOwnership(
+        VkImage image,
+        VkImageLayout oldLayout,
+        VkImageLayout newLayout,
+        uint32_t dstQueueFamilyIndex,
+        uint32_t levelCount)
+    {
+        if (dstQueueFamilyIndex == queueFamilyIndex)
+        {
+            //The trailing batch barrier already makes the writes visible
+            if (oldLayout != newLayout) transitionImageLayout(image, oldLayout, newLayout, 0, levelCount);
+            return;
+        }
+
+        beginBatch();
+
+        //Only the source access matters here, the acquiring queue makes the writes visible
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = queueFamilyIndex;
+        barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+        barrier.image = image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+
+        vkCmdPipelineBarrier(
+            current.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+    }
+
+    void DyneUploadContext::acquireImageOwnership(
+        VkImage image,
+        VkImageLayout oldLayout,
+        VkImageLayout newLayout,
+        uint32_t srcQueueFamilyIndex,
+        uint32_t levelCount)
+    {
+        if (srcQueueFamilyIndex == queueFamilyIndex) return;
+
+        beginBatch();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+        barrier.dstQueueFamilyIndex = queueFamilyIndex;
+        barrier.image = image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+        barrier.srcAccessMask = 0;
+
+        //Images still written here, like levels waiting for mip generation, are acquired for transfers
+        VkPipelineStageFlags destinationStage;
+        if (newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL || !graphicsCapable)
+        {
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+        else
+        {
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        }
+
+        vkCmdPipelineBarrier(
+            current.commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            destinationStage,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+    }
+
+    DyneUploadTicket DyneUploadContext::submit()
+    {
+        if (!current.recording)
+        {
+            return nextTicket - 1;
+        }
+
+        //Make the transfers visible to whatever is submitted after this batch
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            current.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+
+        if (vkEndCommandBuffer(current.commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record upload command buffer!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &current.commandBuffer;
+
+        if (vkQueueSubmit(queue, 1, &submitInfo, current.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit upload batch!");
+        }
+
+        current.ticket = nextTicket++;
+        current.recording = false;
+        DyneUploadTicket ticket = current.ticket;
+
+        inFlight.push_back(std::move(current));
+        current = Batch{};
+        return ticket;
+    }
+
+    void DyneUploadContext::retireOldest()
+    {
+        Batch batch = std::move(inFlight.front());
+        inFlight.pop_front();
+
+        completedTicket = batch.ticket;
+        batch.ticket = 0;
+        batch.stagingBegin = INVALID_STAGING_OFFSET;
+        batch.overflowBuffers.clear();
+        freeBatches.push_back(std::move(batch));
+    }
+
+    void DyneUploadContext::retireCompleted()
+    {
+        //Batches retire in submission order so the ring tail only ever moves forward
+        while (!inFlight.empty() && vkGetFenceStatus(_deviceRef.device(), inFlight.front().fence) == VK_SUCCESS)
+        {
+            retireOldest();
+        }
+    }
+
+    void DyneUploadContext::waitForOldest()
+    {
+        vkWaitForFences(_deviceRef.device(), 1, &inFlight.front().fence, VK_TRUE, UINT64_MAX);
+        retireOldest();
+    }
+
+    bool DyneUploadContext::isComplete(DyneUploadTicket ticket)
+    {
+        retireCompleted();
+        return ticket <= completedTicket;
+    }
+
+    void DyneUploadContext::wait(DyneUploadTicket ticket)
+    {
+        assert(ticket < nextTicket && "Waiting on a ticket that was never submitted!");
+
+        while (completedTicket < ticket && !inFlight.empty())
+        {
+            waitForOldest();
+        }
+    }
+
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "DyneDevice.hpp"
+#include "DyneBuffer.hpp"
+
+// std lib headers
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace Dyne
+{
+
+    // Identifies one submitted upload batch, 0 means "nothing to wait for"
+    using DyneUploadTicket = uint64_t;
+
+    // Records any number of copies & layout transitions into one command buffer and submits them
+    // together with a fence. Staging memory comes from a persistently mapped ring buffer that is
+    // recycled as batches complete. Not thread safe, use from one thread at a time.
+    class DyneUploadContext
+    {
+    public:
+        static constexpr VkDeviceSize DEFAULT_STAGING_CAPACITY = 64ull * 1024 * 1024;
+
+        struct StagingRegion
+        {
+            void *data = nullptr;
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkDeviceSize offset = 0;
+        };
+
+        DyneUploadContext(
+            DyneDevice &device,
+            VkQueue queue,
+            uint32_t queueFamilyIndex,
+            VkDeviceSize stagingCapacity = DEFAULT_STAGING_CAPACITY);
+        ~DyneUploadContext();
+
+        DyneUploadContext(const DyneUploadContext &) = delete;
+        DyneUploadContext &operator=(const DyneUploadContext &) = delete;
+
+        // Staging space owned by the current batch, valid until its ticket completes
+        StagingRegion allocateStaging(VkDeviceSize size, VkDeviceSize alignment = 16);
+        // Returns false rather than submitting the current batch or waiting when the ring is full. Copies from the
+        // region may be recorded before it is written, e.g. by a worker thread, as long as nothing submits the
+        // batch or calls allocateStaging until then
+        bool tryAllocateStaging(VkDeviceSize size, VkDeviceSize alignment, StagingRegion &region);
+
+        void uploadBuffer(VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+        void uploadImage(
+            VkImage image,
+            const void *data,
+            VkDeviceSize size,
+            VkExtent3D extent,
+            uint32_t mipLevel = 0,
+            uint32_t baseArrayLayer = 0,
+            uint32_t layerCount = 1);
+
+        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+        void copyBufferToImage(
+            VkBuffer buffer,
+            VkDeviceSize bufferOffset,
+            VkImage image,
+            VkExtent3D extent,
+            uint32_t mipLevel = 0,
+            uint32_t baseArrayLayer = 0,
+            uint32_t layerCount = 1);
+        void transitionImageLayout(
+            VkImage image,
+            VkImageLayout oldLayout,
+            VkImageLayout newLayout,
+            uint32_t baseMipLevel = 0,
+            uint32_t levelCount = 1,
+            VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
+
+        // Fills levels 1..mipLevels-1 by blitting each from the one above with linear filtering. Needs a graphics
+        // capable queue and an image in TRANSFER_DST_OPTIMAL with level 0 written, leaves every level in
+        // SHADER_READ_ONLY_OPTIMAL.
+        void generateMipmaps(VkImage image, VkExtent2D extent, uint32_t mipLevels);
+
+        // Queue family ownership transfer of an exclusive image, both halves must name the same layouts.
+        // When the families match release is a plain layout transition and acquire does nothing.
+        void releaseImageOwnership(
+            VkImage image,
+            VkImageLayout oldLayout,
+            VkImageLayout newLayout,
+            uint32_t dstQueueFamilyIndex,
+            uint32_t levelCount = 1);
+        void acquireImageOwnership(
+            VkImage image,
+            VkImageLayout oldLayout,
+            VkImageLayout newLayout,
+            uint32_t srcQueueFamilyIndex,
+            uint32_t levelCount = 1);
+
+        // For anything not covered above, recorded into the current batch
+        VkCommandBuffer getCommandBuffer();
+
+        // Submits the current batch, returns the last ticket again when nothing was recorded
+        DyneUploadTicket submit();
+        bool isComplete(DyneUploadTicket ticket);
+        void wait(DyneUploadTicket ticket);
+        void submitAndWait() { wait(submit()); }
+
+        uint32_t getQueueFamilyIndex() const { return queueFamilyIndex; }
+        bool isGraphicsCapable() const { return graphicsCapable; }
+
+    private:
+        static constexpr VkDeviceSize INVALID_STAGING_OFFSET = ~0ull;
+
+        struct Batch
+        {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            DyneUploadTicket ticket = 0;
+            bool recording = false;
+
+            // first ring offset used by this batch, everything after it up to the next batch is in use
+            VkDeviceSize stagingBegin = INVALID_STAGING_OFFSET;
+
+            // uploads larger than the ring get their own buffer for the batch's lifetime
+            std::vector<std::unique_ptr<DyneBuffer>> overflowBuffers;
+        };
+
+        void beginBatch();
+        StagingRegion allocateOverflow(VkDeviceSize size);
+        bool tryAllocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+        bool findRingTail(VkDeviceSize &tail) const;
+        void retireCompleted();
+        void waitForOldest();
+        void retireOldest();
+
+        DyneDevice &_deviceRef;
+        VkQueue queue;
+        uint32_t queueFamilyIndex;
+        bool graphicsCapable;
+        VkCommandPool commandPool;
+
+        std::unique_ptr<DyneBuffer> stagingBuffer;
+        VkDeviceSize stagingCapacity;
+        VkDeviceSize ringHead = 0;
+
+        Batch current{};
+        std::deque<Batch> inFlight;
+        std::vector<Batch> freeBatches;
+
+        DyneUploadTicket nextTicket = 1;
+        DyneUploadTicket completedTicket = 0;
+    };
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Dyne
+{
+	// Vertex layouts a geometry pool can store. Models are loaded as FullVertex and packed on upload
+	enum class VertexFormat : uint8_t
+	{
+		Full,			//Float position, color, normal & uv, 44 bytes
+		Packed,			//Half position, octahedral snorm16 normal, half uv, 16 bytes. No color, the shader uses white
+		PackedColor		//Packed plus an unorm8 rgba color, 20 bytes
+	};
+	constexpr uint32_t VERTEX_FORMAT_COUNT = 3;
+
+	struct FullVertex
+	{
+		glm::vec3 position{};
+		glm::vec3 color{};
+		glm::vec3 normal{};
+		glm::vec2 uv{};
+
+		bool operator==(const FullVertex& other) const
+		{
+			return
+				position == other.position &&
+				color == other.color &&
+				normal == other.normal &&
+				uv == other.uv;
+		}
+	};
+
+	struct PackedVertex
+	{
+		//Model space halfs, w is padding since 3 component 16 bit formats are optional for vertex buffers
+		uint16_t position[4];
+		int16_t normal[2];
+		uint16_t uv[2];
+	};
+
+	struct PackedColorVertex
+	{
+		uint16_t position[4];
+		int16_t normal[2];
+		uint16_t uv[2];
+		uint8_t color[4];
+	};
+
+	// Compile time description of each format: its vertex type, attributes & vertex shader.
+	// The attribute locations match the shader inputs, 0 position, 1 color, 2 normal, 3 uv.
+	template<VertexFormat Format>
+	struct VertexLayout;
+
+	template<>
+	struct VertexLayout<VertexFormat::Full>
+	{
+		using Type = FullVertex;
+		static constexpr const char* vertexShader = "shaders/shader.vert.spv";
+		static constexpr std::array<VkVertexInputAttributeDescription, 4> attributes
+		{{
+			{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(FullVertex, position) },
+			{ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(FullVertex, color) },
+			{ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(FullVertex, normal) },
+			{ 3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(FullVertex, uv) },
+		}};
+	};
+
+	template<>
+	struct VertexLayout<VertexFormat::Packed>
+	{
+		using Type = PackedVertex;
+		static constexpr const char* vertexShader = "shaders/shader_packed.vert.spv";
+		static constexpr std::array<VkVertexInputAttributeDescription, 3> attributes
+		{{
+			{ 0, 0, VK_FORMAT_R16G16B16A16_SFLOAT, offsetof(PackedVertex, position) },
+			{ 2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal) },
+			{ 3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv) },
+		}};
+	};
+
+	template<>
+	struct VertexLayout<VertexFormat::PackedColor>
+	{
+		using Type = PackedColorVertex;
+		static constexpr const char* vertexShader = "shaders/shader_packed_color.vert.spv";
+		static constexpr std::array<VkVertexInputAttributeDescription, 4> attributes
+		{{
+			{ 0, 0, VK_FORMAT_R16G16B16A16_SFLOAT, offsetof(PackedColorVertex, position) },
+			{ 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedColorVertex, color) },
+			{ 2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedColorVertex, normal) },
+			{ 3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedColorVertex, uv) },
+		}};
+	};
+
+	// A format's layout flattened for runtime selection, the arrays live in the layouts
+	struct VertexFormatInfo
+	{
+		VkVertexInputBindingDescription binding;
+		const VkVertexInputAttributeDescription* attributes;
+		uint32_t attributeCount;
+		const char* vertexShader;
+	};
+
+	template<VertexFormat Format>
+	constexpr VertexFormatInfo makeVertexFormatInfo()
+	{
+		using Layout = VertexLayout<Format>;
+		return VertexFormatInfo
+		{
+			{ 0, static_cast<uint32_t>(sizeof(typename Layout::Type)), VK_VERTEX_INPUT_RATE_VERTEX },
+			Layout::attributes.data(),
+			static_cast<uint32_t>(Layout::attributes.size()),
+			Layout::vertexShader
+		};
+	}
+
+	constexpr std::array<VertexFormatInfo, VERTEX_FORMAT_COUNT> VERTEX_FORMAT_INFOS
+	{{
+		makeVertexFormatInfo<VertexFormat::Full>(),
+		makeVertexFormatInfo<VertexFormat::Packed>(),
+		makeVertexFormatInfo<VertexFormat::PackedColor>(),
+	}};
+
+	constexpr const VertexFormatInfo& getVertexFormatInfo(VertexFormat format)
+	{
+		return VERTEX_FORMAT_INFOS[static_cast<uint32_t>(format)];
+	}
+
+	static_assert(sizeof(FullVertex) == 44, "FullVertex must stay tightly packed!");
+	static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay tightly packed!");
+	static_assert(sizeof(PackedColorVertex) == 20, "PackedColorVertex must stay tightly packed!");
+
+	// Byte wise hash & equality for deduplicating packed vertices. Only valid for types without padding,
+	// checked at compile time, so equal bytes always mean equal vertices.
+	template<typename T>
+	struct PackedVertexHash
+	{
+		static_assert(std::has_unique_object_representations_v<T>, "Packed vertices must not contain padding!");
+
+		size_t operator()(const T& vertex) const
+		{
+			//FNV-1a
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < sizeof(T); i++)
+			{
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	template<typename T>
+	struct PackedVertexEqual
+	{
+		bool operator()(const T& a, const T& b) const { return std::memcmp(&a, &b, sizeof(T)) == 0; }
+	};
+}
\ No newline at end of file